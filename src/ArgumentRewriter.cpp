@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ArgumentRewriter.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace {
+
+struct Rule {
+public:
+    const char *Pattern;
+    unsigned int Values;
+};
+
+/*
+ * Arguments only affecting code generation, assembling or linking. They
+ * have no effect on preprocessing or semantic analysis of a translation
+ * unit. Optimization levels are kept as they define "__OPTIMIZE__", which
+ * selects inline definitions within system headers. Sanitizers define
+ * macros like "__SANITIZE_ADDRESS__" and change the results of
+ * "__has_feature", profile options may define macros and frontend plugins
+ * may add attributes or pragmas, so all of them are kept.
+ */
+const Rule CodeGenerationRules[] = {
+    /* Debug information */
+    {"-g", 0},
+    {"-g[0-3]", 0},
+    {"-gcolumn-info", 0},
+    {"-gdwarf*", 0},
+    {"-ggdb*", 0},
+    {"-gline-*", 0},
+    {"-gno-*", 0},
+    {"-gsplit-dwarf*", 0},
+    {"-gz*", 0},
+    {"-fdebug-prefix-map=*", 0},
+    /* Link time optimization */
+    {"-flto*", 0},
+    {"-fno-lto", 0},
+    {"-fwhole-program-vtables", 0},
+    /* Coverage instrumentation */
+    {"--coverage", 0},
+    {"-fcoverage-compilation-dir=*", 0},
+    {"-fcoverage-mapping", 0},
+    {"-fcoverage-prefix-map=*", 0},
+    {"-fno-coverage-mapping", 0},
+    {"-fno-profile-arcs", 0},
+    {"-fno-test-coverage", 0},
+    {"-fprofile-arcs", 0},
+    {"-ftest-coverage", 0},
+    /* Plugins of the code generator */
+    {"-fpass-plugin=*", 0},
+    /* Assembling and linking */
+    {"-L", 1},
+    {"-L?*", 0},
+    {"-Wa,*", 0},
+    {"-Wl,*", 0},
+    {"-Xassembler", 1},
+    {"-Xlinker", 1},
+    {"-l", 1},
+    {"-l?*", 0},
+    {"-pipe", 0},
+    {"-save-temps*", 0},
+};
+
+/* Warnings turned into errors only make parsing fail */
+const Rule WarningRules[] = {
+    {"-Werror", 0},
+    {"-Werror=*", 0},
+    {"-Wfatal-errors", 0},
+    {"-pedantic-errors", 0},
+};
+
+} /* namespace */
+
+const ArgumentRewriter &ArgumentRewriter::getCodeGenerationProfile()
+{
+    static const auto Profile = []() {
+        auto Rewriter = ArgumentRewriter();
+
+        for (const auto &Item : CodeGenerationRules)
+            llvm::cantFail(Rewriter.add(Item.Pattern, Item.Values));
+
+        return Rewriter;
+    }();
+
+    return Profile;
+}
+
+const ArgumentRewriter &ArgumentRewriter::getSyntaxOnlyProfile()
+{
+    static const auto Profile = []() {
+        auto Rewriter = getCodeGenerationProfile();
+
+        for (const auto &Item : WarningRules)
+            llvm::cantFail(Rewriter.add(Item.Pattern, Item.Values));
+
+        return Rewriter;
+    }();
+
+    return Profile;
+}
+
+llvm::Error ArgumentRewriter::add(llvm::StringRef Rule, unsigned int Values)
+{
+    if (Matchers_.size() <= Values)
+        Matchers_.resize(Values + 1);
+
+    return Matchers_[Values].add(Rule);
+}
+
+std::vector<std::string>
+ArgumentRewriter::rewrite(llvm::ArrayRef<std::string> Args,
+                          std::vector<Removal> *Removals) const
+{
+    /*
+     * Example with the rules "-g*" and "-Xlinker" (one value):
+     *      cc -g3 -c a.c -Xlinker -z -O2 -> cc -c a.c -O2
+     */
+    auto Result = std::vector<std::string>();
+    if (Args.empty())
+        return Result;
+
+    Result.reserve(Args.size());
+    Result.push_back(Args.front());
+
+    for (size_t i = 1, Size = Args.size(); i < Size; ++i) {
+        const auto &Arg = Args[i];
+
+        /* Everything following "--" is an input file */
+        if (Arg == "--") {
+            Result.insert(Result.end(), Args.begin() + i, Args.end());
+            break;
+        }
+
+        std::optional<llvm::StringRef> Match;
+        size_t Values = 0;
+
+        for (size_t j = 0, Count = Matchers_.size(); j < Count && !Match; ++j) {
+            Match = Matchers_[j].match(Arg);
+            Values = j;
+        }
+
+        if (!Match) {
+            Result.push_back(Arg);
+            continue;
+        }
+
+        auto End = std::min(i + 1 + Values, Size);
+
+        if (Removals) {
+            auto Item = Removal();
+            Item.Arguments.assign(Args.begin() + i, Args.begin() + End);
+            Item.Rule = Match->str();
+
+            Removals->push_back(std::move(Item));
+        }
+
+        i = End - 1;
+    }
+
+    return Result;
+}
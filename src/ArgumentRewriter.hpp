@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARGUMENT_REWRITER_HPP_
+#define ARGUMENT_REWRITER_HPP_
+
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+
+#include "util/Glob.hpp"
+
+/*
+ * Removes command-line arguments matching a set of rules. Rules are either
+ * exact arguments or glob patterns and can consume a number of separate
+ * values following the matched argument. All rules are compiled once and
+ * can be applied to any number of command-lines concurrently. The code
+ * generation profile only removes arguments without any effect on the
+ * parsed AST, the syntax-only profile additionally removes arguments
+ * turning warnings into errors.
+ */
+
+class ArgumentRewriter {
+public:
+    struct Removal {
+    public:
+        std::vector<std::string> Arguments;
+        std::string Rule;
+    };
+
+    ArgumentRewriter() = default;
+
+    static const ArgumentRewriter &getCodeGenerationProfile();
+    static const ArgumentRewriter &getSyntaxOnlyProfile();
+
+    llvm::Error add(llvm::StringRef Rule, unsigned int Values = 0);
+
+    std::vector<std::string>
+    rewrite(llvm::ArrayRef<std::string> Args,
+            std::vector<Removal> *Removals = nullptr) const;
+
+private:
+    /* Rules grouped by the number of values they consume */
+    std::vector<util::glob::Matcher> Matchers_;
+};
+
+#endif /* ARGUMENT_REWRITER_HPP_ */
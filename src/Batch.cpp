@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Batch.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include <llvm/ADT/StringSet.h>
+#include <llvm/ADT/StringSwitch.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
+#include "util/Glob.hpp"
+
+namespace {
+
+std::optional<enum Config::Backend> parseBackend(llvm::StringRef Name)
+{
+    using Result = std::optional<enum Config::Backend>;
+
+    return llvm::StringSwitch<Result>(Name)
+        .Case("gmock", Config::BACKEND_GMOCK)
+        .Case("fff", Config::BACKEND_FFF)
+        .Case("cmocka", Config::BACKEND_CMOCKA)
+        .Case("raw", Config::BACKEND_RAW)
+        .Default(std::nullopt);
+}
+
+llvm::StringRef getBackendName(enum Config::Backend Backend)
+{
+    switch (Backend) {
+    case Config::BACKEND_GMOCK:
+        return "gmock";
+    case Config::BACKEND_FFF:
+        return "fff";
+    case Config::BACKEND_CMOCKA:
+        return "cmocka";
+    case Config::BACKEND_RAW:
+        return "raw";
+    default:
+        llvm_unreachable("invalid backend");
+        break;
+    }
+
+    return llvm::StringRef();
+}
+
+std::filesystem::path makeBaseDirectory(const Config &Config,
+                                        std::error_code &Code)
+{
+    auto Path = std::filesystem::absolute(Config.General.BaseDirectory, Code);
+
+    return Path.lexically_normal();
+}
+
+bool isSubPath(const std::filesystem::path &Path)
+{
+    return !Path.empty() && *Path.begin() != "..";
+}
+
+std::filesystem::path makeOutputPath(const std::filesystem::path &Input,
+                                     const std::filesystem::path &Base,
+                                     const std::filesystem::path &Directory)
+{
+    /*
+     * Mirror the layout of the source tree within the output directory.
+     * Files outside of the base directory would escape the output
+     * directory, so use their full path instead.
+     *
+     * Example:
+     *      <base>/src/util/list.c -> <directory>/src/util/list.inc
+     *      /usr/src/lib/file.c    -> <directory>/usr/src/lib/file.inc
+     */
+    auto Path = Input.lexically_relative(Base);
+    if (!isSubPath(Path))
+        Path = Input.relative_path();
+
+    Path.replace_extension(".inc");
+
+    return Directory / Path;
+}
+
+} // namespace
+
+void Batch::load(const std::filesystem::path &Path, std::string &Error)
+{
+    /*
+     * Example of a job manifest:
+     *      [
+     *          { "input": "src/a.c", "output": "mocks/a.inc" },
+     *          { "input": "src/b.c", "backend": "fff" }
+     *      ]
+     */
+    llvm::raw_string_ostream OS(Error);
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Path.native());
+    if (!MemBuffer) {
+        OS << "failed to open \"" << Path.native()
+           << "\": " << MemBuffer.getError().message();
+        return;
+    }
+
+    auto Value = llvm::json::parse(MemBuffer.get()->getBuffer());
+    if (!Value) {
+        OS << "failed to parse \"" << Path.native()
+           << "\": " << llvm::toString(Value.takeError());
+        return;
+    }
+
+    const auto *Array = Value->getAsArray();
+    if (!Array) {
+        OS << "\"" << Path.native() << "\": expected an array of jobs";
+        return;
+    }
+
+    Jobs_.reserve(Jobs_.size() + Array->size());
+
+    for (size_t i = 0, Size = Array->size(); i < Size; ++i) {
+        const auto *Object = (*Array)[i].getAsObject();
+        if (!Object) {
+            OS << "\"" << Path.native() << "\": job " << i
+               << ": expected an object";
+            return;
+        }
+
+        auto Input = Object->getString("input");
+        if (!Input) {
+            OS << "\"" << Path.native() << "\": job " << i
+               << ": missing \"input\"";
+            return;
+        }
+
+        auto Item = Job();
+        Item.Input = Input->str();
+
+        if (auto Output = Object->getString("output"))
+            Item.Output = Output->str();
+
+        if (auto Name = Object->getString("backend")) {
+            Item.Backend = parseBackend(*Name);
+            if (!Item.Backend) {
+                OS << "\"" << Path.native() << "\": job " << i
+                   << ": invalid backend \"" << *Name << "\"";
+                return;
+            }
+        }
+
+        Jobs_.push_back(std::move(Item));
+    }
+}
+
+void Batch::select(llvm::ArrayRef<std::string> Files,
+                   const Config &Config,
+                   std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+    util::glob::Matcher Include, Exclude;
+    std::error_code Code;
+
+    for (const auto &Pattern : Config.General.Include) {
+        if (auto Err = Include.add(Pattern)) {
+            OS << "invalid include pattern \"" << Pattern
+               << "\": " << llvm::toString(std::move(Err));
+            return;
+        }
+    }
+
+    for (const auto &Pattern : Config.General.Exclude) {
+        if (auto Err = Exclude.add(Pattern)) {
+            OS << "invalid exclude pattern \"" << Pattern
+               << "\": " << llvm::toString(std::move(Err));
+            return;
+        }
+    }
+
+    auto Base = makeBaseDirectory(Config, Code);
+    if (Code) {
+        OS << "\"" << Config.General.BaseDirectory.native()
+           << "\": " << Code.message();
+        return;
+    }
+
+    /* Files which are already part of the batch are not added again */
+    llvm::StringSet<> Inputs;
+    for (const auto &Item : Jobs_) {
+        auto Path = std::filesystem::absolute(Item.Input, Code);
+        if (!Code)
+            Inputs.insert(Path.lexically_normal().native());
+    }
+
+    auto Selection = std::vector<std::filesystem::path>();
+    Selection.reserve(Files.size());
+
+    for (const auto &File : Files) {
+        auto Path = std::filesystem::absolute(File, Code);
+        if (Code) {
+            OS << "\"" << File << "\": " << Code.message();
+            return;
+        }
+
+        Path = Path.lexically_normal();
+
+        /*
+         * Patterns match either the path relative to the base directory
+         * or the absolute path of a file.
+         *
+         * Example:
+         *      --include='src*' matches "<base>/src/util/list.c"
+         *      --exclude='*.S'  matches "/usr/src/lib/entry.S"
+         */
+        auto Relative = Path.lexically_relative(Base);
+        if (!isSubPath(Relative))
+            Relative.clear();
+
+        auto Match = [&](const util::glob::Matcher &Matcher) {
+            if (Matcher.match(Path.native()))
+                return true;
+
+            return !Relative.empty() && Matcher.match(Relative.native());
+        };
+
+        if (!Include.empty() && !Match(Include))
+            continue;
+
+        if (Match(Exclude) || Inputs.count(Path.native()))
+            continue;
+
+        Selection.push_back(std::move(Path));
+    }
+
+    /*
+     * The order of the files reported by a compilation database is not
+     * specified, so sort them to get the same batch for every run.
+     */
+    llvm::sort(Selection);
+
+    Jobs_.reserve(Jobs_.size() + Selection.size());
+
+    for (auto &Path : Selection) {
+        auto Item = Job();
+        Item.Input = std::move(Path);
+
+        Jobs_.push_back(std::move(Item));
+    }
+}
+
+void Batch::resolve(const Config &Config, std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+    llvm::StringSet<> Outputs;
+    std::error_code Code;
+
+    const auto &Directory = Config.General.OutputDirectory;
+
+    auto Base = makeBaseDirectory(Config, Code);
+    if (Code) {
+        OS << "\"" << Config.General.BaseDirectory.native()
+           << "\": " << Code.message();
+        return;
+    }
+
+    for (auto &Item : Jobs_) {
+        /*
+         * The ClangTool changes the working directory according to the
+         * compile command of each processed file. Only absolute paths
+         * are guaranteed to refer to the files the user specified.
+         */
+        Item.Input = std::filesystem::absolute(Item.Input, Code);
+        if (Code) {
+            OS << "\"" << Item.Input.native() << "\": " << Code.message();
+            return;
+        }
+
+        Item.Input = Item.Input.lexically_normal();
+
+        if (Item.Output.empty() && !Directory.empty())
+            Item.Output = makeOutputPath(Item.Input, Base, Directory);
+
+        if (Item.Output.empty())
+            continue;
+
+        Item.Output = std::filesystem::absolute(Item.Output, Code);
+        if (Code) {
+            OS << "\"" << Item.Output.native() << "\": " << Code.message();
+            return;
+        }
+
+        Item.Output = Item.Output.lexically_normal();
+
+        if (!Outputs.insert(Item.Output.native()).second) {
+            OS << "multiple jobs write to \"" << Item.Output.native() << "\"";
+            return;
+        }
+    }
+}
+
+void Batch::shard(unsigned int Index,
+                  unsigned int Count,
+                  llvm::ArrayRef<double> Costs)
+{
+    auto Order = std::vector<size_t>(Jobs_.size());
+    std::iota(Order.begin(), Order.end(), 0);
+
+    /*
+     * Every shard has to compute exactly the same partition without any
+     * communication. Ties are therefore broken by the input path which
+     * does not depend on the order of the jobs.
+     */
+    llvm::sort(Order, [&](size_t A, size_t B) {
+        if (Costs[A] != Costs[B])
+            return Costs[A] > Costs[B];
+
+        return Jobs_[A].Input < Jobs_[B].Input;
+    });
+
+    /*
+     * Greedily assign the most expensive remaining job to the shard with
+     * the least total cost so far (longest processing time first).
+     */
+    auto Loads = std::vector<double>(Count, 0.0);
+    auto Keep = std::vector<bool>(Jobs_.size(), false);
+
+    for (auto Item : Order) {
+        auto It = std::min_element(Loads.begin(), Loads.end());
+
+        *It += Costs[Item];
+
+        if (static_cast<unsigned int>(It - Loads.begin()) == Index)
+            Keep[Item] = true;
+    }
+
+    /* Keep the original order of the jobs within the shard */
+    auto Jobs = std::vector<Job>();
+    Jobs.reserve(Jobs_.size() / Count + 1);
+
+    for (size_t i = 0, Size = Jobs_.size(); i < Size; ++i) {
+        if (Keep[i])
+            Jobs.push_back(std::move(Jobs_[i]));
+    }
+
+    Jobs_ = std::move(Jobs);
+}
+
+void Batch::save(const std::filesystem::path &Path,
+                 const Config &Config,
+                 std::string &Error) const
+{
+    llvm::raw_string_ostream OS(Error);
+    std::error_code Code;
+
+    auto Directory = llvm::sys::path::parent_path(Path.native());
+    if (!Directory.empty()) {
+        Code = llvm::sys::fs::create_directories(Directory);
+        if (Code) {
+            OS << "failed to create \"" << Directory
+               << "\": " << Code.message();
+            return;
+        }
+    }
+
+    auto Out = llvm::raw_fd_ostream(Path.native(), Code);
+    if (Code) {
+        OS << "failed to open \"" << Path.native() << "\": " << Code.message();
+        return;
+    }
+
+    /*
+     * Write the jobs in the format understood by "load" with all settings
+     * resolved, so the manifest describes the outputs without the
+     * configuration used to create them.
+     */
+    auto JSON = llvm::json::OStream(Out, 4);
+
+    JSON.array([&]() {
+        for (const auto &Item : Jobs_) {
+            auto Backend = Item.Backend.value_or(Config.Mocking.Backend);
+
+            JSON.object([&]() {
+                JSON.attribute("input", Item.Input.native());
+
+                if (!Item.Output.empty())
+                    JSON.attribute("output", Item.Output.native());
+
+                JSON.attribute("backend", getBackendName(Backend));
+            });
+        }
+    });
+
+    Out << "\n";
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_HPP_
+#define BATCH_HPP_
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+
+#include "Config.hpp"
+
+/*
+ * A batch is a list of jobs which get processed by a single ccmock
+ * invocation. Each job maps exactly one input source file to exactly
+ * one output file generated by a specific backend.
+ */
+
+class Batch {
+public:
+    struct Job {
+    public:
+        std::filesystem::path Input;
+        std::filesystem::path Output;
+        std::optional<enum Config::Backend> Backend;
+    };
+
+    Batch() = default;
+
+    inline void add(Job &&Item);
+    void load(const std::filesystem::path &Path, std::string &Error);
+    void select(llvm::ArrayRef<std::string> Files,
+                const Config &Config,
+                std::string &Error);
+    void resolve(const Config &Config, std::string &Error);
+    void shard(unsigned int Index,
+               unsigned int Count,
+               llvm::ArrayRef<double> Costs);
+    void save(const std::filesystem::path &Path,
+              const Config &Config,
+              std::string &Error) const;
+
+    inline llvm::ArrayRef<Job> getJobs() const;
+    inline bool empty() const;
+    inline size_t size() const;
+
+private:
+    std::vector<Job> Jobs_;
+};
+
+inline void Batch::add(Job &&Item)
+{
+    Jobs_.push_back(std::move(Item));
+}
+
+inline llvm::ArrayRef<Batch::Job> Batch::getJobs() const
+{
+    return llvm::ArrayRef(Jobs_);
+}
+
+inline bool Batch::empty() const
+{
+    return Jobs_.empty();
+}
+
+inline size_t Batch::size() const
+{
+    return Jobs_.size();
+}
+
+#endif /* BATCH_HPP_ */
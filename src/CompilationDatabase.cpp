@@ -15,11 +15,170 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>
+
 #include <clang/Tooling/CompilationDatabase.h>
 #include <clang/Tooling/JSONCompilationDatabase.h>
 
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include "ArgumentRewriter.hpp"
 #include "CompilationDatabase.hpp"
 
+namespace {
+
+/*
+ * Compilation databases stay loaded for the lifetime of the process. A
+ * server answering many requests therefore only parses a database again
+ * after the file it was loaded from has been modified.
+ */
+struct CacheEntry {
+public:
+    llvm::sys::TimePoint<> Time;
+    uint64_t Size;
+    std::shared_ptr<clang::tooling::CompilationDatabase> Database;
+};
+
+llvm::StringMap<CacheEntry> &getCache()
+{
+    static llvm::StringMap<CacheEntry> Cache;
+
+    return Cache;
+}
+
+std::shared_ptr<clang::tooling::CompilationDatabase>
+lookup(llvm::StringRef Key, const llvm::sys::fs::file_status &Status)
+{
+    auto &Cache = getCache();
+
+    auto It = Cache.find(Key);
+    if (It == Cache.end())
+        return nullptr;
+
+    const auto &Entry = It->second;
+    if (Entry.Time != Status.getLastModificationTime()
+        || Entry.Size != Status.getSize())
+        return nullptr;
+
+    return Entry.Database;
+}
+
+void insert(llvm::StringRef Key,
+            const llvm::sys::fs::file_status &Status,
+            std::shared_ptr<clang::tooling::CompilationDatabase> Database)
+{
+    auto &Entry = getCache()[Key];
+
+    Entry.Time = Status.getLastModificationTime();
+    Entry.Size = Status.getSize();
+    Entry.Database = std::move(Database);
+}
+
+std::string makeKey(const std::filesystem::path &Path)
+{
+    std::error_code Code;
+
+    auto Key = std::filesystem::absolute(Path, Code);
+    if (Code)
+        return Path.native();
+
+    return Key.lexically_normal().native();
+}
+
+std::string getSearchDirectory(const std::filesystem::path &Path)
+{
+    /*
+     * Without any input file (e.g. "--all-files") the search starts at
+     * the given directory instead.
+     */
+    std::error_code Code;
+
+    if (std::filesystem::is_directory(Path, Code))
+        return Path.native();
+
+    return llvm::sys::path::parent_path(Path.native()).str();
+}
+
+llvm::StringRef findDatabase(llvm::StringRef Dir,
+                             llvm::SmallVectorImpl<char> &File,
+                             llvm::sys::fs::file_status &Status)
+{
+    static constexpr std::array<llvm::StringRef, 2> Names = {
+        "compile_commands.json",
+        "compile_flags.txt",
+    };
+
+    for (; !Dir.empty(); Dir = llvm::sys::path::parent_path(Dir)) {
+        for (auto Name : Names) {
+            File.assign(Dir.begin(), Dir.end());
+            llvm::sys::path::append(File, Name);
+
+            if (!llvm::sys::fs::status(File, Status))
+                return Dir;
+        }
+    }
+
+    return llvm::StringRef();
+}
+
+} // namespace
+
+std::filesystem::path
+CompilationDatabase::locate(const std::filesystem::path &Path)
+{
+    auto File = llvm::SmallString<128>();
+    llvm::sys::fs::file_status Status;
+
+    /* Same search as "detect", but without loading the database */
+    auto Dir = findDatabase(makeKey(getSearchDirectory(Path)), File, Status);
+    if (Dir.empty())
+        return std::filesystem::path();
+
+    return File.str().str();
+}
+
+std::vector<std::string>
+CompilationDatabase::getKeyArguments(llvm::ArrayRef<std::string> Args)
+{
+    /* Code generation arguments never have any effect on the parsed AST */
+    return ArgumentRewriter::getCodeGenerationProfile().rewrite(Args);
+}
+
+std::string CompilationDatabase::getParseKey(
+    const clang::tooling::CompilationDatabase &Database,
+    const std::filesystem::path &File,
+    const clang::tooling::ArgumentsAdjuster &Adjuster)
+{
+    /*
+     * Files without any compile command are still parsed on their own,
+     * so the key always starts with the (absolute) path of the file.
+     *
+     * Example:
+     *      "cc -g -c a.c" and "cc -c a.c"         -> equal keys
+     *      b.c and c.c without compile commands   -> different keys
+     */
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    OS << File.native() << '\0';
+
+    for (auto &Command : Database.getCompileCommands(File.native())) {
+        auto Args = std::move(Command.CommandLine);
+        if (Adjuster)
+            Args = Adjuster(Args, Command.Filename);
+
+        OS << Command.Directory << '\0' << Command.Filename << '\0';
+
+        for (const auto &Arg : getKeyArguments(Args))
+            OS << Arg << '\0';
+    }
+
+    return OS.str();
+}
+
 void CompilationDatabase::load(const std::filesystem::path &Path,
                                std::string &Error)
 {
@@ -27,20 +186,32 @@ void CompilationDatabase::load(const std::filesystem::path &Path,
 
     const auto &Item = Path.native();
     auto Ext = llvm::sys::path::extension(Item);
+
+    auto Key = makeKey(Path);
+    llvm::sys::fs::file_status Status;
+
+    bool Cacheable = !llvm::sys::fs::status(Key, Status);
+    if (Cacheable) {
+        Database_ = lookup(Key, Status);
+        if (Database_)
+            return;
+    }
+
     if (Ext.equals(".json")) {
         auto Value = JSONCommandLineSyntax::AutoDetect;
 
         Database_ = JSONCompilationDatabase::loadFromFile(Item, Error, Value);
-        return;
-    }
-
-    if (Ext.equals(".txt")) {
+    } else if (Ext.equals(".txt")) {
         Database_ = FixedCompilationDatabase::loadFromFile(Item, Error);
+    } else {
+        llvm::raw_string_ostream OS(Error);
+        OS << "unsupported compilation database extension \"" << Ext
+           << "\"\n";
         return;
     }
 
-    llvm::raw_string_ostream OS(Error);
-    OS << "unsupported compilation database extension \"" << Ext << "\"\n";
+    if (Database_ && Cacheable)
+        insert(Key, Status, Database_);
 }
 
 void CompilationDatabase::detect(const std::filesystem::path &Path,
@@ -49,17 +220,41 @@ void CompilationDatabase::detect(const std::filesystem::path &Path,
     using clang::tooling::CompilationDatabase;
     using clang::tooling::FixedCompilationDatabase;
 
-    Database_ = CompilationDatabase::autoDetectFromSource(Path.native(), Error);
-    if (Database_)
-        return;
+    auto Directory = getSearchDirectory(Path);
+
+    /*
+     * Search the parent directories just like the clang tooling does, but
+     * remember the status of the database file so a cached database can
+     * be reused as long as the file did not change.
+     */
+    auto Key = makeKey(Directory);
+    auto File = llvm::SmallString<128>();
+    llvm::sys::fs::file_status Status;
+
+    auto Dir = findDatabase(Key, File, Status);
+    if (!Dir.empty()) {
+        Database_ = lookup(Dir, Status);
+        if (Database_)
+            return;
+
+        Database_ = CompilationDatabase::loadFromDirectory(Dir, Error);
+        if (Database_) {
+            insert(Dir, Status, Database_);
+            return;
+        }
+    }
+
+    if (Error.empty()) {
+        llvm::raw_string_ostream OS(Error);
+        OS << "Could not auto-detect compilation database from directory \""
+           << Key << "\"\n";
+    }
 
     /*
      * Fallback: Assume trivial compile commands. This allows to specifiy
      * additional compiler arguments via "--extra-arg" on the command-line
      * without running into an error.
      */
-    auto Directory = llvm::sys::path::parent_path(Path.native());
-
     Database_ = FixedCompilationDatabase::loadFromBuffer(Directory, "", Error);
 }
 
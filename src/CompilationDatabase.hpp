@@ -20,12 +20,17 @@
 
 #include <filesystem>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include <clang/Tooling/ArgumentsAdjusters.h>
 #include <clang/Tooling/CompilationDatabase.h>
 
 /*
  * Adapter class which allows to exactly control which compile command is used
- * to process a source file in case multiple commands are available.
+ * to process a source file in case multiple commands are available. Parse
+ * keys identify the translation unit a file is parsed into: files with
+ * equal keys result in the same AST.
  */
 
 class CompilationDatabase : public clang::tooling::CompilationDatabase {
@@ -36,6 +41,16 @@ public:
     void load(const std::filesystem::path &Path, std::string &Error);
     void detect(const std::filesystem::path &Path, std::string &Error);
 
+    static std::filesystem::path locate(const std::filesystem::path &Path);
+
+    static std::vector<std::string>
+    getKeyArguments(llvm::ArrayRef<std::string> Args);
+
+    static std::string
+    getParseKey(const clang::tooling::CompilationDatabase &Database,
+                const std::filesystem::path &File,
+                const clang::tooling::ArgumentsAdjuster &Adjuster);
+
     std::vector<clang::tooling::CompileCommand>
     getCompileCommands(llvm::StringRef File) const override;
 
@@ -47,7 +62,7 @@ public:
     inline operator bool() const noexcept;
 
 private:
-    std::unique_ptr<clang::tooling::CompilationDatabase> Database_;
+    std::shared_ptr<clang::tooling::CompilationDatabase> Database_;
     unsigned int Index_;
 };
 
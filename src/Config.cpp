@@ -59,6 +59,24 @@ public:
     }
 };
 
+template <> struct ScalarEnumerationTraits<Config::CacheKey> {
+public:
+    static void enumeration(IO &io, Config::CacheKey &Value)
+    {
+        io.enumCase(Value, "scan", Config::CACHEKEY_SCAN);
+        io.enumCase(Value, "preprocess", Config::CACHEKEY_PREPROCESS);
+    }
+};
+
+template <> struct ScalarEnumerationTraits<Config::ArgumentProfile> {
+public:
+    static void enumeration(IO &io, Config::ArgumentProfile &Value)
+    {
+        io.enumCase(Value, "none", Config::ARGUMENTPROFILE_NONE);
+        io.enumCase(Value, "syntax-only", Config::ARGUMENTPROFILE_SYNTAX_ONLY);
+    }
+};
+
 template <> struct ScalarEnumerationTraits<Config::Backend> {
 public:
     static void enumeration(IO &io, Config::Backend &Value)
@@ -66,6 +84,7 @@ public:
         io.enumCase(Value, "gmock", Config::BACKEND_GMOCK);
         io.enumCase(Value, "fff", Config::BACKEND_FFF);
         io.enumCase(Value, "cmocka", Config::BACKEND_CMOCKA);
+        io.enumCase(Value, "raw", Config::BACKEND_RAW);
     }
 };
 
@@ -78,6 +97,7 @@ public:
         IO.mapOptional("RemoveArguments", Section.RemoveArguments);
         IO.mapOptional("ResourceDirectory", Section.ResourceDirectory);
 
+        IO.mapOptional("ArgumentProfile", Section.ArgumentProfile);
         IO.mapOptional("CompileCommandIndex", Section.CompileCommandIndex);
     }
 
@@ -114,14 +134,37 @@ public:
     static void mapping(llvm::yaml::IO &IO, Config::GeneralSection &Section)
     {
         IO.mapOptional("BaseDirectory", Section.BaseDirectory);
+        IO.mapOptional("CacheDirectory", Section.CacheDirectory);
+        IO.mapOptional("DependencyFile", Section.DependencyFile);
+        IO.mapOptional("HistoryFile", Section.HistoryFile);
         IO.mapOptional("Input", Section.Input);
         IO.mapOptional("Output", Section.Output);
+        IO.mapOptional("OutputDirectory", Section.OutputDirectory);
 
-        IO.mapOptional("ColorMode", Section.ColorMode);
+        IO.mapOptional("Include", Section.Include);
+        IO.mapOptional("Exclude", Section.Exclude);
 
+        IO.mapOptional("CacheKey", Section.CacheKey);
+        IO.mapOptional("ColorMode", Section.ColorMode);
+        IO.mapOptional("Jobs", Section.Jobs);
+        IO.mapOptional("CacheSize", Section.CacheSize);
+        IO.mapOptional("MemoryBudget", Section.MemoryBudget);
+
+        IO.mapOptional("ASTCache", Section.ASTCache);
+        IO.mapOptional("AllFiles", Section.AllFiles);
+        IO.mapOptional("Cache", Section.Cache);
+        IO.mapOptional("CacheStats", Section.CacheStats);
+        IO.mapOptional("FastHeaders", Section.FastHeaders);
+        IO.mapOptional("FileCache", Section.FileCache);
+        IO.mapOptional("Incremental", Section.Incremental);
+        IO.mapOptional("PCH", Section.PCH);
         IO.mapOptional("Quiet", Section.Quiet);
+        IO.mapOptional("Reproducible", Section.Reproducible);
+        IO.mapOptional("RevalidateFileCache", Section.RevalidateFileCache);
         IO.mapOptional("Verbose", Section.Verbose);
+        IO.mapOptional("Watch", Section.Watch);
         IO.mapOptional("WriteDate", Section.WriteDate);
+        IO.mapOptional("WriteDependencyFile", Section.WriteDependencyFile);
     }
 
     static std::string validate(llvm::yaml::IO &IO,
@@ -219,6 +262,7 @@ Config::ClangSection::ClangSection()
       ExtraArguments(),
       RemoveArguments(),
       ResourceDirectory(),
+      ArgumentProfile(Config::ARGUMENTPROFILE_NONE),
       CompileCommandIndex(0)
 {
 }
@@ -239,12 +283,34 @@ Config::GMockSection::GMockSection()
 
 Config::GeneralSection::GeneralSection()
     : BaseDirectory(),
+      CacheDirectory(),
+      DependencyFile(),
+      HistoryFile(),
       Input(),
       Output(),
+      OutputDirectory(),
+      Include(),
+      Exclude(),
+      CacheKey(Config::CACHEKEY_SCAN),
       ColorMode(Config::COLORMODE_AUTO),
+      Jobs(1),
+      CacheSize(UINT64_C(1) << 30),
+      MemoryBudget(0),
+      ASTCache(false),
+      AllFiles(false),
+      Cache(false),
+      CacheStats(false),
+      FastHeaders(false),
+      FileCache(true),
+      Incremental(false),
+      PCH(false),
       Quiet(false),
+      Reproducible(false),
+      RevalidateFileCache(false),
       Verbose(false),
-      WriteDate(true)
+      Watch(false),
+      WriteDate(true),
+      WriteDependencyFile(false)
 {
 }
 
@@ -18,6 +18,7 @@
 #ifndef CONFIG_HPP_
 #define CONFIG_HPP_
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -33,6 +34,16 @@ public:
         COLORMODE_ALWAYS,
     };
 
+    enum CacheKey {
+        CACHEKEY_SCAN = 0,
+        CACHEKEY_PREPROCESS,
+    };
+
+    enum ArgumentProfile {
+        ARGUMENTPROFILE_NONE = 0,
+        ARGUMENTPROFILE_SYNTAX_ONLY,
+    };
+
     enum Backend {
         BACKEND_GMOCK,
         BACKEND_FFF,
@@ -49,6 +60,8 @@ public:
         std::vector<std::string> RemoveArguments;
         std::filesystem::path ResourceDirectory;
 
+        enum ArgumentProfile ArgumentProfile;
+
         unsigned int CompileCommandIndex;
     };
 
@@ -57,14 +70,38 @@ public:
         GeneralSection();
 
         std::filesystem::path BaseDirectory;
+        std::filesystem::path CacheDirectory;
+        std::filesystem::path DependencyFile;
+        std::filesystem::path HistoryFile;
         std::filesystem::path Input;
         std::filesystem::path Output;
+        std::filesystem::path OutputDirectory;
+
+        std::vector<std::string> Include;
+        std::vector<std::string> Exclude;
 
+        enum CacheKey CacheKey;
         enum ColorMode ColorMode;
 
+        unsigned int Jobs;
+        uint64_t CacheSize;
+        uint64_t MemoryBudget;
+
+        bool ASTCache;
+        bool AllFiles;
+        bool Cache;
+        bool CacheStats;
+        bool FastHeaders;
+        bool FileCache;
+        bool Incremental;
+        bool PCH;
         bool Quiet;
+        bool Reproducible;
+        bool RevalidateFileCache;
         bool Verbose;
+        bool Watch;
         bool WriteDate;
+        bool WriteDependencyFile;
     };
 
     struct MockingSection {
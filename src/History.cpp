@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "History.hpp"
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/Errc.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "util/FileSystem.hpp"
+
+void History::load(const std::filesystem::path &Path, std::string &Error)
+{
+    /*
+     * Example of a history file:
+     *      [
+     *          {
+     *              "file": "/src/a.c",
+     *              "hash": "9e1c2b3a4d5f6071",
+     *              "parse": 0.251,
+     *              "generate": 0.012,
+     *              "memory": 104857600,
+     *              "resident": 262144000
+     *          }
+     *      ]
+     */
+    llvm::raw_string_ostream OS(Error);
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Path.native());
+    if (!MemBuffer) {
+        /* There is no history before the very first run */
+        auto Code = MemBuffer.getError();
+        if (Code == llvm::errc::no_such_file_or_directory)
+            return;
+
+        OS << "failed to open \"" << Path.native() << "\": " << Code.message();
+        return;
+    }
+
+    auto Value = llvm::json::parse(MemBuffer.get()->getBuffer());
+    if (!Value) {
+        OS << "failed to parse \"" << Path.native()
+           << "\": " << llvm::toString(Value.takeError());
+        return;
+    }
+
+    const auto *Array = Value->getAsArray();
+    if (!Array) {
+        OS << "\"" << Path.native() << "\": expected an array of entries";
+        return;
+    }
+
+    for (const auto &Item : *Array) {
+        const auto *Object = Item.getAsObject();
+        if (!Object)
+            continue;
+
+        auto File = Object->getString("file");
+        auto Hash = Object->getString("hash");
+        auto ParseTime = Object->getNumber("parse");
+        auto GenerateTime = Object->getNumber("generate");
+
+        if (!File || !Hash || !ParseTime || !GenerateTime)
+            continue;
+
+        auto Entry = History::Entry();
+        if (Hash->getAsInteger(16, Entry.Hash))
+            continue;
+
+        Entry.ParseTime = *ParseTime;
+        Entry.GenerateTime = *GenerateTime;
+
+        /* Not available in histories of older versions */
+        Entry.Memory = 0;
+        Entry.Resident = 0;
+
+        if (auto Memory = Object->getInteger("memory"); Memory && *Memory > 0)
+            Entry.Memory = static_cast<uint64_t>(*Memory);
+
+        auto Resident = Object->getInteger("resident");
+        if (Resident && *Resident > 0)
+            Entry.Resident = static_cast<uint64_t>(*Resident);
+
+        insert(*File, Entry);
+    }
+}
+
+void History::save(const std::filesystem::path &Path, std::string &Error) const
+{
+    /* Sort the entries to keep the file stable across runs */
+    auto Keys = std::vector<llvm::StringRef>();
+    Keys.reserve(Entries_.size());
+
+    for (const auto &Item : Entries_)
+        Keys.push_back(Item.getKey());
+
+    llvm::sort(Keys);
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    {
+        auto JSON = llvm::json::OStream(OS, 4);
+
+        JSON.array([&]() {
+            for (auto Key : Keys) {
+                const auto &Entry = Entries_.find(Key)->second;
+
+                auto Memory = static_cast<int64_t>(Entry.Memory);
+                auto Resident = static_cast<int64_t>(Entry.Resident);
+
+                JSON.object([&]() {
+                    JSON.attribute("file", Key);
+                    JSON.attribute("hash", llvm::utohexstr(Entry.Hash, true));
+                    JSON.attribute("parse", Entry.ParseTime);
+                    JSON.attribute("generate", Entry.GenerateTime);
+                    JSON.attribute("memory", Memory);
+
+                    /* Only measured if the file was processed on its own */
+                    if (Resident != 0)
+                        JSON.attribute("resident", Resident);
+                });
+            }
+        });
+    }
+
+    OS << "\n";
+
+    /*
+     * Other processes (e.g. shards) might write the same history, so the
+     * file gets replaced atomically through a uniquely named temporary.
+     */
+    (void) util::fs::writeIfChanged(Path.native(), OS.str(), Error);
+}
+
+double History::getResidentRatio() const
+{
+    /*
+     * The peak resident memory is only known for some files, the memory
+     * allocated for their ASTs translates it to all the other files.
+     */
+    uint64_t Memory = 0;
+    uint64_t Resident = 0;
+
+    for (const auto &Item : Entries_) {
+        const auto &Entry = Item.getValue();
+
+        if (Entry.Memory == 0 || Entry.Resident == 0)
+            continue;
+
+        Memory += Entry.Memory;
+        Resident += Entry.Resident;
+    }
+
+    return (Memory != 0) ? double(Resident) / Memory : 0.0;
+}
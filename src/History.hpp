@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTORY_HPP_
+#define HISTORY_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+/*
+ * Persisted measurements of previous runs. Each entry belongs to an input
+ * file and is only valid as long as the hash of the compile command used
+ * to process the file does not change.
+ */
+
+class History {
+public:
+    struct Entry {
+    public:
+        uint64_t Hash;
+        double ParseTime;
+        double GenerateTime;
+        uint64_t Memory;
+        uint64_t Resident;
+    };
+
+    History() = default;
+
+    void load(const std::filesystem::path &Path, std::string &Error);
+    void save(const std::filesystem::path &Path, std::string &Error) const;
+
+    inline const Entry *lookup(llvm::StringRef File, uint64_t Hash) const;
+    inline void insert(llvm::StringRef File, const Entry &Entry);
+
+    double getResidentRatio() const;
+
+    inline bool empty() const;
+    inline size_t size() const;
+
+private:
+    llvm::StringMap<Entry> Entries_;
+};
+
+inline const History::Entry *History::lookup(llvm::StringRef File,
+                                             uint64_t Hash) const
+{
+    auto It = Entries_.find(File);
+    if (It == Entries_.end() || It->second.Hash != Hash)
+        return nullptr;
+
+    return &It->second;
+}
+
+inline void History::insert(llvm::StringRef File, const Entry &Entry)
+{
+    Entries_[File] = Entry;
+}
+
+inline bool History::empty() const
+{
+    return Entries_.empty();
+}
+
+inline size_t History::size() const
+{
+    return Entries_.size();
+}
+
+#endif /* HISTORY_HPP_ */
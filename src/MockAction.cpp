@@ -17,9 +17,31 @@
 
 #include "MockAction.hpp"
 
+#include <clang/AST/ASTContext.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Basic/TargetInfo.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/MultiplexConsumer.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Lex/Preprocessor.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <clang/Sema/SemaConsumer.h>
+#include <clang/Serialization/ASTReader.h>
+#include <clang/Serialization/ASTWriter.h>
+#include <clang/Serialization/InMemoryModuleCache.h>
+#include <clang/Serialization/ModuleManager.h>
+#include <clang/Serialization/PCHContainerOperations.h>
 #include <filesystem>
 
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitstream/BitstreamWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+
+#include "ModelCollector.hpp"
 #include "output/CMocka.hpp"
 #include "output/FFF.hpp"
 #include "output/GMock.hpp"
@@ -27,11 +49,31 @@
 
 namespace {
 
+/*
+ * Collects every file opened by the compiler instance. System headers are
+ * included as they might be vendored or third-party headers as well.
+ */
+class SystemDependencyCollector : public clang::DependencyCollector {
+public:
+    SystemDependencyCollector() = default;
+
+    bool needSystemDependencies() override;
+};
+
+bool SystemDependencyCollector::needSystemDependencies()
+{
+    return true;
+}
+
 class MockAction : public clang::ASTFrontendAction {
 public:
     MockAction() = default;
 
-    inline void setConfig(std::shared_ptr<const Config> Config);
+    inline void setOutputs(llvm::ArrayRef<MockActionFactory::Output> Outputs);
+    inline void setDependencies(std::vector<std::string> *Files);
+    inline void setASTFile(std::string *Data);
+    inline void setModel(std::optional<MockModel> *Model);
+    inline void setThreads(unsigned int Count);
 
 protected:
     std::unique_ptr<clang::ASTConsumer>
@@ -39,16 +81,204 @@ protected:
                       llvm::StringRef File) override;
 
     bool PrepareToExecuteAction(clang::CompilerInstance &CI) override;
+    void EndSourceFileAction() override;
 
 private:
-    std::shared_ptr<const Config> Config_;
+    std::vector<MockActionFactory::Output> Outputs_;
+    std::vector<std::string> *Dependencies_ = nullptr;
+    std::string *ASTFile_ = nullptr;
+    std::optional<MockModel> *Model_ = nullptr;
+    unsigned int Threads_ = 1;
+    std::shared_ptr<clang::DependencyCollector> Collector_;
 };
 
-inline void MockAction::setConfig(std::shared_ptr<const Config> Config)
+inline void
+MockAction::setOutputs(llvm::ArrayRef<MockActionFactory::Output> Outputs)
+{
+    Outputs_ = Outputs.vec();
+}
+
+inline void MockAction::setDependencies(std::vector<std::string> *Files)
+{
+    Dependencies_ = Files;
+}
+
+inline void MockAction::setASTFile(std::string *Data)
+{
+    ASTFile_ = Data;
+}
+
+inline void MockAction::setModel(std::optional<MockModel> *Model)
+{
+    Model_ = Model;
+}
+
+inline void MockAction::setThreads(unsigned int Count)
+{
+    Threads_ = Count;
+}
+
+/*
+ * Serializes the parsed translation unit into an AST file before the mock
+ * model gets extracted from it. Translation units with errors are never
+ * serialized.
+ */
+class ASTFileWriter : public clang::SemaConsumer {
+public:
+    explicit ASTFileWriter(std::string *Data);
+
+    void InitializeSema(clang::Sema &S) override;
+    void ForgetSema() override;
+    void HandleTranslationUnit(clang::ASTContext &Context) override;
+
+private:
+    clang::Sema *Sema_;
+    std::string *Data_;
+};
+
+ASTFileWriter::ASTFileWriter(std::string *Data)
+    : SemaConsumer(), Sema_(nullptr), Data_(Data)
+{
+}
+
+void ASTFileWriter::InitializeSema(clang::Sema &S)
+{
+    Sema_ = &S;
+}
+
+void ASTFileWriter::ForgetSema()
+{
+    Sema_ = nullptr;
+}
+
+void ASTFileWriter::HandleTranslationUnit(clang::ASTContext &Context)
+{
+    if (!Sema_ || Context.getDiagnostics().hasErrorOccurred())
+        return;
+
+    llvm::SmallVector<char, 0> Buffer;
+    llvm::BitstreamWriter Stream(Buffer);
+    clang::InMemoryModuleCache ModuleCache;
+    clang::ASTWriter Writer(Stream, Buffer, ModuleCache, {});
+
+    /* Same as "ASTUnit::Save", which requires an "ASTUnit" */
+#if LLVM_VERSION_MAJOR >= 19
+    Writer.WriteAST(Sema_, "", nullptr, "");
+#else
+    Writer.WriteAST(*Sema_, "", nullptr, "");
+#endif
+
+    Data_->assign(Buffer.data(), Buffer.size());
+}
+
+class TokenHashAction : public clang::PreprocessorFrontendAction {
+public:
+    TokenHashAction() = default;
+
+    inline void setConfig(std::shared_ptr<const ::Config> Config);
+    inline void setHash(std::string *Hash);
+    inline void setDependencies(std::vector<std::string> *Files);
+
+protected:
+    bool PrepareToExecuteAction(clang::CompilerInstance &CI) override;
+    void ExecuteAction() override;
+
+private:
+    std::shared_ptr<const ::Config> Config_;
+    std::string *Hash_ = nullptr;
+    std::vector<std::string> *Dependencies_ = nullptr;
+    std::shared_ptr<clang::DependencyCollector> Collector_;
+};
+
+inline void TokenHashAction::setConfig(std::shared_ptr<const ::Config> Config)
 {
     Config_ = std::move(Config);
 }
 
+inline void TokenHashAction::setHash(std::string *Hash)
+{
+    Hash_ = Hash;
+}
+
+inline void TokenHashAction::setDependencies(std::vector<std::string> *Files)
+{
+    Dependencies_ = Files;
+}
+
+class PCHAction : public clang::GeneratePCHAction {
+public:
+    PCHAction() = default;
+
+    inline void setConfig(std::shared_ptr<const ::Config> Config);
+    inline void setOutputFile(std::string Path);
+    inline void setDependencies(std::vector<std::string> *Files);
+
+protected:
+    bool PrepareToExecuteAction(clang::CompilerInstance &CI) override;
+    void EndSourceFileAction() override;
+
+private:
+    std::shared_ptr<const ::Config> Config_;
+    std::string OutputFile_;
+    std::vector<std::string> *Dependencies_ = nullptr;
+    std::shared_ptr<clang::DependencyCollector> Collector_;
+};
+
+inline void PCHAction::setConfig(std::shared_ptr<const ::Config> Config)
+{
+    Config_ = std::move(Config);
+}
+
+inline void PCHAction::setOutputFile(std::string Path)
+{
+    OutputFile_ = std::move(Path);
+}
+
+inline void PCHAction::setDependencies(std::vector<std::string> *Files)
+{
+    Dependencies_ = Files;
+}
+
+uint64_t GetMemoryUsage(clang::ASTUnit &Unit)
+{
+    const auto &Context = Unit.getASTContext();
+    const auto &SourceManager = Unit.getSourceManager();
+
+    uint64_t Size = 0;
+
+    Size += Context.getASTAllocatedMemory();
+    Size += Context.getSideTableAllocatedMemory();
+    Size += SourceManager.getContentCacheSize();
+    Size += SourceManager.getDataStructureSizes();
+    Size += Unit.getPreprocessor().getTotalMemory();
+
+    return Size;
+}
+
+uint64_t GetMemoryUsage(clang::CompilerInstance &CI)
+{
+    uint64_t Size = 0;
+
+    if (CI.hasASTContext()) {
+        const auto &Context = CI.getASTContext();
+
+        Size += Context.getASTAllocatedMemory();
+        Size += Context.getSideTableAllocatedMemory();
+    }
+
+    if (CI.hasSourceManager()) {
+        const auto &SourceManager = CI.getSourceManager();
+
+        Size += SourceManager.getContentCacheSize();
+        Size += SourceManager.getDataStructureSizes();
+    }
+
+    if (CI.hasPreprocessor())
+        Size += CI.getPreprocessor().getTotalMemory();
+
+    return Size;
+}
+
 std::string DetectClangResourceDirectory()
 {
     std::array<std::filesystem::path, 3> PathList = {
@@ -75,76 +305,438 @@ std::string DetectClangResourceDirectory()
     return std::string();
 }
 
-std::unique_ptr<clang::ASTConsumer>
-MockAction::CreateASTConsumer(clang::CompilerInstance &CI, llvm::StringRef File)
+const std::string &GetClangResourceDirectory()
 {
-    (void) File;
+    /* The directory does not change while the process is running */
+    static const auto Path = DetectClangResourceDirectory();
+
+    return Path;
+}
+
+bool AddClangResourceDirectory(clang::HeaderSearchOptions &Options,
+                               const Config &Config)
+{
+    /*
+     * For some reason the clang libtooling applications never know about
+     * the clang specific resource directory. This directory contains the
+     * include directory to some important header files.
+     * Try to automatically find the resource directory. The specific clang
+     * version should not matter.
+     */
+    auto Path = MockActionFactory::getResourceDirectory(Config);
+    if (Path.empty()) {
+        llvm::errs() << "failed to detect clang resource directory\n";
+        return false;
+    }
 
+    /* The invocation might have been prepared already */
+    if (Options.ResourceDir == Path)
+        return true;
+
+    auto Size = Path.size();
+
+    Path += "/include";
+
+    auto Group = clang::frontend::IncludeDirGroup::System;
+
+    Options.AddPath(Path, Group, false, false);
+
+    /* Restore original resource directory path */
+    Path.resize(Size);
+
+    Options.ResourceDir = std::move(Path);
+
+    return true;
+}
+
+void StoreDependencies(clang::CompilerInstance &CI,
+                       clang::DependencyCollector &Collector,
+                       std::vector<std::string> &Files)
+{
     /*
-     * As "PrintingPolicy" does not have a default constructor, this here is
-     * best place to create one. Having a separate policy
+     * Included files are named as they were found by the header search,
+     * which is relative to the directory of the compile command for
+     * relative include paths.
      */
-    auto Policy = clang::PrintingPolicy(CI.getLangOpts());
+    auto &FileManager = CI.getFileManager();
 
-    switch (Config_->Mocking.Backend) {
+    /* Precompiled headers are created by ccmock, not by the user */
+    const auto &PCH = CI.getPreprocessorOpts().ImplicitPCHInclude;
+
+    for (const auto &File : Collector.getDependencies()) {
+        if (File == PCH)
+            continue;
+
+        auto Path = llvm::SmallString<256>(File);
+
+        FileManager.makeAbsolutePath(Path);
+        llvm::sys::path::remove_dots(Path, true);
+
+        Files.push_back(Path.str().str());
+    }
+}
+
+void StoreDependencies(clang::ASTUnit &Unit, std::vector<std::string> &Files)
+{
+    auto Reader = Unit.getASTReader();
+    if (!Reader)
+        return;
+
+    auto &FileManager = Unit.getFileManager();
+    auto &Module = Reader->getModuleManager().getPrimaryModule();
+
+    auto Visitor = [&](const clang::serialization::InputFile &Input, bool) {
+        auto File = Input.getFile();
+        if (!File)
+            return;
+
+        auto Path = llvm::SmallString<256>(File->getName());
+
+        FileManager.makeAbsolutePath(Path);
+        llvm::sys::path::remove_dots(Path, true);
+
+        Files.push_back(Path.str().str());
+    };
+
+    /* Include system headers like the dependency collector */
+    Reader->visitInputFiles(Module, true, false, Visitor);
+}
+
+std::unique_ptr<OutputGenerator>
+CreateOutputGenerator(const MockActionFactory::Output &Output)
+{
+    std::unique_ptr<OutputGenerator> Generator;
+
+    switch (Output.Config->Mocking.Backend) {
     case Config::BACKEND_GMOCK:
-        return std::make_unique<GMock>(Config_, Policy);
+        Generator = std::make_unique<GMock>(Output.Config);
+        break;
     case Config::BACKEND_FFF:
-        return std::make_unique<FFF>(Config_, Policy);
+        Generator = std::make_unique<FFF>(Output.Config);
+        break;
     case Config::BACKEND_CMOCKA:
-        return std::make_unique<CMocka>(Config_, Policy);
+        Generator = std::make_unique<CMocka>(Output.Config);
+        break;
     case Config::BACKEND_RAW:
-        return std::make_unique<Raw>(Config_, Policy);
+        Generator = std::make_unique<Raw>(Output.Config);
+        break;
     default:
         llvm_unreachable("invalid output generator selected");
         break;
     }
 
-    return nullptr;
+    if (Output.OutputStream)
+        Generator->setOutputStream(Output.OutputStream);
+
+    Generator->setStatistics(Output.Statistics);
+
+    return Generator;
+}
+
+std::unique_ptr<clang::ASTConsumer>
+MockAction::CreateASTConsumer(clang::CompilerInstance &CI, llvm::StringRef File)
+{
+    (void) CI;
+    (void) File;
+
+    /* Only the mocking settings matter, which all outputs share */
+    auto Collector =
+        std::make_unique<ModelCollector>(Outputs_.front().Config, Model_);
+    Collector->setThreads(Threads_);
+
+    if (!ASTFile_)
+        return Collector;
+
+    auto Consumers = std::vector<std::unique_ptr<clang::ASTConsumer>>();
+    Consumers.reserve(2);
+
+    /* Consumers run in order, so the AST file gets written first */
+    Consumers.push_back(std::make_unique<ASTFileWriter>(ASTFile_));
+    Consumers.push_back(std::move(Collector));
+
+    return std::make_unique<clang::MultiplexConsumer>(std::move(Consumers));
 }
 
 bool MockAction::PrepareToExecuteAction(clang::CompilerInstance &CI)
+{
+    /* All outputs share the same clang specific configuration */
+    const auto &Config = *Outputs_.front().Config;
+    if (!AddClangResourceDirectory(CI.getHeaderSearchOpts(), Config))
+        return false;
+
+    /* The model collector decides which function bodies get skipped */
+    if (Config.General.FastHeaders)
+        CI.getFrontendOpts().SkipFunctionBodies = true;
+
+    /* Collectors must be registered before the preprocessor is created */
+    if (Dependencies_) {
+        Collector_ = std::make_shared<SystemDependencyCollector>();
+        CI.addDependencyCollector(Collector_);
+    }
+
+    return true;
+}
+
+void MockAction::EndSourceFileAction()
 {
     /*
-     * For some reason the clang libtooling applications never know about
-     * the clang specific resource directory. This directory contains the
-     * include directory to some important header files.
-     * Try to automatically find the resource directory. The specific clang
-     * version should not matter.
+     * The translation unit is still fully alive at this point, so this is
+     * about the peak amount of memory allocated for its AST. The memory
+     * of file contents is not included as it might be shared with other
+     * translation units, neither are any other allocations of the process.
+     */
+    auto Memory = GetMemoryUsage(getCompilerInstance());
+
+    for (auto &Output : Outputs_) {
+        if (Output.Statistics)
+            Output.Statistics->Memory = Memory;
+    }
+
+    if (Dependencies_ && Collector_)
+        StoreDependencies(getCompilerInstance(), *Collector_, *Dependencies_);
+}
+
+bool TokenHashAction::PrepareToExecuteAction(clang::CompilerInstance &CI)
+{
+    /* The header search has to be the same as for the mock action */
+    if (!AddClangResourceDirectory(CI.getHeaderSearchOpts(), *Config_))
+        return false;
+
+    if (Dependencies_) {
+        Collector_ = std::make_shared<SystemDependencyCollector>();
+        CI.addDependencyCollector(Collector_);
+    }
+
+    return true;
+}
+
+void TokenHashAction::ExecuteAction()
+{
+    /*
+     * Hash everything the generated output depends on besides the compile
+     * command: the fully preprocessed token stream, whether the tokens
+     * stem from the main file and the language the translation unit is
+     * parsed as.
      */
+    auto &CI = getCompilerInstance();
+    auto &PP = CI.getPreprocessor();
+    auto &SourceManager = CI.getSourceManager();
+    const auto &LangOpts = CI.getLangOpts();
+
+    auto Hash = llvm::SHA1();
+    auto Buffer = llvm::SmallString<64>();
+    auto Token = clang::Token();
+    auto MainFile = false;
+
+    auto Update = [&](llvm::StringRef Data) {
+        Hash.update(Data);
+        Hash.update(llvm::StringRef("\0", 1));
+    };
 
-    auto Path = Config_->Clang.ResourceDirectory.string();
+    Update(CI.getTarget().getTriple().str());
+    Update(llvm::utostr(static_cast<unsigned int>(LangOpts.LangStd)));
 
-    if (Path.empty()) {
-        Path = DetectClangResourceDirectory();
-        if (Path.empty()) {
-            llvm::errs() << "failed to detect clang resource directory\n";
-            return false;
+    PP.EnterMainSourceFile();
+
+    for (PP.Lex(Token); Token.isNot(clang::tok::eof); PP.Lex(Token)) {
+        auto Value = SourceManager.isInMainFile(Token.getLocation());
+        if (Value != MainFile) {
+            Update(Value ? "<main>" : "</main>");
+            MainFile = Value;
         }
+
+        Update(PP.getSpelling(Token, Buffer));
     }
 
-    auto Size = Path.size();
+    if (CI.getDiagnostics().hasErrorOccurred())
+        return;
 
-    Path += "/include";
+    if (Hash_)
+        *Hash_ = llvm::toHex(Hash.final());
 
-    auto Group = clang::frontend::IncludeDirGroup::System;
+    if (Dependencies_ && Collector_)
+        StoreDependencies(CI, *Collector_, *Dependencies_);
+}
 
-    CI.getHeaderSearchOpts().AddPath(Path, Group, false, false);
+bool PCHAction::PrepareToExecuteAction(clang::CompilerInstance &CI)
+{
+    if (!AddClangResourceDirectory(CI.getHeaderSearchOpts(), *Config_))
+        return false;
 
-    /* Restore original resource directory path */
-    Path.resize(Size);
+    /* The "ClangTool" only runs syntax checks, so set the output here */
+    CI.getFrontendOpts().OutputFile = OutputFile_;
 
-    CI.getHeaderSearchOpts().ResourceDir = std::move(Path);
+    if (Dependencies_) {
+        Collector_ = std::make_shared<SystemDependencyCollector>();
+        CI.addDependencyCollector(Collector_);
+    }
 
-    return true;
+    return GeneratePCHAction::PrepareToExecuteAction(CI);
+}
+
+void PCHAction::EndSourceFileAction()
+{
+    GeneratePCHAction::EndSourceFileAction();
+
+    if (Dependencies_ && Collector_)
+        StoreDependencies(getCompilerInstance(), *Collector_, *Dependencies_);
 }
 
 } // namespace
 
+void MockActionFactory::preload()
+{
+    (void) GetClangResourceDirectory();
+}
+
+std::string MockActionFactory::getResourceDirectory(const ::Config &Config)
+{
+    const auto &Path = Config.Clang.ResourceDirectory;
+
+    return Path.empty() ? GetClangResourceDirectory() : Path.string();
+}
+
+std::unique_ptr<clang::ASTUnit>
+MockActionFactory::loadASTFile(const std::string &Path)
+{
+    /* The reader keeps a reference to the container reader */
+    static clang::PCHContainerOperations Operations;
+
+    /*
+     * The AST reader rejects AST files if any of their input files was
+     * modified after they were written. Rejected files simply get parsed
+     * again, so do not report anything about them.
+     */
+    auto Diags = llvm::makeIntrusiveRefCnt<clang::DiagnosticsEngine>(
+        new clang::DiagnosticIDs(),
+        new clang::DiagnosticOptions(),
+        new clang::IgnoringDiagConsumer());
+
+    const auto &Reader = Operations.getRawReader();
+    auto Options = clang::FileSystemOptions();
+    auto ToLoad = clang::ASTUnit::LoadEverything;
+
+#if LLVM_VERSION_MAJOR >= 17
+    auto HeaderSearchOptions = std::make_shared<clang::HeaderSearchOptions>();
+    auto Unit = clang::ASTUnit::LoadFromASTFile(
+        Path, Reader, ToLoad, Diags, Options, HeaderSearchOptions);
+#else
+    auto Unit =
+        clang::ASTUnit::LoadFromASTFile(Path, Reader, ToLoad, Diags, Options);
+#endif
+
+    if (!Unit)
+        return nullptr;
+
+    /* Report the diagnostics of the output generators as usual */
+    auto *Printer = new clang::TextDiagnosticPrinter(
+        llvm::errs(), &Diags->getDiagnosticOptions());
+
+    Diags->setClient(Printer, true);
+
+    return Unit;
+}
+
 std::unique_ptr<clang::FrontendAction> MockActionFactory::create()
 {
     auto Action = std::make_unique<MockAction>();
+    Action->setOutputs(Outputs_);
+    Action->setDependencies(Dependencies_);
+    Action->setASTFile(ASTFile_);
+    Action->setModel(&Model_);
+    Action->setThreads(Threads_);
+
+    return Action;
+}
+
+bool MockActionFactory::runInvocation(
+    std::shared_ptr<clang::CompilerInvocation> Invocation,
+    clang::FileManager *Files,
+    std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+    clang::DiagnosticConsumer *DiagConsumer)
+{
+    using Base = clang::tooling::FrontendActionFactory;
+
+    if (!Preambles_) {
+        return Base::runInvocation(
+            std::move(Invocation), Files, PCHContainerOps, DiagConsumer);
+    }
+
+    /* The preamble has to be built with the final header search */
+    auto &Options = Invocation->getHeaderSearchOpts();
+    if (!AddClangResourceDirectory(Options, *Outputs_.front().Config))
+        return false;
+
+    auto FileSystem = llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(
+        &Files->getVirtualFileSystem());
+    auto MainFile = std::unique_ptr<llvm::MemoryBuffer>();
+
+    auto Preamble = Preambles_->configure(
+        *Invocation, FileSystem, PCHContainerOps, MainFile);
+
+    /* An in-memory preamble is provided by an overlay file system */
+    auto FileManager = llvm::IntrusiveRefCntPtr<clang::FileManager>(Files);
+    if (FileSystem.get() != &Files->getVirtualFileSystem()) {
+        FileManager = llvm::makeIntrusiveRefCnt<clang::FileManager>(
+            Files->getFileSystemOpts(), std::move(FileSystem));
+    }
+
+    return Base::runInvocation(std::move(Invocation),
+                               FileManager.get(),
+                               std::move(PCHContainerOps),
+                               DiagConsumer);
+}
+
+bool MockActionFactory::collect(clang::ASTUnit &Unit)
+{
+    auto &Context = Unit.getASTContext();
+    auto &Diags = Unit.getDiagnostics();
+
+    Diags.getClient()->BeginSourceFile(Unit.getLangOpts(),
+                                       &Unit.getPreprocessor());
+
+    auto Collector = ModelCollector(Outputs_.front().Config, &Model_);
+    Collector.setThreads(Threads_);
+    Collector.Initialize(Context);
+    Collector.HandleTranslationUnit(Context);
+
+    Diags.getClient()->EndSourceFile();
+
+    auto Memory = GetMemoryUsage(Unit);
+
+    for (auto &Output : Outputs_) {
+        if (Output.Statistics)
+            Output.Statistics->Memory = Memory;
+    }
+
+    if (Dependencies_)
+        StoreDependencies(Unit, *Dependencies_);
+
+    return !Diags.hasErrorOccurred();
+}
+
+void MockActionFactory::generate()
+{
+    for (const auto &Output : Outputs_)
+        CreateOutputGenerator(Output)->generate(*Model_);
+}
+
+std::unique_ptr<clang::FrontendAction> TokenHashActionFactory::create()
+{
+    auto Action = std::make_unique<TokenHashAction>();
+    Action->setConfig(Config_);
+    Action->setHash(Hash_);
+    Action->setDependencies(Dependencies_);
+
+    return Action;
+}
+
+std::unique_ptr<clang::FrontendAction> PCHActionFactory::create()
+{
+    auto Action = std::make_unique<PCHAction>();
     Action->setConfig(Config_);
+    Action->setOutputFile(OutputFile_);
+    Action->setDependencies(Dependencies_);
 
     return Action;
 }
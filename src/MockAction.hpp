@@ -18,27 +18,179 @@
 #ifndef MOCK_ACTION_HPP_
 #define MOCK_ACTION_HPP_
 
+#include <clang/Frontend/ASTUnit.h>
 #include <clang/Frontend/FrontendAction.h>
 #include <clang/Tooling/Tooling.h>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "Config.hpp"
+#include "MockModel.hpp"
+#include "PreambleCache.hpp"
+#include "Statistics.hpp"
+
+/*
+ * Creates actions which parse a translation unit once and extract its mock
+ * model. The outputs for all added output descriptions are generated from
+ * the model after the translation unit was released. All outputs must
+ * share the same clang specific configuration. The parsed translation unit
+ * can be serialized into an AST file and the model can be extracted from a
+ * loaded AST file instead of parsing again. With a preamble cache, only
+ * the part of the input file following its preamble has to be parsed.
+ */
 
 class MockActionFactory : public clang::tooling::FrontendActionFactory {
 public:
+    struct Output {
+    public:
+        std::shared_ptr<const ::Config> Config;
+        llvm::raw_ostream *OutputStream = nullptr;
+        ::Statistics *Statistics = nullptr;
+    };
+
     MockActionFactory() = default;
 
-    inline void setConfig(std::shared_ptr<const Config> Config);
+    inline void addOutput(Output &&Item);
+    inline void setDependencies(std::vector<std::string> *Files);
+    inline void setASTFile(std::string *Data);
+    inline void setPreambleCache(PreambleCache *Cache);
+    inline void setThreads(unsigned int Count);
+    inline void setModel(MockModel &&Model);
+    inline const std::optional<MockModel> &getModel() const;
+
+    static void preload();
+    static std::string getResourceDirectory(const ::Config &Config);
+    static std::unique_ptr<clang::ASTUnit> loadASTFile(const std::string &Path);
+
+    std::unique_ptr<clang::FrontendAction> create() override;
+    bool runInvocation(
+        std::shared_ptr<clang::CompilerInvocation> Invocation,
+        clang::FileManager *Files,
+        std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+        clang::DiagnosticConsumer *DiagConsumer) override;
+    bool collect(clang::ASTUnit &Unit);
+    void generate();
+
+private:
+    std::vector<Output> Outputs_;
+    std::vector<std::string> *Dependencies_ = nullptr;
+    std::string *ASTFile_ = nullptr;
+    PreambleCache *Preambles_ = nullptr;
+    unsigned int Threads_ = 1;
+    std::optional<MockModel> Model_;
+};
+
+inline void MockActionFactory::addOutput(Output &&Item)
+{
+    Outputs_.push_back(std::move(Item));
+}
+
+inline void MockActionFactory::setDependencies(std::vector<std::string> *Files)
+{
+    Dependencies_ = Files;
+}
+
+inline void MockActionFactory::setASTFile(std::string *Data)
+{
+    ASTFile_ = Data;
+}
+
+inline void MockActionFactory::setPreambleCache(PreambleCache *Cache)
+{
+    Preambles_ = Cache;
+}
+
+inline void MockActionFactory::setThreads(unsigned int Count)
+{
+    Threads_ = Count;
+}
+
+inline void MockActionFactory::setModel(MockModel &&Model)
+{
+    Model_ = std::move(Model);
+}
+
+inline const std::optional<MockModel> &MockActionFactory::getModel() const
+{
+    return Model_;
+}
+
+/*
+ * Creates actions which only preprocess a translation unit and compute a
+ * hash of its token stream. Equal hashes imply that parsing the
+ * translation units results in the same mocks for the same configuration.
+ */
+
+class TokenHashActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    TokenHashActionFactory() = default;
+
+    inline void setConfig(std::shared_ptr<const ::Config> Config);
+    inline void setHash(std::string *Hash);
+    inline void setDependencies(std::vector<std::string> *Files);
+
+    std::unique_ptr<clang::FrontendAction> create() override;
+
+private:
+    std::shared_ptr<const ::Config> Config_;
+    std::string *Hash_ = nullptr;
+    std::vector<std::string> *Dependencies_ = nullptr;
+};
+
+inline void
+TokenHashActionFactory::setConfig(std::shared_ptr<const ::Config> Config)
+{
+    Config_ = std::move(Config);
+}
+
+inline void TokenHashActionFactory::setHash(std::string *Hash)
+{
+    Hash_ = Hash;
+}
+
+inline void
+TokenHashActionFactory::setDependencies(std::vector<std::string> *Files)
+{
+    Dependencies_ = Files;
+}
+
+/*
+ * Creates actions which compile a header file into a clang PCH. The header
+ * search is set up in the same way as for the actions creating the mocks,
+ * so they can use the PCH.
+ */
+
+class PCHActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    PCHActionFactory() = default;
+
+    inline void setConfig(std::shared_ptr<const ::Config> Config);
+    inline void setOutputFile(std::string Path);
+    inline void setDependencies(std::vector<std::string> *Files);
 
     std::unique_ptr<clang::FrontendAction> create() override;
 
 private:
-    std::shared_ptr<const Config> Config_;
+    std::shared_ptr<const ::Config> Config_;
+    std::string OutputFile_;
+    std::vector<std::string> *Dependencies_ = nullptr;
 };
 
-inline void MockActionFactory::setConfig(std::shared_ptr<const Config> Config)
+inline void PCHActionFactory::setConfig(std::shared_ptr<const ::Config> Config)
 {
     Config_ = std::move(Config);
 }
 
+inline void PCHActionFactory::setOutputFile(std::string Path)
+{
+    OutputFile_ = std::move(Path);
+}
+
+inline void PCHActionFactory::setDependencies(std::vector<std::string> *Files)
+{
+    Dependencies_ = Files;
+}
+
 #endif /* MOCK_ACTION_HPP_ */
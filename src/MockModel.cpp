@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MockModel.hpp"
+
+#include <llvm/Support/LEB128.h>
+
+namespace {
+
+/*
+ * Layout of a serialized model: the magic, the format version and the
+ * flags of the model followed by its contexts, functions and variables.
+ * Every list is prefixed with its number of elements. All numbers are
+ * encoded as ULEB128 and all strings are prefixed with their size.
+ */
+const llvm::StringRef Magic = "CCMM";
+constexpr uint8_t Version = 1;
+
+enum : uint8_t {
+    MODEL_CPLUSPLUS = 1 << 0,
+};
+
+enum : uint8_t {
+    PARAMETER_POINTER = 1 << 0,
+    PARAMETER_RVALUE_REFERENCE = 1 << 1,
+    PARAMETER_OUTPUT = 1 << 2,
+    PARAMETER_FUNCTION_POINTER = 1 << 3,
+    PARAMETER_TYPEDEF = 1 << 4,
+};
+
+enum : uint8_t {
+    FUNCTION_EXTERN_C = 1 << 0,
+    FUNCTION_VARIADIC = 1 << 1,
+    FUNCTION_CONST = 1 << 2,
+    FUNCTION_NOEXCEPT = 1 << 3,
+    FUNCTION_RETURNS_VOID = 1 << 4,
+    FUNCTION_RETURNS_POINTER = 1 << 5,
+};
+
+class Reader {
+public:
+    explicit Reader(llvm::StringRef Data);
+
+    uint8_t readByte();
+    uint64_t readNumber();
+    size_t readCount();
+    std::string readString();
+
+    template <typename T> T readEnum(T Max);
+
+    inline bool failed() const;
+    inline bool done() const;
+
+private:
+    const uint8_t *Pos_;
+    const uint8_t *End_;
+    bool Failed_;
+};
+
+Reader::Reader(llvm::StringRef Data)
+    : Pos_(reinterpret_cast<const uint8_t *>(Data.data())),
+      End_(Pos_ + Data.size()),
+      Failed_(false)
+{
+}
+
+uint8_t Reader::readByte()
+{
+    if (Failed_ || Pos_ == End_) {
+        Failed_ = true;
+        return 0;
+    }
+
+    return *Pos_++;
+}
+
+uint64_t Reader::readNumber()
+{
+    if (Failed_)
+        return 0;
+
+    unsigned int Size = 0;
+    const char *Error = nullptr;
+
+    auto Value = llvm::decodeULEB128(Pos_, &Size, End_, &Error);
+    if (Error) {
+        Failed_ = true;
+        return 0;
+    }
+
+    Pos_ += Size;
+
+    return Value;
+}
+
+size_t Reader::readCount()
+{
+    /* Every element takes at least one byte, which bounds any allocation */
+    auto Count = readNumber();
+    if (Count > static_cast<uint64_t>(End_ - Pos_)) {
+        Failed_ = true;
+        return 0;
+    }
+
+    return Count;
+}
+
+std::string Reader::readString()
+{
+    auto Size = readCount();
+    if (Failed_)
+        return std::string();
+
+    auto Value = std::string(reinterpret_cast<const char *>(Pos_), Size);
+    Pos_ += Size;
+
+    return Value;
+}
+
+template <typename T> T Reader::readEnum(T Max)
+{
+    auto Value = readByte();
+    if (Value > Max) {
+        Failed_ = true;
+        return T();
+    }
+
+    return static_cast<T>(Value);
+}
+
+inline bool Reader::failed() const
+{
+    return Failed_;
+}
+
+inline bool Reader::done() const
+{
+    return Pos_ == End_;
+}
+
+void writeNumber(llvm::raw_ostream &OS, uint64_t Value)
+{
+    llvm::encodeULEB128(Value, OS);
+}
+
+void writeString(llvm::raw_ostream &OS, llvm::StringRef Value)
+{
+    writeNumber(OS, Value.size());
+    OS << Value;
+}
+
+void writeType(llvm::raw_ostream &OS, const MockModel::Type &Type)
+{
+    writeString(OS, Type.Spelling);
+    writeString(OS, Type.CXXSpelling);
+}
+
+void writeDeclarator(llvm::raw_ostream &OS,
+                     const MockModel::Declarator &Declarator)
+{
+    writeString(OS, Declarator.Head);
+    writeString(OS, Declarator.Tail);
+}
+
+MockModel::Type readType(Reader &Reader)
+{
+    auto Type = MockModel::Type();
+    Type.Spelling = Reader.readString();
+    Type.CXXSpelling = Reader.readString();
+
+    return Type;
+}
+
+MockModel::Declarator readDeclarator(Reader &Reader)
+{
+    auto Declarator = MockModel::Declarator();
+    Declarator.Head = Reader.readString();
+    Declarator.Tail = Reader.readString();
+
+    return Declarator;
+}
+
+} // namespace
+
+MockModel::MockModel()
+    : Contexts_(1), Functions_(), Variables_(), CPlusPlus_(false)
+{
+}
+
+uint32_t MockModel::addContext(Context &&Item)
+{
+    Contexts_.push_back(std::move(Item));
+
+    return Contexts_.size() - 1;
+}
+
+void MockModel::read(llvm::StringRef Data, std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+
+    if (!Data.startswith(Magic)) {
+        OS << "invalid model";
+        return;
+    }
+
+    auto Reader = ::Reader(Data.drop_front(Magic.size()));
+
+    if (Reader.readByte() != Version) {
+        OS << "unsupported model version";
+        return;
+    }
+
+    auto Model = MockModel();
+    Model.Contexts_.clear();
+
+    auto Flags = Reader.readByte();
+    Model.CPlusPlus_ = (Flags & MODEL_CPLUSPLUS) != 0;
+
+    auto Count = Reader.readCount();
+    Model.Contexts_.reserve(Count);
+
+    for (size_t i = 0; i < Count && !Reader.failed(); ++i) {
+        auto Item = Context();
+        Item.Kind = Reader.readEnum(Context::KIND_UNION);
+        Item.Name = Reader.readString();
+        Item.Parent = Reader.readNumber();
+
+        /* Only the translation unit comes first and has no parent */
+        auto IsRoot = Item.Kind == Context::KIND_TRANSLATION_UNIT;
+        if (IsRoot != (i == 0) || (i != 0 && Item.Parent >= i)) {
+            OS << "invalid context in model";
+            return;
+        }
+
+        Model.Contexts_.push_back(std::move(Item));
+    }
+
+    if (Model.Contexts_.empty() && !Reader.failed()) {
+        OS << "missing translation unit in model";
+        return;
+    }
+
+    Count = Reader.readCount();
+    Model.Functions_.reserve(Count);
+
+    for (size_t i = 0; i < Count && !Reader.failed(); ++i) {
+        auto Item = Function();
+        Item.Kind = Reader.readEnum(Function::KIND_CONVERSION);
+        Item.Access = Reader.readEnum(Function::ACCESS_PRIVATE);
+        Item.RefQualifier = Reader.readEnum(Function::REFQUALIFIER_RVALUE);
+        Item.Name = Reader.readString();
+        Item.QualifiedName = Reader.readString();
+        Item.MockName = Reader.readString();
+        Item.Declaration = Reader.readString();
+        Item.ReturnType = readType(Reader);
+        Item.Context = Reader.readNumber();
+
+        auto Flags = Reader.readByte();
+        Item.IsExternC = (Flags & FUNCTION_EXTERN_C) != 0;
+        Item.IsVariadic = (Flags & FUNCTION_VARIADIC) != 0;
+        Item.IsConst = (Flags & FUNCTION_CONST) != 0;
+        Item.IsNoexcept = (Flags & FUNCTION_NOEXCEPT) != 0;
+        Item.ReturnsVoid = (Flags & FUNCTION_RETURNS_VOID) != 0;
+        Item.ReturnsPointer = (Flags & FUNCTION_RETURNS_POINTER) != 0;
+
+        auto Size = Reader.readCount();
+        Item.Parameters.reserve(Size);
+
+        for (size_t j = 0; j < Size && !Reader.failed(); ++j) {
+            auto Parameter = MockModel::Parameter();
+            Parameter.Name = Reader.readString();
+            Parameter.Declarator = readDeclarator(Reader);
+            Parameter.Type = readType(Reader);
+
+            auto Flags = Reader.readByte();
+            Parameter.IsPointer = (Flags & PARAMETER_POINTER) != 0;
+            Parameter.IsRValueReference =
+                (Flags & PARAMETER_RVALUE_REFERENCE) != 0;
+            Parameter.IsOutput = (Flags & PARAMETER_OUTPUT) != 0;
+            Parameter.IsFunctionPointer =
+                (Flags & PARAMETER_FUNCTION_POINTER) != 0;
+            Parameter.IsTypedef = (Flags & PARAMETER_TYPEDEF) != 0;
+
+            Item.Parameters.push_back(std::move(Parameter));
+        }
+
+        if (Item.Context >= Model.Contexts_.size()) {
+            OS << "invalid function context in model";
+            return;
+        }
+
+        Model.Functions_.push_back(std::move(Item));
+    }
+
+    Count = Reader.readCount();
+    Model.Variables_.reserve(Count);
+
+    for (size_t i = 0; i < Count && !Reader.failed(); ++i) {
+        auto Item = Variable();
+        Item.QualifiedName = Reader.readString();
+        Item.Declarator = readDeclarator(Reader);
+        Item.CXXDeclarator = readDeclarator(Reader);
+
+        Model.Variables_.push_back(std::move(Item));
+    }
+
+    if (Reader.failed() || !Reader.done()) {
+        OS << "truncated or corrupted model";
+        return;
+    }
+
+    *this = std::move(Model);
+}
+
+void MockModel::write(llvm::raw_ostream &OS) const
+{
+    OS << Magic;
+    OS << static_cast<char>(Version);
+    OS << static_cast<char>(CPlusPlus_ ? MODEL_CPLUSPLUS : 0);
+
+    writeNumber(OS, Contexts_.size());
+
+    for (const auto &Item : Contexts_) {
+        OS << static_cast<char>(Item.Kind);
+        writeString(OS, Item.Name);
+        writeNumber(OS, Item.Parent);
+    }
+
+    writeNumber(OS, Functions_.size());
+
+    for (const auto &Item : Functions_) {
+        uint8_t Flags = 0;
+
+        if (Item.IsExternC)
+            Flags |= FUNCTION_EXTERN_C;
+        if (Item.IsVariadic)
+            Flags |= FUNCTION_VARIADIC;
+        if (Item.IsConst)
+            Flags |= FUNCTION_CONST;
+        if (Item.IsNoexcept)
+            Flags |= FUNCTION_NOEXCEPT;
+        if (Item.ReturnsVoid)
+            Flags |= FUNCTION_RETURNS_VOID;
+        if (Item.ReturnsPointer)
+            Flags |= FUNCTION_RETURNS_POINTER;
+
+        OS << static_cast<char>(Item.Kind);
+        OS << static_cast<char>(Item.Access);
+        OS << static_cast<char>(Item.RefQualifier);
+        writeString(OS, Item.Name);
+        writeString(OS, Item.QualifiedName);
+        writeString(OS, Item.MockName);
+        writeString(OS, Item.Declaration);
+        writeType(OS, Item.ReturnType);
+        writeNumber(OS, Item.Context);
+        OS << static_cast<char>(Flags);
+
+        writeNumber(OS, Item.Parameters.size());
+
+        for (const auto &Parameter : Item.Parameters) {
+            uint8_t Flags = 0;
+
+            if (Parameter.IsPointer)
+                Flags |= PARAMETER_POINTER;
+            if (Parameter.IsRValueReference)
+                Flags |= PARAMETER_RVALUE_REFERENCE;
+            if (Parameter.IsOutput)
+                Flags |= PARAMETER_OUTPUT;
+            if (Parameter.IsFunctionPointer)
+                Flags |= PARAMETER_FUNCTION_POINTER;
+            if (Parameter.IsTypedef)
+                Flags |= PARAMETER_TYPEDEF;
+
+            writeString(OS, Parameter.Name);
+            writeDeclarator(OS, Parameter.Declarator);
+            writeType(OS, Parameter.Type);
+            OS << static_cast<char>(Flags);
+        }
+    }
+
+    writeNumber(OS, Variables_.size());
+
+    for (const auto &Item : Variables_) {
+        writeString(OS, Item.QualifiedName);
+        writeDeclarator(OS, Item.Declarator);
+        writeDeclarator(OS, Item.CXXDeclarator);
+    }
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MOCKMODEL_HPP_
+#define MOCKMODEL_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+/*
+ * Everything the backends need to know about a translation unit to mock
+ * its undefined functions and variables. The model is extracted once from
+ * the AST and does not refer to it, so the AST can be released before any
+ * output is generated. Types are printed while extracting the model, both
+ * in the language of the input file and in a form suitable for C++
+ * backends. The model can be stored in a compact binary format to
+ * generate outputs for other backends without parsing the input file.
+ */
+
+class MockModel {
+public:
+    struct Context {
+    public:
+        enum Kind : uint8_t {
+            KIND_TRANSLATION_UNIT = 0,
+            KIND_NAMESPACE,
+            KIND_CLASS,
+            KIND_STRUCT,
+            KIND_UNION,
+        };
+
+        enum Kind Kind = KIND_TRANSLATION_UNIT;
+        std::string Name;
+
+        /* Index of the enclosing context, the translation unit is its own */
+        uint32_t Parent = 0;
+    };
+
+    struct Type {
+    public:
+        /* Spelling in the language of the input file */
+        std::string Spelling;
+
+        /* Spelling without tag keywords and with "bool" for C++ backends */
+        std::string CXXSpelling;
+    };
+
+    /*
+     * A type split at the position of the declared name, which is required
+     * to declare e.g. function pointers: "void (*" name ")(int)".
+     */
+    struct Declarator {
+    public:
+        std::string Head;
+        std::string Tail;
+    };
+
+    struct Parameter {
+    public:
+        /* Unnamed parameters are named "arg<N>" */
+        std::string Name;
+
+        /* The type as written in the input file, without top-level "const" */
+        struct Declarator Declarator;
+
+        /* The canonical type without top-level "const" */
+        struct Type Type;
+
+        bool IsPointer = false;
+        bool IsRValueReference = false;
+        bool IsOutput = false;
+        bool IsFunctionPointer = false;
+        bool IsTypedef = false;
+    };
+
+    struct Function {
+    public:
+        enum Kind : uint8_t {
+            KIND_FUNCTION = 0,
+            KIND_METHOD,
+            KIND_CONSTRUCTOR,
+            KIND_DESTRUCTOR,
+            KIND_CONVERSION,
+        };
+
+        enum Access : uint8_t {
+            ACCESS_NONE = 0,
+            ACCESS_PUBLIC,
+            ACCESS_PROTECTED,
+            ACCESS_PRIVATE,
+        };
+
+        enum RefQualifier : uint8_t {
+            REFQUALIFIER_NONE = 0,
+            REFQUALIFIER_LVALUE,
+            REFQUALIFIER_RVALUE,
+        };
+
+        enum Kind Kind = KIND_FUNCTION;
+        enum Access Access = ACCESS_NONE;
+        enum RefQualifier RefQualifier = REFQUALIFIER_NONE;
+
+        std::string Name;
+        std::string QualifiedName;
+        std::string MockName;
+
+        /* The declaration as printed by clang, e.g. for the raw backend */
+        std::string Declaration;
+
+        Type ReturnType;
+        std::vector<Parameter> Parameters;
+
+        /* Index of the context the function is declared in */
+        uint32_t Context = 0;
+
+        bool IsExternC = false;
+        bool IsVariadic = false;
+        bool IsConst = false;
+        bool IsNoexcept = false;
+        bool ReturnsVoid = false;
+        bool ReturnsPointer = false;
+    };
+
+    struct Variable {
+    public:
+        std::string QualifiedName;
+
+        /* Declarators of the canonical type, the C++ one keeps tag keywords */
+        struct Declarator Declarator;
+        struct Declarator CXXDeclarator;
+    };
+
+    MockModel();
+
+    void read(llvm::StringRef Data, std::string &Error);
+    void write(llvm::raw_ostream &OS) const;
+
+    inline void setCPlusPlus(bool Value);
+    uint32_t addContext(Context &&Item);
+    inline void addFunction(Function &&Item);
+    inline void addVariable(Variable &&Item);
+
+    inline bool isCPlusPlus() const;
+    inline const Context &getContext(uint32_t Index) const;
+    inline const Context *getParent(const Context &Item) const;
+    inline bool isGlobalContext(const Context &Item) const;
+    inline llvm::ArrayRef<Context> getContexts() const;
+    inline llvm::ArrayRef<Function> getFunctions() const;
+    inline llvm::ArrayRef<Variable> getVariables() const;
+
+private:
+    /* The first context is always the translation unit */
+    std::vector<Context> Contexts_;
+    std::vector<Function> Functions_;
+    std::vector<Variable> Variables_;
+
+    bool CPlusPlus_;
+};
+
+inline void MockModel::setCPlusPlus(bool Value)
+{
+    CPlusPlus_ = Value;
+}
+
+inline void MockModel::addFunction(Function &&Item)
+{
+    Functions_.push_back(std::move(Item));
+}
+
+inline void MockModel::addVariable(Variable &&Item)
+{
+    Variables_.push_back(std::move(Item));
+}
+
+inline bool MockModel::isCPlusPlus() const
+{
+    return CPlusPlus_;
+}
+
+inline const MockModel::Context &MockModel::getContext(uint32_t Index) const
+{
+    return Contexts_[Index];
+}
+
+inline const MockModel::Context *
+MockModel::getParent(const Context &Item) const
+{
+    if (Item.Kind == Context::KIND_TRANSLATION_UNIT)
+        return nullptr;
+
+    return &Contexts_[Item.Parent];
+}
+
+inline bool MockModel::isGlobalContext(const Context &Item) const
+{
+    const auto *Parent = getParent(Item);
+
+    return !Parent || Parent->Kind == Context::KIND_TRANSLATION_UNIT;
+}
+
+inline llvm::ArrayRef<MockModel::Context> MockModel::getContexts() const
+{
+    return llvm::ArrayRef(Contexts_);
+}
+
+inline llvm::ArrayRef<MockModel::Function> MockModel::getFunctions() const
+{
+    return llvm::ArrayRef(Functions_);
+}
+
+inline llvm::ArrayRef<MockModel::Variable> MockModel::getVariables() const
+{
+    return llvm::ArrayRef(Variables_);
+}
+
+#endif /* MOCKMODEL_HPP_ */
@@ -0,0 +1,983 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ModelCollector.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <string>
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/StringMap.h>
+
+#include "util/Glob.hpp"
+#include "util/ThreadPool.hpp"
+#include "util/commandline.hpp"
+
+namespace {
+
+const llvm::StringMap<int> InternalBlacklist = {
+    {"environ", 0},
+    {"stdin", 0},
+    {"stdout", 0},
+    {"stderr", 0},
+    {"std::cin", 0},
+    {"std::wcin", 0},
+    {"std::cout", 0},
+    {"std::wcout", 0},
+    {"std::cerr", 0},
+    {"std::wcerr", 0},
+};
+
+/* Records all expressions within the main file which may refer to mocks */
+class ASTVisitor : public clang::RecursiveASTVisitor<ASTVisitor> {
+public:
+    ASTVisitor(const clang::SourceManager &SourceManager,
+               std::vector<const clang::Expr *> *Exprs);
+
+    static void run(clang::ASTContext &Context,
+                    std::vector<const clang::Expr *> &Exprs);
+
+    bool isInMainFile(const clang::Decl *Decl) const;
+
+    bool VisitCallExpr(clang::CallExpr *CallExpr);
+    bool VisitCXXConstructExpr(clang::CXXConstructExpr *ConstructExpr);
+    bool VisitDeclRefExpr(clang::DeclRefExpr *DeclRefExpr);
+
+    bool shouldWalkTypesOfTypeLocs() const;
+
+private:
+    void add(const clang::Expr *Expr);
+
+    const clang::SourceManager *SourceManager_;
+    std::vector<const clang::Expr *> *Exprs_;
+};
+
+/* Collects the functions and variables referred to by the expressions */
+class ExprHandler {
+public:
+    struct Result {
+    public:
+        std::vector<const clang::FunctionDecl *> FunctionDecls;
+        std::vector<const clang::VarDecl *> VarDecls;
+
+        /* Handlers may run on any thread, so they must not terminate */
+        std::string Error;
+    };
+
+    ExprHandler(const Config &Config, const util::glob::Matcher &Blacklist);
+
+    void run(llvm::ArrayRef<const clang::Expr *> Exprs,
+             Result &Output,
+             llvm::raw_ostream &Log);
+
+private:
+    const Config &getConfig() const;
+
+    void dispatch(const clang::Expr *Expr, const clang::FunctionDecl *Decl);
+    bool isVisited(const clang::DeclaratorDecl *Decl);
+
+    void doVisitCallExpr(const clang::CallExpr *CallExpr);
+    void doVisitCXXConstructExpr(const clang::CXXConstructExpr *ConstructExpr);
+    void doVisitDeclRefExpr(const clang::DeclRefExpr *DeclRefExpr);
+
+    const Config *Config_;
+    Result *Output_;
+    llvm::raw_ostream *Log_;
+
+    const util::glob::Matcher *Blacklist_;
+    llvm::DenseSet<int64_t> Visited_;
+
+    std::string Buffer_;
+};
+
+ASTVisitor::ASTVisitor(const clang::SourceManager &SourceManager,
+                       std::vector<const clang::Expr *> *Exprs)
+    : SourceManager_(&SourceManager),
+      Exprs_(Exprs)
+{
+}
+
+void ASTVisitor::run(clang::ASTContext &Context,
+                     std::vector<const clang::Expr *> &Exprs)
+{
+    ASTVisitor Visitor(Context.getSourceManager(), &Exprs);
+
+    /*
+     * Only expressions within the main file contribute to the model, so
+     * top-level declarations of other files (e.g. the whole C++ standard
+     * library) are skipped up front. Instantiations of templates declared
+     * within the main file are still reached through their templates.
+     */
+    for (auto *Decl : Context.getTranslationUnitDecl()->decls()) {
+        if (Visitor.isInMainFile(Decl))
+            Visitor.TraverseDecl(Decl);
+    }
+}
+
+bool ASTVisitor::isInMainFile(const clang::Decl *Decl) const
+{
+    /*
+     * Macro expansions count for the file they are expanded in. Check both
+     * ends of the range as a declaration might span multiple files.
+     */
+    auto Range = Decl->getSourceRange();
+
+    return SourceManager_->isInMainFile(Range.getBegin())
+           || SourceManager_->isInMainFile(Range.getEnd());
+}
+
+bool ASTVisitor::VisitCallExpr(clang::CallExpr *CallExpr)
+{
+    add(CallExpr);
+
+    return true;
+}
+
+bool ASTVisitor::VisitCXXConstructExpr(clang::CXXConstructExpr *ConstructExpr)
+{
+    add(ConstructExpr);
+
+    return true;
+}
+
+bool ASTVisitor::VisitDeclRefExpr(clang::DeclRefExpr *DeclRefExpr)
+{
+    add(DeclRefExpr);
+
+    return true;
+}
+
+bool ASTVisitor::shouldWalkTypesOfTypeLocs() const
+{
+    return false;
+}
+
+void ASTVisitor::add(const clang::Expr *Expr)
+{
+    if (SourceManager_->isInMainFile(Expr->getExprLoc()))
+        Exprs_->push_back(Expr);
+}
+
+ExprHandler::ExprHandler(const Config &Config,
+                         const util::glob::Matcher &Blacklist)
+    : Config_(&Config),
+      Output_(nullptr),
+      Log_(nullptr),
+      Blacklist_(&Blacklist),
+      Visited_(64),
+      Buffer_()
+{
+    Buffer_.reserve(256);
+}
+
+void ExprHandler::run(llvm::ArrayRef<const clang::Expr *> Exprs,
+                      Result &Output,
+                      llvm::raw_ostream &Log)
+{
+    /* Repeated uses are only detected within the same expressions */
+    Visited_.clear();
+    Output_ = &Output;
+    Log_ = &Log;
+
+    for (const auto *Expr : Exprs) {
+        if (!Output.Error.empty())
+            break;
+
+        if (const auto *CallExpr = clang::dyn_cast<clang::CallExpr>(Expr))
+            doVisitCallExpr(CallExpr);
+        else if (const auto *ConstructExpr =
+                     clang::dyn_cast<clang::CXXConstructExpr>(Expr))
+            doVisitCXXConstructExpr(ConstructExpr);
+        else if (const auto *DeclRefExpr =
+                     clang::dyn_cast<clang::DeclRefExpr>(Expr))
+            doVisitDeclRefExpr(DeclRefExpr);
+    }
+
+    Output_ = nullptr;
+    Log_ = nullptr;
+}
+
+const Config &ExprHandler::getConfig() const
+{
+    return *Config_;
+}
+
+void ExprHandler::dispatch(const clang::Expr *Expr,
+                           const clang::FunctionDecl *Decl)
+{
+    llvm::raw_string_ostream OS(Buffer_);
+
+    /*
+     * Call expressions via function pointers don't have a function
+     * declaration associated with them.
+     */
+    if (!Decl)
+        return;
+
+    if (Decl->isDefined())
+        return;
+
+    /*
+     * Mocking this function raises a lot of issues as it is heavily used
+     * when dealing with system calls. This most likely will negatively
+     * impact any unit test framework before even running any tests.
+     */
+    if (Decl->getIdentifier() && Decl->getName().equals("__errno_location"))
+        return;
+
+    /*
+     * Deal with builtin functions which might refer to compiler builtins
+     * like "__builtin_expect" or standard library functions.
+     */
+    const auto &Config = getConfig();
+
+    if (Decl->getBuiltinID()) {
+        auto Name = Decl->getName();
+
+        /* Non standard library builtins */
+        if (Name.startswith("__builtin_") && !Config.Mocking.MockBuiltins) {
+            if (Config.General.Verbose) {
+                *Log_ << util::cl::info() << "skipping builtin \""
+                      << Name << "\"\n";
+            }
+
+            return;
+        }
+
+        /* C++ standard library functions */
+        if (Decl->isInStdNamespace() && !Config.Mocking.MockCXXStdLib) {
+            if (Config.General.Verbose) {
+                *Log_ << util::cl::info()
+                      << "skipping C++ standard library function \"";
+                Decl->printQualifiedName(*Log_);
+                *Log_ << "\"\n";
+            }
+
+            return;
+        }
+
+        /* C standard library functions */
+        if (!Config.Mocking.MockCStdLib) {
+            if (Config.General.Verbose) {
+                *Log_ << util::cl::info()
+                      << "skipping C standard library function \"";
+                Decl->printQualifiedName(*Log_);
+                *Log_ << "\"\n";
+            }
+
+            return;
+        }
+    }
+
+    Buffer_.clear();
+    Decl->printQualifiedName(OS);
+
+    if (auto Entry = Blacklist_->match(Buffer_)) {
+        if (Config.General.Verbose) {
+            *Log_ << util::cl::info() << "skipping \"" << Buffer_
+                  << "\" due to blacklist entry";
+
+            if (util::glob::isPattern(*Entry))
+                *Log_ << " \"" << *Entry << "\"";
+
+            *Log_ << "\n";
+        }
+
+        return;
+    }
+
+    if (isVisited(Decl))
+        return;
+
+    if (Decl->isVariadic()) {
+        if (!Config.Mocking.MockVariadicFunctions)
+            return;
+
+        if (Decl->param_empty()) {
+            auto Error = llvm::raw_string_ostream(Output_->Error);
+
+            Error << "unable to mock variadic function \"";
+            Decl->printQualifiedName(Error);
+            Error << "\" with no parameters";
+            return;
+        }
+    }
+
+    Output_->FunctionDecls.push_back(Decl);
+}
+
+bool ExprHandler::isVisited(const clang::DeclaratorDecl *Decl)
+{
+    return !Visited_.insert(Decl->getID()).second;
+}
+
+void ExprHandler::doVisitCallExpr(const clang::CallExpr *CallExpr)
+{
+    const auto *Decl = CallExpr->getDirectCallee();
+
+    dispatch(CallExpr, Decl);
+}
+
+void ExprHandler::doVisitCXXConstructExpr(
+    const clang::CXXConstructExpr *ConstructExpr)
+{
+    const auto *Decl = ConstructExpr->getConstructor();
+
+    dispatch(ConstructExpr, Decl);
+    dispatch(ConstructExpr, Decl->getParent()->getDestructor());
+}
+
+void ExprHandler::doVisitDeclRefExpr(const clang::DeclRefExpr *DeclRefExpr)
+{
+    llvm::raw_string_ostream OS(Buffer_);
+
+    const auto *Decl = clang::dyn_cast<clang::VarDecl>(DeclRefExpr->getDecl());
+    if (!Decl)
+        return;
+
+    //    if (!Decl->hasGlobalStorage())
+    //        return;
+    //
+    if (!Decl->isExternallyVisible())
+        return;
+
+    //    if (Decl->getDefinition())
+    //        return;
+
+    if (const auto *CXXRecordDecl = Decl->getType()->getAsCXXRecordDecl()) {
+        /*
+         * On encountering an external declared object we might have to add
+         * its constructor to the list of functions that need to be mocked.
+         */
+        for (const auto *Decl : CXXRecordDecl->ctors()) {
+            if (!Decl->isDefined()) {
+                dispatch(DeclRefExpr, Decl);
+                dispatch(DeclRefExpr, CXXRecordDecl->getDestructor());
+            }
+        }
+    }
+
+    Buffer_.clear();
+    Decl->printQualifiedName(OS);
+
+    if (InternalBlacklist.count(Buffer_)) {
+        if (getConfig().General.Verbose) {
+            *Log_ << util::cl::info() << "skipping \"" << Buffer_
+                  << "\" due to internal blacklist entry\n";
+        }
+        return;
+    }
+
+    /* Glob patterns of the blacklist only apply to functions */
+    if (Blacklist_->contains(Buffer_)) {
+        if (getConfig().General.Verbose) {
+            *Log_ << util::cl::info() << "skipping \"" << Buffer_
+                  << "\" due to blacklist entry\n";
+        }
+
+        return;
+    }
+
+    if (isVisited(Decl))
+        return;
+
+    Output_->VarDecls.push_back(Decl);
+}
+
+std::string getMockName(const clang::FunctionDecl *Decl)
+{
+    switch (Decl->getKind()) {
+    case clang::Decl::CXXConstructor:
+        return "constructor";
+    case clang::Decl::CXXDestructor:
+        return "destructor";
+    case clang::Decl::CXXConversion:
+        /* FIXME: implement conversion handling */
+        return std::string();
+    default:
+        break;
+    }
+
+    switch (Decl->getOverloadedOperator()) {
+    case clang::OO_None:
+        return Decl->getNameAsString();
+    case clang::OO_New:
+        return "op_new";
+    case clang::OO_Delete:
+        return "op_delete";
+    case clang::OO_Array_New:
+        return "op_array_new";
+    case clang::OO_Array_Delete:
+        return "op_array_delete";
+    case clang::OO_Plus:
+        return "op_plus";
+    case clang::OO_Minus:
+        return "op_minus";
+    case clang::OO_Star:
+        return "op_star";
+    case clang::OO_Slash:
+        return "op_slash";
+    case clang::OO_Percent:
+        return "op_percent";
+    case clang::OO_Caret:
+        return "op_caret";
+    case clang::OO_Amp:
+        return "op_amp";
+    case clang::OO_Pipe:
+        return "op_pipe";
+    case clang::OO_Tilde:
+        return "op_tilde";
+    case clang::OO_Exclaim:
+        return "op_exclaim";
+    case clang::OO_Equal:
+        return "op_equal";
+    case clang::OO_Less:
+        return "op_less";
+    case clang::OO_Greater:
+        return "op_greater";
+    case clang::OO_PlusEqual:
+        return "op_plus_equal";
+    case clang::OO_MinusEqual:
+        return "op_minus_equal";
+    case clang::OO_StarEqual:
+        return "op_star_equal";
+    case clang::OO_SlashEqual:
+        return "op_slash_equal";
+    case clang::OO_PercentEqual:
+        return "op_percent_equal";
+    case clang::OO_CaretEqual:
+        return "op_caret_equal";
+    case clang::OO_AmpEqual:
+        return "op_amp_equal";
+    case clang::OO_PipeEqual:
+        return "op_pipe_equal";
+    case clang::OO_LessLess:
+        return "op_less_less";
+    case clang::OO_GreaterGreater:
+        return "op_greater_greater";
+    case clang::OO_LessLessEqual:
+        return "op_less_less_equal";
+    case clang::OO_GreaterGreaterEqual:
+        return "op_greater_greater_equal";
+    case clang::OO_EqualEqual:
+        return "op_equal_equal";
+    case clang::OO_ExclaimEqual:
+        return "op_exclaim_equal";
+    case clang::OO_LessEqual:
+        return "op_less_equal";
+    case clang::OO_GreaterEqual:
+        return "op_greater_equal";
+    case clang::OO_Spaceship:
+        return "op_spaceship";
+    case clang::OO_AmpAmp:
+        return "op_amp_amp";
+    case clang::OO_PipePipe:
+        return "op_pipe_pipe";
+    case clang::OO_PlusPlus:
+        return "op_plus_plus";
+    case clang::OO_MinusMinus:
+        return "op_minus_minus";
+    case clang::OO_Comma:
+        return "op_comma";
+    case clang::OO_ArrowStar:
+        return "op_arrow_star";
+    case clang::OO_Arrow:
+        return "op_arrow";
+    case clang::OO_Call:
+        return "op_call";
+    case clang::OO_Subscript:
+        return "op_subscript";
+    default:
+        llvm_unreachable("unknown overloaded operator");
+        break;
+    }
+
+    return std::string();
+}
+
+const clang::DeclContext *getScope(const clang::DeclContext *Context)
+{
+    /*
+     * Transparent contexts like linkage specifications ("extern "C" {}")
+     * do not show up in qualified names and the contexts of functions
+     * declared at block scope cannot be mocked, so skip them.
+     */
+    while (!clang::isa<clang::TranslationUnitDecl,
+                       clang::NamespaceDecl,
+                       clang::RecordDecl>(Context))
+        Context = Context->getParent();
+
+    return Context->getPrimaryContext();
+}
+
+enum MockModel::Context::Kind getKind(const clang::DeclContext *Context)
+{
+    if (clang::isa<clang::NamespaceDecl>(Context))
+        return MockModel::Context::KIND_NAMESPACE;
+
+    const auto *Decl = clang::cast<clang::RecordDecl>(Context);
+    if (Decl->isUnion())
+        return MockModel::Context::KIND_UNION;
+
+    if (Decl->isClass())
+        return MockModel::Context::KIND_CLASS;
+
+    return MockModel::Context::KIND_STRUCT;
+}
+
+enum MockModel::Function::Kind getKind(const clang::FunctionDecl *Decl)
+{
+    switch (Decl->getKind()) {
+    case clang::Decl::CXXMethod:
+        return MockModel::Function::KIND_METHOD;
+    case clang::Decl::CXXConstructor:
+        return MockModel::Function::KIND_CONSTRUCTOR;
+    case clang::Decl::CXXDestructor:
+        return MockModel::Function::KIND_DESTRUCTOR;
+    case clang::Decl::CXXConversion:
+        return MockModel::Function::KIND_CONVERSION;
+    default:
+        return MockModel::Function::KIND_FUNCTION;
+    }
+}
+
+enum MockModel::Function::Access getAccess(clang::AccessSpecifier Access)
+{
+    switch (Access) {
+    case clang::AccessSpecifier::AS_public:
+        return MockModel::Function::ACCESS_PUBLIC;
+    case clang::AccessSpecifier::AS_protected:
+        return MockModel::Function::ACCESS_PROTECTED;
+    case clang::AccessSpecifier::AS_private:
+        return MockModel::Function::ACCESS_PRIVATE;
+    default:
+        return MockModel::Function::ACCESS_NONE;
+    }
+}
+
+enum MockModel::Function::RefQualifier
+getRefQualifier(const clang::CXXMethodDecl *Decl)
+{
+    switch (Decl->getRefQualifier()) {
+    case clang::RefQualifierKind::RQ_LValue:
+        return MockModel::Function::REFQUALIFIER_LVALUE;
+    case clang::RefQualifierKind::RQ_RValue:
+        return MockModel::Function::REFQUALIFIER_RVALUE;
+    case clang::RefQualifierKind::RQ_None:
+    default:
+        return MockModel::Function::REFQUALIFIER_NONE;
+    }
+}
+
+/* Number of recorded expressions needed to resolve them in parallel */
+constexpr size_t ParallelThreshold = 1 << 15;
+constexpr size_t ChunkSize = 1 << 12;
+
+bool isParallelizable(const clang::ASTContext &Context,
+                      unsigned int Threads,
+                      size_t Count)
+{
+    /*
+     * Resolving expressions only reads the AST, apart from information
+     * computed on demand: C++ name lookups and declarations loaded lazily
+     * from external sources like precompiled headers, preambles or AST
+     * files modify the AST behind the scenes.
+     */
+    if (Count < ParallelThreshold || Threads < 2)
+        return false;
+
+    return !Context.getLangOpts().CPlusPlus && !Context.getExternalSource();
+}
+
+void append(ExprHandler::Result &Output,
+            const ExprHandler::Result &Result,
+            llvm::DenseSet<const clang::Decl *> &Seen)
+{
+    for (const auto *Decl : Result.FunctionDecls) {
+        if (Seen.insert(Decl).second)
+            Output.FunctionDecls.push_back(Decl);
+    }
+
+    for (const auto *Decl : Result.VarDecls) {
+        if (Seen.insert(Decl).second)
+            Output.VarDecls.push_back(Decl);
+    }
+}
+
+void resolveParallel(llvm::ArrayRef<const clang::Expr *> Exprs,
+                     const Config &Config,
+                     const util::glob::Matcher &Blacklist,
+                     unsigned int Threads,
+                     ExprHandler::Result &Output)
+{
+    /*
+     * Variables are resolved serially afterwards as the linkage of a
+     * declaration is computed on first use and cached within the AST.
+     */
+    auto Calls = std::vector<const clang::Expr *>();
+    auto Refs = std::vector<const clang::Expr *>();
+
+    Calls.reserve(Exprs.size());
+
+    for (const auto *Expr : Exprs) {
+        if (clang::isa<clang::DeclRefExpr>(Expr))
+            Refs.push_back(Expr);
+        else
+            Calls.push_back(Expr);
+    }
+
+    auto Count = (Calls.size() + ChunkSize - 1) / ChunkSize;
+    auto Items = std::vector<size_t>(Count);
+    std::iota(Items.begin(), Items.end(), 0);
+
+    auto Results = std::vector<ExprHandler::Result>(Count);
+    auto Logs = std::vector<std::string>(Count);
+
+    /*
+     * Each chunk is resolved on its own, so the result does not depend on
+     * which worker processed it.
+     */
+    auto Pool = util::ThreadPool(Threads);
+    auto Handlers = std::vector<std::optional<ExprHandler>>(Pool.size());
+
+    Pool.run(Items, [&](size_t Item, unsigned int Worker) {
+        auto &Handler = Handlers[Worker];
+        if (!Handler)
+            Handler.emplace(Config, Blacklist);
+
+        auto Begin = Item * ChunkSize;
+        auto Size = std::min(ChunkSize, Calls.size() - Begin);
+        auto Log = llvm::raw_string_ostream(Logs[Item]);
+
+        Handler->run(llvm::ArrayRef(Calls).slice(Begin, Size),
+                     Results[Item],
+                     Log);
+    });
+
+    /* Merge in source order, keeping only the first use of each decl */
+    llvm::DenseSet<const clang::Decl *> Seen;
+
+    for (size_t i = 0; i < Count; ++i) {
+        llvm::errs() << Logs[i];
+
+        /* Report the first error in source order like the serial run */
+        if (!Results[i].Error.empty()) {
+            Output.Error = std::move(Results[i].Error);
+            return;
+        }
+
+        append(Output, Results[i], Seen);
+    }
+
+    auto Result = ExprHandler::Result();
+    ExprHandler(Config, Blacklist).run(Refs, Result, llvm::errs());
+
+    Output.Error = std::move(Result.Error);
+    append(Output, Result, Seen);
+}
+
+} // namespace
+
+ModelCollector::ModelCollector(std::shared_ptr<const Config> Config,
+                               std::optional<MockModel> *Model)
+    : ASTConsumer(),
+      Config_(std::move(Config)),
+      Model_(Model),
+      ASTContext_(nullptr),
+      Exprs_(),
+      FunctionDecls_(),
+      VarDecls_(),
+      Contexts_(),
+      Threads_(1),
+      Streamed_(false)
+{
+    FunctionDecls_.reserve(32);
+    VarDecls_.reserve(32);
+}
+
+void ModelCollector::Initialize(clang::ASTContext &Context)
+{
+    ASTContext_ = &Context;
+}
+
+bool ModelCollector::HandleTopLevelDecl(clang::DeclGroupRef Group)
+{
+    /*
+     * With delayed template parsing (e.g. for MSVC compatibility) the
+     * bodies of function templates are only parsed at the end of the
+     * translation unit, so everything gets traversed at once.
+     */
+    if (ASTContext_->getLangOpts().DelayedTemplateParsing)
+        return true;
+
+    auto Visitor = ASTVisitor(ASTContext_->getSourceManager(), &Exprs_);
+
+    for (auto *Decl : Group) {
+        if (Visitor.isInMainFile(Decl))
+            Visitor.TraverseDecl(Decl);
+    }
+
+    Streamed_ = true;
+
+    return true;
+}
+
+void ModelCollector::HandleTranslationUnit(clang::ASTContext &Context)
+{
+    ASTContext_ = &Context;
+
+    /* Translation units loaded from AST files are not streamed */
+    if (!Streamed_)
+        ASTVisitor::run(Context, Exprs_);
+
+    /*
+     * Whether a function is defined is only known at the end of the
+     * translation unit, e.g. after pending template instantiations were
+     * performed or for functions defined after their first use.
+     */
+    auto Result = ExprHandler::Result();
+    auto Blacklist = util::glob::Matcher();
+
+    for (const auto &Name : Config_->Mocking.Blacklist) {
+        if (auto Error = Blacklist.add(Name)) {
+            Result.Error = llvm::toString(std::move(Error));
+            break;
+        }
+    }
+
+    if (Result.Error.empty()) {
+        if (isParallelizable(Context, Threads_, Exprs_.size()))
+            resolveParallel(Exprs_, *Config_, Blacklist, Threads_, Result);
+        else
+            ExprHandler(*Config_, Blacklist).run(Exprs_, Result, llvm::errs());
+    }
+
+    /* Fail the translation unit, other jobs might still be running */
+    if (!Result.Error.empty()) {
+        auto &Diags = Context.getDiagnostics();
+        auto ID = Diags.getCustomDiagID(clang::DiagnosticsEngine::Error, "%0");
+
+        Diags.Report(ID) << Result.Error;
+        return;
+    }
+
+    FunctionDecls_ = std::move(Result.FunctionDecls);
+    VarDecls_ = std::move(Result.VarDecls);
+
+    Model_->emplace();
+    (*Model_)->setCPlusPlus(Context.getLangOpts().CPlusPlus);
+
+    for (const auto *Decl : FunctionDecls_)
+        addFunction(Decl);
+
+    for (const auto *Decl : VarDecls_)
+        addVariable(Decl);
+}
+
+bool ModelCollector::shouldSkipFunctionBody(clang::Decl *Decl)
+{
+    /*
+     * Only asked if skipping function bodies is enabled. Skipped functions
+     * are still definitions, so "isDefined" does not change its meaning.
+     * Clang never skips bodies required for constant evaluation or
+     * return type deduction.
+     */
+    const auto &SourceManager = ASTContext_->getSourceManager();
+
+    return !SourceManager.isInMainFile(Decl->getLocation());
+}
+
+uint32_t ModelCollector::addContext(const clang::DeclContext *Context)
+{
+    Context = getScope(Context);
+    if (Context->isTranslationUnit())
+        return 0;
+
+    auto It = Contexts_.find(Context);
+    if (It != Contexts_.end())
+        return It->second;
+
+    auto Item = MockModel::Context();
+    Item.Kind = getKind(Context);
+    Item.Name = clang::cast<clang::NamedDecl>(Context)->getNameAsString();
+    Item.Parent = addContext(Context->getParent());
+
+    auto Index = (*Model_)->addContext(std::move(Item));
+    Contexts_.try_emplace(Context, Index);
+
+    return Index;
+}
+
+void ModelCollector::addFunction(const clang::FunctionDecl *Decl)
+{
+    auto Policy = clang::PrintingPolicy(ASTContext_->getLangOpts());
+    auto ReturnType = Decl->getReturnType();
+
+    auto Item = MockModel::Function();
+    Item.Kind = getKind(Decl);
+    Item.Access = getAccess(Decl->getAccess());
+    Item.Name = Decl->getNameAsString();
+    Item.QualifiedName = Decl->getQualifiedNameAsString();
+    Item.MockName = getMockName(Decl);
+    Item.ReturnType = makeType(ReturnType);
+    Item.Context = addContext(Decl->getDeclContext());
+    Item.IsExternC = Decl->isExternC();
+    Item.IsVariadic = Decl->isVariadic();
+    Item.ReturnsVoid = ReturnType->isVoidType();
+    Item.ReturnsPointer = ReturnType->isPointerType();
+
+    llvm::raw_string_ostream OS(Item.Declaration);
+    Decl->print(OS, Policy);
+
+    if (const auto *MethodDecl = clang::dyn_cast<clang::CXXMethodDecl>(Decl)) {
+        auto Type = MethodDecl->getType();
+        const auto *FuncProtoType = Type->castAs<clang::FunctionProtoType>();
+
+        Item.IsConst = FuncProtoType->isConst();
+        Item.RefQualifier = getRefQualifier(MethodDecl);
+
+        /*
+         * Seems like destructors can get the noexcept attribute attached
+         * automatically which can cause a warning if we manually attach it
+         * to the definition.
+         */
+        bool IsNoexcept = FuncProtoType->hasNoexceptExceptionSpec();
+        Item.IsNoexcept =
+            IsNoexcept && Decl->getExceptionSpecSourceRange().isValid();
+    }
+
+    auto Parameters = Decl->parameters();
+    Item.Parameters.reserve(Parameters.size());
+
+    for (unsigned int i = 0, Size = Parameters.size(); i < Size; ++i) {
+        auto Type = Parameters[i]->getType();
+        auto Pointee = Type->getPointeeType();
+
+        auto Parameter = MockModel::Parameter();
+
+        /* Ensure that every parameter will have a name associated to it */
+        Parameter.Name = Parameters[i]->getNameAsString();
+        if (Parameter.Name.empty())
+            Parameter.Name = "arg" + std::to_string(i + 1);
+
+        Parameter.IsPointer = Type->isPointerType();
+        Parameter.IsRValueReference = Type->isRValueReferenceType();
+        Parameter.IsTypedef = Type->isTypedefNameType();
+
+        if (!Pointee.isNull()) {
+            Parameter.IsFunctionPointer = Pointee->isFunctionType();
+
+            /* Treat non-const pointers to data as output parameters */
+            Parameter.IsOutput = !Pointee->isVoidType()
+                                 && !Pointee->isFunctionType()
+                                 && !Pointee.isConstQualified();
+        }
+
+        /* Top-level qualifiers are not part of the function's type */
+        Type.removeLocalConst();
+
+        auto Canonical = Type.getCanonicalType();
+        Canonical.removeLocalConst();
+
+        Parameter.Declarator =
+            makeDeclarator(Type, ASTContext_->getPrintingPolicy());
+        Parameter.Type = makeType(Canonical);
+
+        Item.Parameters.push_back(std::move(Parameter));
+    }
+
+    (*Model_)->addFunction(std::move(Item));
+}
+
+void ModelCollector::addVariable(const clang::VarDecl *Decl)
+{
+    auto Type = Decl->getType();
+
+    /* Objects can only be defined without an initializer */
+    if (const auto *CXXRecordDecl = Type->getAsCXXRecordDecl()) {
+        if (!CXXRecordDecl->hasDefaultConstructor())
+            return;
+    }
+
+    auto Canonical = Type.getCanonicalType();
+    auto Policy = clang::PrintingPolicy(ASTContext_->getLangOpts());
+
+    auto Item = MockModel::Variable();
+    Item.QualifiedName = Decl->getQualifiedNameAsString();
+    Item.Declarator = makeDeclarator(Canonical, Policy);
+
+    /*
+     * Keep the tag keywords of the type for C++, as its name might be
+     * hidden by a function of the same name, e.g. "struct stat".
+     */
+    Policy.SuppressTagKeyword = false;
+    Policy.Bool = true;
+
+    Item.CXXDeclarator = makeDeclarator(Canonical, Policy);
+
+    (*Model_)->addVariable(std::move(Item));
+}
+
+MockModel::Type ModelCollector::makeType(clang::QualType Type) const
+{
+    auto Canonical = Type.getCanonicalType();
+    auto Policy = clang::PrintingPolicy(ASTContext_->getLangOpts());
+
+    auto Item = MockModel::Type();
+    Item.Spelling = Canonical.getAsString(Policy);
+
+    Policy.SuppressTagKeyword = true;
+    Policy.Bool = true;
+
+    Item.CXXSpelling = Canonical.getAsString(Policy);
+
+    return Item;
+}
+
+MockModel::Declarator
+ModelCollector::makeDeclarator(clang::QualType Type,
+                               const clang::PrintingPolicy &Policy) const
+{
+    /*
+     * Print the type with a placeholder which cannot be part of any type
+     * and split it there. Function pointers and arrays surround the name
+     * with their type, e.g.:
+     *      void *(*func)(void (*)(int, int))
+     *             ^~~~
+     */
+    constexpr llvm::StringLiteral Placeholder = "\x01";
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    Type.print(OS, Policy, Placeholder);
+
+    auto [Head, Tail] = llvm::StringRef(OS.str()).split(Placeholder);
+
+    auto Item = MockModel::Declarator();
+    Item.Head = Head.str();
+    Item.Tail = Tail.str();
+
+    return Item;
+}
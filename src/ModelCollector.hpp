@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODELCOLLECTOR_HPP_
+#define MODELCOLLECTOR_HPP_
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclGroup.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/PrettyPrinter.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include "Config.hpp"
+#include "MockModel.hpp"
+
+/*
+ * Extracts the mock model from a parsed translation unit. All undefined
+ * functions and variables used within the main file are collected in the
+ * order of their first use. Only the mocking settings of the configuration
+ * have an effect on the extracted model. As only uses within the main file
+ * matter, function bodies outside of it can be skipped while parsing.
+ * The expressions of the main file are recorded while it is still being
+ * parsed and get resolved once the whole translation unit is available.
+ * The calls of very large C translation units can be resolved by multiple
+ * threads, which must not be busy with other translation units.
+ */
+
+class ModelCollector : public clang::ASTConsumer {
+public:
+    ModelCollector(std::shared_ptr<const Config> Config,
+                   std::optional<MockModel> *Model);
+
+    void Initialize(clang::ASTContext &Context) override;
+    bool HandleTopLevelDecl(clang::DeclGroupRef Group) override;
+    void HandleTranslationUnit(clang::ASTContext &Context) override;
+    bool shouldSkipFunctionBody(clang::Decl *Decl) override;
+
+    inline void setThreads(unsigned int Count);
+    inline const Config &getConfig() const;
+
+private:
+    uint32_t addContext(const clang::DeclContext *Context);
+    void addFunction(const clang::FunctionDecl *Decl);
+    void addVariable(const clang::VarDecl *Decl);
+
+    MockModel::Type makeType(clang::QualType Type) const;
+    MockModel::Declarator
+    makeDeclarator(clang::QualType Type,
+                   const clang::PrintingPolicy &Policy) const;
+
+    std::shared_ptr<const Config> Config_;
+    std::optional<MockModel> *Model_;
+    const clang::ASTContext *ASTContext_;
+    std::vector<const clang::Expr *> Exprs_;
+    std::vector<const clang::FunctionDecl *> FunctionDecls_;
+    std::vector<const clang::VarDecl *> VarDecls_;
+    llvm::DenseMap<const clang::DeclContext *, uint32_t> Contexts_;
+    unsigned int Threads_;
+    bool Streamed_;
+};
+
+inline void ModelCollector::setThreads(unsigned int Count)
+{
+    Threads_ = Count;
+}
+
+inline const Config &ModelCollector::getConfig() const
+{
+    return *Config_;
+}
+
+#endif /* MODELCOLLECTOR_HPP_ */
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OutputManifest.hpp"
+
+#include <chrono>
+
+#include <llvm/Support/Errc.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "util/FileSystem.hpp"
+
+namespace {
+
+/*
+ * Manifests of older formats are not trusted, e.g. version 1 manifests do
+ * not record any system headers.
+ */
+constexpr int64_t Version = 2;
+
+std::error_code getStatus(llvm::StringRef Path, OutputManifest::File &File)
+{
+    using Nanoseconds = std::chrono::nanoseconds;
+
+    llvm::sys::fs::file_status Status;
+
+    auto Code = llvm::sys::fs::status(Path, Status);
+    if (Code)
+        return Code;
+
+    auto Time = Status.getLastModificationTime().time_since_epoch();
+
+    File.Path = Path.str();
+    File.Time = std::chrono::duration_cast<Nanoseconds>(Time).count();
+    File.Size = Status.getSize();
+    File.Inode = Status.getUniqueID().getFile();
+
+    return std::error_code();
+}
+
+} // namespace
+
+std::filesystem::path
+OutputManifest::getPath(const std::filesystem::path &Output)
+{
+    /*
+     * Keep the manifest hidden next to the output, e.g.
+     *      mocks/a.inc -> mocks/.a.inc.ccmock-manifest.json
+     */
+    auto Path = Output;
+    Path.replace_filename("." + Output.filename().native()
+                          + ".ccmock-manifest.json");
+
+    return Path;
+}
+
+void OutputManifest::load(const std::filesystem::path &Path,
+                          std::string &Error)
+{
+    /*
+     * Example of a manifest:
+     *      {
+     *          "version": 2,
+     *          "key": "0a4d55a8d778e5022fab701977c5d840bbc486d0",
+     *          "command": [ "cc", "-Iinclude", "-c", "src/a.c" ],
+     *          "files": [
+     *              {
+     *                  "path": "/src/a.c",
+     *                  "mtime": 1700000000123456789,
+     *                  "size": 1024,
+     *                  "inode": 1234567
+     *              }
+     *          ]
+     *      }
+     */
+    llvm::raw_string_ostream OS(Error);
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Path.native());
+    if (!MemBuffer) {
+        OS << "failed to open \"" << Path.native()
+           << "\": " << MemBuffer.getError().message();
+        return;
+    }
+
+    auto Value = llvm::json::parse(MemBuffer.get()->getBuffer());
+    if (!Value) {
+        OS << "failed to parse \"" << Path.native()
+           << "\": " << llvm::toString(Value.takeError());
+        return;
+    }
+
+    const auto *Object = Value->getAsObject();
+    if (!Object) {
+        OS << "\"" << Path.native() << "\": expected an object";
+        return;
+    }
+
+    if (Object->getInteger("version") != Version) {
+        OS << "\"" << Path.native() << "\": unsupported version";
+        return;
+    }
+
+    auto Key = Object->getString("key");
+    const auto *Files = Object->getArray("files");
+
+    if (!Key || !Files) {
+        OS << "\"" << Path.native() << "\": missing \"key\" or \"files\"";
+        return;
+    }
+
+    Key_ = Key->str();
+    Command_.clear();
+    Files_.clear();
+
+    if (const auto *Command = Object->getArray("command")) {
+        for (const auto &Arg : *Command) {
+            if (auto Str = Arg.getAsString())
+                Command_.push_back(Str->str());
+        }
+    }
+
+    Files_.reserve(Files->size());
+
+    for (const auto &Item : *Files) {
+        const auto *Entry = Item.getAsObject();
+        if (!Entry) {
+            OS << "\"" << Path.native() << "\": invalid file entry";
+            return;
+        }
+
+        auto File = Entry->getString("path");
+        auto Time = Entry->getInteger("mtime");
+        auto Size = Entry->getInteger("size");
+        auto Inode = Entry->getInteger("inode");
+
+        if (!File || !Time || !Size || !Inode) {
+            OS << "\"" << Path.native() << "\": invalid file entry";
+            return;
+        }
+
+        auto Value = OutputManifest::File();
+        Value.Path = File->str();
+        Value.Time = *Time;
+        Value.Size = static_cast<uint64_t>(*Size);
+        Value.Inode = static_cast<uint64_t>(*Inode);
+
+        Files_.push_back(std::move(Value));
+    }
+}
+
+void OutputManifest::save(const std::filesystem::path &Path,
+                          std::string &Error) const
+{
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    {
+        auto JSON = llvm::json::OStream(OS, 4);
+
+        JSON.object([&]() {
+            JSON.attribute("version", Version);
+            JSON.attribute("key", Key_);
+
+            JSON.attributeArray("command", [&]() {
+                for (const auto &Arg : Command_)
+                    JSON.value(Arg);
+            });
+
+            JSON.attributeArray("files", [&]() {
+                for (const auto &File : Files_) {
+                    JSON.object([&]() {
+                        JSON.attribute("path", File.Path);
+                        JSON.attribute("mtime", File.Time);
+                        JSON.attribute("size", static_cast<int64_t>(File.Size));
+                        JSON.attribute("inode",
+                                       static_cast<int64_t>(File.Inode));
+                    });
+                }
+            });
+        });
+    }
+
+    OS << "\n";
+
+    /* Processes sharing an output directory might write it concurrently */
+    (void) util::fs::writeIfChanged(Path.native(), OS.str(), Error);
+}
+
+void OutputManifest::add(llvm::StringRef Path, std::string &Error)
+{
+    auto File = OutputManifest::File();
+
+    auto Code = getStatus(Path, File);
+    if (Code) {
+        llvm::raw_string_ostream OS(Error);
+        OS << "\"" << Path << "\": " << Code.message();
+        return;
+    }
+
+    Files_.push_back(std::move(File));
+}
+
+bool OutputManifest::isUpToDate(llvm::StringRef Key) const
+{
+    if (Key_.empty() || Key_ != Key)
+        return false;
+
+    for (const auto &Item : Files_) {
+        auto File = OutputManifest::File();
+
+        if (getStatus(Item.Path, File))
+            return false;
+
+        if (File.Time != Item.Time || File.Size != Item.Size
+            || File.Inode != Item.Inode)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OUTPUTMANIFEST_HPP_
+#define OUTPUTMANIFEST_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+
+/*
+ * Records all files an output depends on together with their status at
+ * the time the output was written. The output is up to date as long as
+ * the key describing everything else (e.g. the configuration) and the
+ * status of all files did not change. Checking this only requires
+ * calling "stat" for each recorded file.
+ */
+
+class OutputManifest {
+public:
+    struct File {
+    public:
+        std::string Path;
+        int64_t Time;
+        uint64_t Size;
+        uint64_t Inode;
+    };
+
+    OutputManifest() = default;
+
+    static std::filesystem::path getPath(const std::filesystem::path &Output);
+
+    void load(const std::filesystem::path &Path, std::string &Error);
+    void save(const std::filesystem::path &Path, std::string &Error) const;
+
+    inline void setKey(std::string Key);
+    inline void setCommand(std::vector<std::string> Args);
+    void add(llvm::StringRef Path, std::string &Error);
+
+    bool isUpToDate(llvm::StringRef Key) const;
+
+    inline const std::string &getKey() const;
+    inline llvm::ArrayRef<std::string> getCommand() const;
+    inline llvm::ArrayRef<File> getFiles() const;
+
+private:
+    std::string Key_;
+    std::vector<std::string> Command_;
+    std::vector<File> Files_;
+};
+
+inline void OutputManifest::setKey(std::string Key)
+{
+    Key_ = std::move(Key);
+}
+
+inline void OutputManifest::setCommand(std::vector<std::string> Args)
+{
+    Command_ = std::move(Args);
+}
+
+inline const std::string &OutputManifest::getKey() const
+{
+    return Key_;
+}
+
+inline llvm::ArrayRef<std::string> OutputManifest::getCommand() const
+{
+    return llvm::ArrayRef(Command_);
+}
+
+inline llvm::ArrayRef<OutputManifest::File> OutputManifest::getFiles() const
+{
+    return llvm::ArrayRef(Files_);
+}
+
+#endif /* OUTPUTMANIFEST_HPP_ */
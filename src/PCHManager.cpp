@@ -0,0 +1,601 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PCHManager.hpp"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringSwitch.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include "MockAction.hpp"
+#include "util/commandline.hpp"
+
+namespace {
+
+std::string makeAbsolute(llvm::StringRef Path, llvm::StringRef Directory)
+{
+    auto Result = llvm::SmallString<256>(Path);
+
+    if (llvm::sys::path::is_relative(Result)) {
+        Result = Directory;
+        llvm::sys::path::append(Result, Path);
+    }
+
+    llvm::sys::path::remove_dots(Result, true);
+
+    return Result.str().str();
+}
+
+llvm::StringRef getHeaderLanguage(llvm::ArrayRef<std::string> Args,
+                                  llvm::StringRef File)
+{
+    llvm::StringRef Language;
+
+    for (size_t i = 1, Size = Args.size(); i + 1 < Size; ++i) {
+        if (Args[i] == "-x")
+            Language = Args[i + 1];
+    }
+
+    if (Language.empty()) {
+        Language = llvm::StringSwitch<llvm::StringRef>(
+                       llvm::sys::path::extension(File))
+                       .Case(".c", "c")
+                       .Cases(".C", ".cc", ".cp", ".cpp", "c++")
+                       .Cases(".CPP", ".c++", ".cxx", "c++")
+                       .Default("");
+    }
+
+    /* Other languages (e.g. Objective-C) are not supported */
+    return llvm::StringSwitch<llvm::StringRef>(Language)
+        .Case("c", "c-header")
+        .Case("c++", "c++-header")
+        .Default("");
+}
+
+void scanIncludes(llvm::StringRef Data,
+                  llvm::StringRef Directory,
+                  std::vector<std::string> &Includes)
+{
+    /*
+     * Collect the include directives at the very beginning of a file,
+     * only interrupted by empty lines and comments. Anything else might
+     * affect the included headers and ends the sequence.
+     *
+     * Example:
+     *      / * Copyright ... * /           -> skipped
+     *      #include <stdio.h>              -> #include <stdio.h>
+     *      #include "list.h"               -> #include "/src/util/list.h"
+     *      #define NDEBUG                  -> end of sequence
+     */
+    auto Comment = false;
+    std::string Text;
+
+    while (!Data.empty()) {
+        llvm::StringRef Line;
+        std::tie(Line, Data) = Data.split('\n');
+
+        Text.clear();
+
+        for (size_t i = 0, Size = Line.size(); i < Size; ++i) {
+            auto Rest = Line.substr(i);
+
+            if (Comment) {
+                if (Rest.startswith("*/")) {
+                    Comment = false;
+                    ++i;
+                }
+
+                continue;
+            }
+
+            if (Rest.startswith("//"))
+                break;
+
+            if (Rest.startswith("/*")) {
+                Comment = true;
+                Text += ' ';
+                ++i;
+                continue;
+            }
+
+            Text += Line[i];
+        }
+
+        auto Directive = llvm::StringRef(Text).trim();
+        if (Directive.empty())
+            continue;
+
+        if (!Directive.consume_front("#"))
+            return;
+
+        Directive = Directive.ltrim();
+        if (!Directive.consume_front("include"))
+            return;
+
+        Directive = Directive.ltrim();
+        if (Directive.size() < 3)
+            return;
+
+        char Close;
+
+        switch (Directive.front()) {
+        case '<':
+            Close = '>';
+            break;
+        case '"':
+            Close = '"';
+            break;
+        default:
+            /* E.g. "#include_next" or macro expansions */
+            return;
+        }
+
+        auto Name = Directive.drop_front().drop_back();
+        if (Directive.back() != Close || Name.contains(Close))
+            return;
+
+        /*
+         * The PCH is built from a header in another directory, so refer
+         * to headers next to the input file by their absolute path.
+         */
+        if (Close == '"') {
+            auto Path = makeAbsolute(Name, Directory);
+
+            if (llvm::sys::fs::exists(Path)) {
+                Includes.push_back("#include \"" + Path + "\"");
+                continue;
+            }
+        }
+
+        Includes.push_back(Directive.str().insert(0, "#include "));
+    }
+}
+
+bool isForcedInclude(llvm::StringRef Arg)
+{
+    return Arg.startswith("-include") && Arg != "-include-pch";
+}
+
+} // namespace
+
+PCHManager::PCHManager(std::shared_ptr<const Config> Config,
+                       const clang::tooling::CompilationDatabase &Commands,
+                       std::shared_ptr<ResultCache> Cache)
+    : Config_(std::move(Config)),
+      Commands_(&Commands),
+      Cache_(std::move(Cache)),
+      Adjuster_(),
+      Files_(std::make_shared<llvm::StringMap<std::string>>())
+{
+}
+
+void PCHManager::prepare(const Batch &Batch, util::ThreadPool &Pool)
+{
+    auto Groups = std::vector<Group>();
+    llvm::StringMap<size_t> Keys;
+
+    for (const auto &Job : Batch.getJobs())
+        collect(Job, Keys, Groups);
+
+    /*
+     * A PCH only pays off if it is used by several translation units,
+     * unless it has to replace a PCH of GCC.
+     */
+    auto Items = std::vector<size_t>();
+
+    for (size_t i = 0, Size = Groups.size(); i < Size; ++i) {
+        const auto &Item = Groups[i];
+
+        if (Item.Files.size() < 2 && !Item.GCH)
+            continue;
+
+        if (Item.Includes.empty() && Item.ForcedIncludes.empty())
+            continue;
+
+        Items.push_back(i);
+    }
+
+    auto Paths = std::vector<std::string>(Groups.size());
+
+    Pool.run(Items, [&](size_t Item, unsigned int Worker) {
+        (void) Worker;
+
+        Paths[Item] = build(Groups[Item]);
+    });
+
+    auto Files = std::make_shared<llvm::StringMap<std::string>>();
+    size_t Count = 0;
+
+    for (auto Item : Items) {
+        const auto &Group = Groups[Item];
+
+        if (Paths[Item].empty()) {
+            llvm::errs() << util::cl::warning()
+                         << "failed to precompile headers for \""
+                         << Group.Files.front() << "\"";
+
+            if (Group.GCH)
+                llvm::errs() << ", clang cannot read GCC's PCHs";
+
+            llvm::errs() << "\n";
+            continue;
+        }
+
+        for (const auto &File : Group.Files)
+            Files->try_emplace(File, Paths[Item]);
+
+        Count += Group.Files.size();
+    }
+
+    if (Config_->General.Verbose && !Items.empty()) {
+        llvm::errs() << util::cl::info() << "using precompiled headers for "
+                     << Count << " of " << Batch.size()
+                     << " translation units\n";
+    }
+
+    Files_ = std::move(Files);
+}
+
+clang::tooling::ArgumentsAdjuster PCHManager::getArgumentsAdjuster() const
+{
+    /*
+     * Replace the forced includes, which are part of the PCH, with the
+     * PCH itself. Clang requires the PCH to be the first included file.
+     *
+     * Example:
+     *      cc -include pch.h -c a.c -> cc -include-pch <pch> -c a.c
+     */
+    return [Files = Files_](const clang::tooling::CommandLineArguments &Args,
+                            llvm::StringRef Filename) {
+        auto It = Files->find(Filename);
+        if (It == Files->end() || Args.empty())
+            return Args;
+
+        auto Result = clang::tooling::CommandLineArguments();
+        Result.reserve(Args.size() + 2);
+
+        Result.push_back(Args.front());
+        Result.push_back("-include-pch");
+        Result.push_back(It->second);
+
+        for (size_t i = 1, Size = Args.size(); i < Size; ++i) {
+            if (Args[i] == "-include") {
+                ++i;
+                continue;
+            }
+
+            if (isForcedInclude(Args[i]))
+                continue;
+
+            Result.push_back(Args[i]);
+        }
+
+        return Result;
+    };
+}
+
+void PCHManager::collect(const Batch::Job &Job,
+                         llvm::StringMap<size_t> &Keys,
+                         std::vector<Group> &Groups) const
+{
+    using namespace clang::tooling;
+
+    auto Commands = Commands_->getCompileCommands(Job.Input.native());
+
+    /* The adjuster cannot tell multiple commands of the same file apart */
+    if (Commands.size() != 1)
+        return;
+
+    auto &Command = Commands.front();
+
+    auto Args = std::move(Command.CommandLine);
+    if (Adjuster_)
+        Args = Adjuster_(Args, Command.Filename);
+
+    Args = getClangStripOutputAdjuster()(Args, Command.Filename);
+    Args = getClangStripDependencyFileAdjuster()(Args, Command.Filename);
+
+    if (Args.empty())
+        return;
+
+    auto Item = Group();
+    Item.Directory = Command.Directory;
+    Item.Language = getHeaderLanguage(Args, Command.Filename).str();
+
+    if (Item.Language.empty())
+        return;
+
+    auto Input = makeAbsolute(Command.Filename, Command.Directory);
+
+    for (size_t i = 1, Size = Args.size(); i < Size; ++i) {
+        llvm::StringRef Arg = Args[i];
+
+        /* Only one PCH can be used at a time */
+        if (Arg == "-include-pch")
+            return;
+
+        if (isForcedInclude(Arg)) {
+            llvm::StringRef Name = Arg.drop_front(sizeof("-include") - 1);
+            if (Name.empty() && ++i < Size)
+                Name = Args[i];
+
+            /*
+             * Forced includes are searched in the working directory of the
+             * compiler first, which is where the PCH gets built as well.
+             */
+            auto Path = makeAbsolute(Name, Command.Directory);
+            if (!llvm::sys::fs::exists(Path))
+                Path = Name.str();
+
+            /*
+             * Just like GCC, clang looks for a PCH next to a forced
+             * include. It prefers its own PCHs but fails to read GCC's.
+             */
+            if (llvm::sys::fs::exists(Path + ".gch")
+                && !llvm::sys::fs::exists(Path + ".pch"))
+                Item.GCH = true;
+
+            Item.ForcedIncludes.push_back(std::move(Path));
+            continue;
+        }
+
+        /* The generated header replaces the input file */
+        if (!Arg.startswith("-")
+            && makeAbsolute(Arg, Command.Directory) == Input)
+            continue;
+
+        Item.Args.push_back(Arg.str());
+    }
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Input);
+    if (!MemBuffer)
+        return;
+
+    auto Includes = std::vector<std::string>();
+    auto Directory = llvm::sys::path::parent_path(Input);
+
+    scanIncludes(MemBuffer.get()->getBuffer(), Directory, Includes);
+
+    /* Translation units are compatible if they are compiled alike */
+    std::string Key;
+    llvm::raw_string_ostream OS(Key);
+
+    OS << Item.Directory << '\0' << Item.Language << '\0';
+
+    for (const auto &Arg : Item.Args)
+        OS << Arg << '\0';
+
+    OS << '\0';
+
+    for (const auto &File : Item.ForcedIncludes)
+        OS << File << '\0';
+
+    auto Result = Keys.try_emplace(OS.str(), Groups.size());
+    if (Result.second) {
+        Item.Includes = std::move(Includes);
+        Groups.push_back(std::move(Item));
+    }
+
+    auto &Group = Groups[Result.first->second];
+    Group.Files.push_back(Command.Filename);
+
+    /* Keep the include directives all translation units start with */
+    auto Mismatch = std::mismatch(Group.Includes.begin(),
+                                  Group.Includes.end(),
+                                  Includes.begin(),
+                                  Includes.end());
+
+    Group.Includes.erase(Mismatch.first, Group.Includes.end());
+}
+
+std::string PCHManager::build(const Group &Group) const
+{
+    std::string Header;
+    llvm::raw_string_ostream OS(Header);
+
+    for (const auto &File : Group.ForcedIncludes)
+        OS << "#include \"" << File << "\"\n";
+
+    for (const auto &Include : Group.Includes)
+        OS << Include << "\n";
+
+    auto Key = getKey(Group, OS.str());
+    auto HeaderPath = std::filesystem::path();
+    std::string Message;
+
+    /*
+     * Any change of the modification time of the header (including
+     * marking it as recently used) invalidates all PCHs built from it.
+     * Clang even refuses to read these PCHs, which might still be in use
+     * by other processes. An evicted header only causes a rebuild.
+     */
+    if (!Cache_->findFile(Key, HeaderPath)) {
+        Cache_->storeFile(Key, Header, Message);
+        if (!Message.empty()) {
+            llvm::errs() << util::cl::warning() << Message << "\n";
+            return std::string();
+        }
+
+        if (!Cache_->findFile(Key, HeaderPath))
+            return std::string();
+    }
+
+    /*
+     * The key of the PCH covers the status of all files it was built
+     * from, which is only known after building it once.
+     */
+    auto ListKey = getKey(Group, Key);
+    auto Path = std::filesystem::path();
+    std::string List;
+
+    if (Cache_->lookup(ListKey, List)) {
+        auto Dependencies = std::vector<std::string>();
+
+        for (auto Line : llvm::split(List, '\n'))
+            Dependencies.push_back(Line.str());
+
+        auto PCHKey = getPCHKey(Key, Dependencies);
+        if (!PCHKey.empty() && Cache_->lookupFile(PCHKey, Path))
+            return Path.native();
+    }
+
+    auto Dependencies = std::vector<std::string>();
+
+    auto Data = buildPCH(Group, HeaderPath.native(), Dependencies);
+    if (Data.empty())
+        return std::string();
+
+    Dependencies.push_back(HeaderPath.native());
+
+    llvm::sort(Dependencies);
+    Dependencies.erase(std::unique(Dependencies.begin(), Dependencies.end()),
+                       Dependencies.end());
+
+    auto PCHKey = getPCHKey(Key, Dependencies);
+    if (PCHKey.empty())
+        return std::string();
+
+    Cache_->store(ListKey, llvm::join(Dependencies, "\n"), Message);
+    if (Message.empty())
+        Cache_->storeFile(PCHKey, Data, Message);
+
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::warning() << Message << "\n";
+        return std::string();
+    }
+
+    if (!Cache_->lookupFile(PCHKey, Path))
+        return std::string();
+
+    return Path.native();
+}
+
+std::string PCHManager::buildPCH(const Group &Group,
+                                 const std::string &Header,
+                                 std::vector<std::string> &Dependencies) const
+{
+    llvm::SmallString<128> Output;
+
+    auto Code = llvm::sys::fs::createTemporaryFile("ccmock", "pch", Output);
+    if (Code) {
+        llvm::errs() << util::cl::warning()
+                     << "failed to create temporary file: " << Code.message()
+                     << "\n";
+        return std::string();
+    }
+
+    auto Args = Group.Args;
+    Args.push_back("-x");
+    Args.push_back(Group.Language);
+
+    auto Database =
+        clang::tooling::FixedCompilationDatabase(Group.Directory, Args);
+
+    /*
+     * The "ClangTool" changes the working directory of its file system,
+     * so PCHs built in parallel need their own file systems.
+     */
+    auto FileSystem = llvm::vfs::createPhysicalFileSystem();
+
+    auto Tool = clang::tooling::ClangTool(
+        Database,
+        Header,
+        std::make_shared<clang::PCHContainerOperations>(),
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(FileSystem.release()));
+
+    /* Failing to build a PCH only costs performance */
+    auto Consumer = clang::IgnoringDiagConsumer();
+
+    Tool.setDiagnosticConsumer(&Consumer);
+    Tool.setPrintErrorMessage(false);
+
+    auto Factory = PCHActionFactory();
+    Factory.setConfig(Config_);
+    Factory.setOutputFile(Output.str().str());
+    Factory.setDependencies(&Dependencies);
+
+    std::string Data;
+
+    if (Tool.run(&Factory) == 0) {
+        auto MemBuffer = llvm::MemoryBuffer::getFile(Output);
+        if (MemBuffer)
+            Data = MemBuffer.get()->getBuffer().str();
+    }
+
+    (void) llvm::sys::fs::remove(Output);
+
+    return Data;
+}
+
+std::string PCHManager::getKey(const Group &Group, llvm::StringRef Header) const
+{
+    /* PCHs can only be read by the exact same clang version */
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    OS << "pch" << '\0' << CCMOCK_VERSION_CORE << '\0' << LLVM_VERSION_STRING
+       << '\0' << MockActionFactory::getResourceDirectory(*Config_) << '\0'
+       << Group.Directory << '\0' << Group.Language << '\0';
+
+    for (const auto &Arg : Group.Args)
+        OS << Arg << '\0';
+
+    OS << Header;
+
+    auto Hash = llvm::SHA1();
+    Hash.update(OS.str());
+
+    return llvm::toHex(Hash.final(), true);
+}
+
+std::string
+PCHManager::getPCHKey(llvm::StringRef Key,
+                      llvm::ArrayRef<std::string> Dependencies) const
+{
+    /*
+     * Clang rejects PCHs if the modification time or the size of any of
+     * their input files changed.
+     */
+    auto Hash = llvm::SHA1();
+    Hash.update(Key);
+
+    for (const auto &File : Dependencies) {
+        llvm::sys::fs::file_status Status;
+
+        if (llvm::sys::fs::status(File, Status))
+            return std::string();
+
+        auto Time = Status.getLastModificationTime().time_since_epoch();
+
+        Hash.update(File);
+        Hash.update(llvm::StringRef("\0", 1));
+        Hash.update(llvm::utostr(Time.count()));
+        Hash.update(llvm::StringRef("\0", 1));
+        Hash.update(llvm::utostr(Status.getSize()));
+        Hash.update(llvm::StringRef("\0", 1));
+    }
+
+    return llvm::toHex(Hash.final(), true);
+}
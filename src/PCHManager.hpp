@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PCHMANAGER_HPP_
+#define PCHMANAGER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringMap.h>
+
+#include "Batch.hpp"
+#include "Config.hpp"
+#include "ResultCache.hpp"
+#include "util/ThreadPool.hpp"
+
+/*
+ * Precompiles the headers shared by the translation units of a batch.
+ * Translation units with the same compile flags are grouped and the
+ * include directives all of them start with are compiled into a clang PCH
+ * once. Forced includes ("-include") always become part of the PCH, which
+ * also replaces GCC's precompiled headers ("*.gch") as clang cannot read
+ * them. PCHs are stored in the result cache together with the list of
+ * files they were built from and get rebuilt if any of these changed.
+ */
+
+class PCHManager {
+public:
+    PCHManager(std::shared_ptr<const Config> Config,
+               const clang::tooling::CompilationDatabase &Commands,
+               std::shared_ptr<ResultCache> Cache);
+
+    inline void
+    setArgumentsAdjuster(clang::tooling::ArgumentsAdjuster Adjuster);
+
+    void prepare(const Batch &Batch, util::ThreadPool &Pool);
+
+    clang::tooling::ArgumentsAdjuster getArgumentsAdjuster() const;
+
+private:
+    struct Group {
+    public:
+        std::string Directory;
+        std::string Language;
+        std::vector<std::string> Args;
+        std::vector<std::string> ForcedIncludes;
+        std::vector<std::string> Files;
+        std::vector<std::string> Includes;
+
+        /* Whether a forced include refers to one of GCC's PCHs */
+        bool GCH = false;
+    };
+
+    void collect(const Batch::Job &Job,
+                 llvm::StringMap<size_t> &Keys,
+                 std::vector<Group> &Groups) const;
+    std::string build(const Group &Group) const;
+    std::string buildPCH(const Group &Group,
+                         const std::string &Header,
+                         std::vector<std::string> &Dependencies) const;
+    std::string getKey(const Group &Group, llvm::StringRef Header) const;
+    std::string getPCHKey(llvm::StringRef Key,
+                          llvm::ArrayRef<std::string> Dependencies) const;
+
+    std::shared_ptr<const Config> Config_;
+    const clang::tooling::CompilationDatabase *Commands_;
+    std::shared_ptr<ResultCache> Cache_;
+    clang::tooling::ArgumentsAdjuster Adjuster_;
+
+    /* Maps the file names of compile commands to the PCHs they use */
+    std::shared_ptr<llvm::StringMap<std::string>> Files_;
+};
+
+inline void
+PCHManager::setArgumentsAdjuster(clang::tooling::ArgumentsAdjuster Adjuster)
+{
+    Adjuster_ = std::move(Adjuster);
+}
+
+#endif /* PCHMANAGER_HPP_ */
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PreambleCache.hpp"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <llvm/Config/llvm-config.h>
+
+std::shared_ptr<const clang::PrecompiledPreamble> PreambleCache::configure(
+    clang::CompilerInvocation &Invocation,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> &FileSystem,
+    std::shared_ptr<clang::PCHContainerOperations> Operations,
+    std::unique_ptr<llvm::MemoryBuffer> &MainFile)
+{
+    auto &PreprocessorOpts = Invocation.getPreprocessorOpts();
+    const auto &Inputs = Invocation.getFrontendOpts().Inputs;
+
+    /* Only one PCH can be used at a time, e.g. from "-include-pch" */
+    if (Inputs.size() != 1 || !Inputs.front().isFile()
+        || !PreprocessorOpts.ImplicitPCHInclude.empty())
+        return nullptr;
+
+    auto File = Inputs.front().getFile();
+
+    auto Buffer = FileSystem->getBufferForFile(File);
+    if (!Buffer)
+        return nullptr;
+
+#if LLVM_VERSION_MAJOR >= 18
+    const auto &LangOpts = Invocation.getLangOpts();
+#else
+    const auto &LangOpts = *Invocation.getLangOpts();
+#endif
+
+    auto Bounds = clang::ComputePreambleBounds(LangOpts, **Buffer, 0);
+    if (Bounds.Size == 0)
+        return nullptr;
+
+    std::shared_ptr<const clang::PrecompiledPreamble> Preamble;
+
+    {
+        auto Lock = std::lock_guard(Mutex_);
+
+        auto It = Preambles_.find(File);
+        if (It != Preambles_.end())
+            Preamble = It->second;
+    }
+
+    /*
+     * The preamble is outdated if it differs from the start of the input
+     * file or if any of the files it was built from changed.
+     */
+    if (!Preamble
+        || !Preamble->CanReuse(Invocation, **Buffer, Bounds, *FileSystem)) {
+        Preamble = build(Invocation, **Buffer, Bounds, FileSystem, Operations);
+
+        auto Lock = std::lock_guard(Mutex_);
+
+        if (Preamble)
+            Preambles_[File] = Preamble;
+        else
+            Preambles_.erase(File);
+    }
+
+    if (!Preamble)
+        return nullptr;
+
+    /* The invocation refers to the buffer, so the caller keeps it alive */
+    MainFile = std::move(*Buffer);
+    PreprocessorOpts.RetainRemappedFileBuffers = true;
+
+    Preamble->AddImplicitPreamble(Invocation, FileSystem, MainFile.get());
+
+    return Preamble;
+}
+
+std::shared_ptr<const clang::PrecompiledPreamble> PreambleCache::build(
+    const clang::CompilerInvocation &Invocation,
+    const llvm::MemoryBuffer &MainFile,
+    clang::PreambleBounds Bounds,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem,
+    std::shared_ptr<clang::PCHContainerOperations> Operations) const
+{
+    /*
+     * Diagnostics within the preamble are not reported again when it gets
+     * reused. Preambles with warnings or errors are therefore dropped, so
+     * the diagnostics are reported by parsing the whole input file as
+     * usual. The warning options of the invocation (e.g. "-Werror" or
+     * "-Wno-...") decide what counts as such a diagnostic.
+     */
+    const auto &DiagOpts = Invocation.getDiagnosticOpts();
+    auto Consumer = clang::IgnoringDiagConsumer();
+    auto *Options = new clang::DiagnosticOptions(DiagOpts);
+    auto Diags = clang::DiagnosticsEngine(new clang::DiagnosticIDs(),
+                                          Options,
+                                          &Consumer,
+                                          false);
+    clang::ProcessWarningOptions(Diags, DiagOpts, false);
+
+    auto Callbacks = clang::PreambleCallbacks();
+
+    auto Preamble = clang::PrecompiledPreamble::Build(Invocation,
+                                                      &MainFile,
+                                                      Bounds,
+                                                      Diags,
+                                                      std::move(FileSystem),
+                                                      std::move(Operations),
+                                                      true,
+#if LLVM_VERSION_MAJOR >= 16
+                                                      "",
+#endif
+                                                      Callbacks);
+
+    if (!Preamble || Diags.hasErrorOccurred() || Diags.getNumWarnings())
+        return nullptr;
+
+    return std::make_shared<const clang::PrecompiledPreamble>(
+        std::move(*Preamble));
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PREAMBLE_CACHE_HPP_
+#define PREAMBLE_CACHE_HPP_
+
+#include <memory>
+#include <mutex>
+
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Frontend/PrecompiledPreamble.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+/*
+ * Keeps the precompiled preamble, i.e. the leading include directives, of
+ * each parsed input file in memory. Parsing an input file again reuses its
+ * preamble as long as the preamble of the file is unchanged and none of
+ * the files included by it changed. Only the rest of the input file has
+ * to be parsed in this case.
+ */
+
+class PreambleCache {
+public:
+    PreambleCache() = default;
+
+    std::shared_ptr<const clang::PrecompiledPreamble>
+    configure(clang::CompilerInvocation &Invocation,
+              llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> &FileSystem,
+              std::shared_ptr<clang::PCHContainerOperations> Operations,
+              std::unique_ptr<llvm::MemoryBuffer> &MainFile);
+
+private:
+    std::shared_ptr<const clang::PrecompiledPreamble>
+    build(const clang::CompilerInvocation &Invocation,
+          const llvm::MemoryBuffer &MainFile,
+          clang::PreambleBounds Bounds,
+          llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem,
+          std::shared_ptr<clang::PCHContainerOperations> Operations) const;
+
+    std::mutex Mutex_;
+    llvm::StringMap<std::shared_ptr<const clang::PrecompiledPreamble>>
+        Preambles_;
+};
+
+#endif /* PREAMBLE_CACHE_HPP_ */
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResultCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace {
+
+/*
+ * Layout of an entry:
+ *      <magic> <method> <size of the output> <data>
+ * The data is the output compressed with the specified method.
+ */
+constexpr llvm::StringLiteral Magic = "CCMC";
+constexpr size_t HeaderSize = Magic.size() + 1 + sizeof(uint64_t);
+
+enum Method : uint8_t {
+    METHOD_NONE = 0,
+    METHOD_ZLIB = 1,
+};
+
+bool compress(llvm::StringRef Input, std::string &Output)
+{
+#if LLVM_VERSION_MAJOR >= 15
+    namespace zlib = llvm::compression::zlib;
+
+    if (!zlib::isAvailable())
+        return false;
+
+    llvm::SmallVector<uint8_t, 0> Buffer;
+    zlib::compress(llvm::arrayRefFromStringRef(Input), Buffer);
+#else
+    namespace zlib = llvm::zlib;
+
+    if (!zlib::isAvailable())
+        return false;
+
+    llvm::SmallVector<char, 0> Buffer;
+    if (auto Err = zlib::compress(Input, Buffer)) {
+        llvm::consumeError(std::move(Err));
+        return false;
+    }
+#endif
+
+    Output.append(Buffer.begin(), Buffer.end());
+
+    return true;
+}
+
+bool uncompress(llvm::StringRef Input, size_t Size, std::string &Output)
+{
+#if LLVM_VERSION_MAJOR >= 15
+    namespace zlib = llvm::compression::zlib;
+
+    llvm::SmallVector<uint8_t, 0> Buffer;
+    auto Data = llvm::arrayRefFromStringRef(Input);
+#else
+    namespace zlib = llvm::zlib;
+
+    llvm::SmallVector<char, 0> Buffer;
+    auto Data = Input;
+#endif
+
+    if (!zlib::isAvailable())
+        return false;
+
+    if (auto Err = zlib::uncompress(Data, Buffer, Size)) {
+        llvm::consumeError(std::move(Err));
+        return false;
+    }
+
+    Output.assign(Buffer.begin(), Buffer.end());
+
+    return Output.size() == Size;
+}
+
+bool decode(llvm::StringRef Data, std::string &Output)
+{
+    if (Data.size() < HeaderSize || !Data.startswith(Magic))
+        return false;
+
+    auto Method = static_cast<uint8_t>(Data[Magic.size()]);
+    auto Size = llvm::support::endian::read64le(Data.data() + Magic.size() + 1);
+
+    Data = Data.drop_front(HeaderSize);
+
+    switch (Method) {
+    case METHOD_NONE:
+        if (Data.size() != Size)
+            return false;
+
+        Output = Data.str();
+        return true;
+    case METHOD_ZLIB:
+        return uncompress(Data, Size, Output);
+    default:
+        return false;
+    }
+}
+
+std::string encode(llvm::StringRef Output)
+{
+    std::string Data;
+    Data.reserve(HeaderSize + Output.size());
+
+    Data += Magic;
+    Data += static_cast<char>(METHOD_ZLIB);
+    Data.resize(HeaderSize);
+
+    llvm::support::endian::write64le(&Data[Magic.size() + 1], Output.size());
+
+    /* Store the output as is if compressing it does not pay off */
+    if (compress(Output, Data) && Data.size() < HeaderSize + Output.size())
+        return Data;
+
+    Data.resize(HeaderSize);
+    Data[Magic.size()] = static_cast<char>(METHOD_NONE);
+    Data += Output;
+
+    return Data;
+}
+
+} // namespace
+
+ResultCache::ResultCache(std::filesystem::path Directory, uint64_t Size)
+    : Directory_(std::move(Directory)), Size_(Size), Counters_()
+{
+}
+
+std::filesystem::path ResultCache::getDefaultDirectory()
+{
+    llvm::SmallString<128> Path;
+
+    if (!llvm::sys::path::cache_directory(Path))
+        return std::filesystem::path();
+
+    llvm::sys::path::append(Path, "ccmock");
+
+    return Path.str().str();
+}
+
+bool ResultCache::lookup(llvm::StringRef Key, std::string &Output)
+{
+    auto Path = getPath(Key);
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Path.native());
+    if (!MemBuffer) {
+        ++Counters_.Misses;
+        return false;
+    }
+
+    if (!decode(MemBuffer.get()->getBuffer(), Output)) {
+        /* Drop corrupted entries, they would only cause misses forever */
+        std::error_code Code;
+        std::filesystem::remove(Path, Code);
+
+        ++Counters_.Misses;
+        return false;
+    }
+
+    /* Mark the entry as recently used for the eviction */
+    std::error_code Code;
+    auto Now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(Path, Now, Code);
+
+    ++Counters_.Hits;
+
+    return true;
+}
+
+void ResultCache::store(llvm::StringRef Key,
+                        llvm::StringRef Output,
+                        std::string &Error)
+{
+    if (write(getPath(Key), encode(Output), Error))
+        ++Counters_.Stores;
+}
+
+bool ResultCache::lookupFile(llvm::StringRef Key, std::filesystem::path &Path)
+{
+    std::error_code Code;
+
+    Path = getPath(Key);
+
+    /* Mark the entry as recently used for the eviction */
+    auto Now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(Path, Now, Code);
+
+    return !Code;
+}
+
+bool ResultCache::findFile(llvm::StringRef Key,
+                           std::filesystem::path &Path) const
+{
+    std::error_code Code;
+
+    Path = getPath(Key);
+
+    return std::filesystem::is_regular_file(Path, Code);
+}
+
+void ResultCache::storeFile(llvm::StringRef Key,
+                            llvm::StringRef Data,
+                            std::string &Error)
+{
+    if (write(getPath(Key), Data, Error))
+        ++Counters_.Stores;
+}
+
+ResultCache::Usage ResultCache::evict(std::string &Error)
+{
+    struct Entry {
+    public:
+        std::filesystem::file_time_type Time;
+        uint64_t Size;
+        std::filesystem::path Path;
+    };
+
+    llvm::raw_string_ostream OS(Error);
+    auto Entries = std::vector<Entry>();
+    auto Result = Usage();
+    std::error_code Code;
+
+    auto It = std::filesystem::recursive_directory_iterator(Directory_, Code);
+    if (Code) {
+        /* Nothing was stored so far */
+        if (Code == std::errc::no_such_file_or_directory)
+            return Result;
+
+        OS << "failed to open \"" << Directory_.native()
+           << "\": " << Code.message();
+        return Result;
+    }
+
+    for (auto End = std::filesystem::end(It); It != End; It.increment(Code)) {
+        if (Code)
+            break;
+
+        if (!It->is_regular_file(Code))
+            continue;
+
+        auto Item = Entry();
+        Item.Path = It->path();
+        Item.Size = It->file_size(Code);
+        Item.Time = It->last_write_time(Code);
+
+        Result.Size += Item.Size;
+        Entries.push_back(std::move(Item));
+    }
+
+    if (Code) {
+        OS << "failed to read \"" << Directory_.native()
+           << "\": " << Code.message();
+        return Result;
+    }
+
+    Result.Count = Entries.size();
+
+    if (Result.Size <= Size_)
+        return Result;
+
+    /*
+     * Remove the least recently used entries. Making some room below the
+     * limit avoids evicting entries again after every single store.
+     */
+    std::sort(Entries.begin(), Entries.end(), [](const auto &A, const auto &B) {
+        return A.Time < B.Time;
+    });
+
+    auto Limit = Size_ - Size_ / 10;
+
+    for (const auto &Item : Entries) {
+        if (Result.Size <= Limit)
+            break;
+
+        if (!std::filesystem::remove(Item.Path, Code))
+            continue;
+
+        Result.Size -= Item.Size;
+        --Result.Count;
+        ++Result.Evictions;
+    }
+
+    return Result;
+}
+
+bool ResultCache::write(const std::filesystem::path &Path,
+                        llvm::StringRef Data,
+                        std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+    llvm::SmallString<128> Temporary;
+    std::error_code Code;
+    int FD;
+
+    auto Directory = Path.parent_path();
+
+    std::filesystem::create_directories(Directory, Code);
+    if (Code) {
+        OS << "failed to create \"" << Directory.native()
+           << "\": " << Code.message();
+        return false;
+    }
+
+    /*
+     * Other processes might access the same entry concurrently. Writing
+     * a temporary file and renaming it ensures that they only ever see
+     * complete entries.
+     */
+    auto Model = Path.native() + ".%%%%%%.tmp";
+
+    Code = llvm::sys::fs::createUniqueFile(Model, FD, Temporary);
+    if (Code) {
+        OS << "failed to create \"" << Model << "\": " << Code.message();
+        return false;
+    }
+
+    {
+        auto Out = llvm::raw_fd_ostream(FD, true);
+        Out << Data;
+        Out.close();
+
+        if (Out.has_error()) {
+            OS << "failed to write \"" << Temporary
+               << "\": " << Out.error().message();
+            Out.clear_error();
+            (void) llvm::sys::fs::remove(Temporary);
+            return false;
+        }
+    }
+
+    Code = llvm::sys::fs::rename(Temporary, Path.native());
+    if (Code) {
+        OS << "failed to rename \"" << Temporary << "\": " << Code.message();
+        (void) llvm::sys::fs::remove(Temporary);
+        return false;
+    }
+
+    return true;
+}
+
+std::filesystem::path ResultCache::getPath(llvm::StringRef Key) const
+{
+    /* Spread the entries over multiple directories like git objects */
+    auto Path = Directory_ / Key.take_front(2).str();
+    Path /= Key.drop_front(2).str();
+
+    return Path;
+}
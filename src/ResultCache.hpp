@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULTCACHE_HPP_
+#define RESULTCACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+
+/*
+ * Persistent cache of generated outputs which can be shared by all ccmock
+ * processes of a user. Each entry is stored in its own (compressed) file
+ * named after its key. The key must cover everything which has an effect
+ * on the output. The least recently used entries get evicted once the
+ * cache grows beyond its size limit. File entries are stored as they are,
+ * so they can be read by other means than "lookup" (e.g. AST files).
+ * Unlike "lookupFile", "findFile" leaves the modification time of an entry
+ * alone, which matters for files other files were built from (e.g. the
+ * headers of PCHs).
+ */
+
+class ResultCache {
+public:
+    struct Counters {
+    public:
+        std::atomic<uint64_t> Hits = 0;
+        std::atomic<uint64_t> Misses = 0;
+        std::atomic<uint64_t> Stores = 0;
+    };
+
+    struct Usage {
+    public:
+        uint64_t Size = 0;
+        uint64_t Count = 0;
+        uint64_t Evictions = 0;
+    };
+
+    ResultCache(std::filesystem::path Directory, uint64_t Size);
+
+    static std::filesystem::path getDefaultDirectory();
+
+    bool lookup(llvm::StringRef Key, std::string &Output);
+    void store(llvm::StringRef Key, llvm::StringRef Output, std::string &Error);
+    bool lookupFile(llvm::StringRef Key, std::filesystem::path &Path);
+    bool findFile(llvm::StringRef Key, std::filesystem::path &Path) const;
+    void storeFile(llvm::StringRef Key,
+                   llvm::StringRef Data,
+                   std::string &Error);
+    Usage evict(std::string &Error);
+
+    inline const std::filesystem::path &getDirectory() const;
+    inline const Counters &getCounters() const;
+
+private:
+    std::filesystem::path getPath(llvm::StringRef Key) const;
+    bool write(const std::filesystem::path &Path,
+               llvm::StringRef Data,
+               std::string &Error);
+
+    std::filesystem::path Directory_;
+    uint64_t Size_;
+    Counters Counters_;
+};
+
+inline const std::filesystem::path &ResultCache::getDirectory() const
+{
+    return Directory_;
+}
+
+inline const ResultCache::Counters &ResultCache::getCounters() const
+{
+    return Counters_;
+}
+
+#endif /* RESULTCACHE_HPP_ */
@@ -0,0 +1,1729 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Runner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+
+#include <sys/resource.h>
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/xxhash.h>
+
+#include "util/FileSystem.hpp"
+#include "util/FileWatcher.hpp"
+#include "util/ThreadPool.hpp"
+#include "util/commandline.hpp"
+
+#include "CompilationDatabase.hpp"
+#include "MockAction.hpp"
+#include "OutputManifest.hpp"
+#include "PCHManager.hpp"
+
+namespace {
+
+/*
+ * Jobs without an output file write to standard output. Their output
+ * gets buffered and committed in the order of the jobs within the batch,
+ * regardless of the order in which the jobs finish. This keeps the
+ * output of parallel runs identical to serial runs.
+ */
+class OutputQueue {
+public:
+    explicit OutputQueue(size_t Size);
+
+    inline std::string &getBuffer(size_t Index);
+
+    void commit(size_t Index);
+
+private:
+    std::mutex Mutex_;
+    std::vector<std::string> Buffers_;
+    std::vector<bool> Done_;
+    size_t Next_;
+};
+
+OutputQueue::OutputQueue(size_t Size)
+    : Mutex_(), Buffers_(Size), Done_(Size, false), Next_(0)
+{
+}
+
+inline std::string &OutputQueue::getBuffer(size_t Index)
+{
+    return Buffers_[Index];
+}
+
+void OutputQueue::commit(size_t Index)
+{
+    auto Lock = std::lock_guard(Mutex_);
+
+    Done_[Index] = true;
+
+    while (Next_ < Done_.size() && Done_[Next_]) {
+        auto &Buffer = Buffers_[Next_++];
+
+        llvm::outs() << Buffer;
+
+        /* Release the memory of the already committed output */
+        std::string().swap(Buffer);
+    }
+
+    llvm::outs().flush();
+}
+
+/*
+ * Admits jobs as long as the sum of their expected memory usage fits into
+ * the budget. A job exceeding the budget on its own still gets admitted
+ * if no other job is running, otherwise it would never run at all.
+ */
+class MemoryBudget {
+public:
+    explicit MemoryBudget(uint64_t Size);
+
+    void acquire(uint64_t Size);
+    void release(uint64_t Size);
+
+private:
+    std::mutex Mutex_;
+    std::condition_variable Condition_;
+    uint64_t Size_;
+    uint64_t Used_;
+};
+
+MemoryBudget::MemoryBudget(uint64_t Size)
+    : Mutex_(), Condition_(), Size_(Size), Used_(0)
+{
+}
+
+void MemoryBudget::acquire(uint64_t Size)
+{
+    if (Size == 0)
+        return;
+
+    auto Lock = std::unique_lock(Mutex_);
+
+    Condition_.wait(Lock, [&]() {
+        return Used_ == 0 || Used_ + Size <= Size_;
+    });
+
+    Used_ += Size;
+}
+
+void MemoryBudget::release(uint64_t Size)
+{
+    if (Size == 0)
+        return;
+
+    {
+        auto Lock = std::lock_guard(Mutex_);
+        Used_ -= Size;
+    }
+
+    Condition_.notify_all();
+}
+
+const clang::tooling::ArgumentsAdjuster &getStripAdjuster()
+{
+    using namespace clang::tooling;
+
+    /*
+     * The "ClangTool" strips the output and dependency file arguments on
+     * its own, so they never have any effect on the parsed AST.
+     */
+    static const auto Strip = combineAdjusters(
+        combineAdjusters(getClangStripOutputAdjuster(),
+                         getClangStripDependencyFileAdjuster()),
+        getClangSyntaxOnlyAdjuster());
+
+    return Strip;
+}
+
+void parseMakeDependencies(llvm::StringRef Data,
+                           std::vector<std::string> &Files)
+{
+    /*
+     * Example of the make rule reported by the dependency scanner:
+     *      a.o: /src/a.c /src/a\ b.h \
+     *        /usr/include/stdio.h
+     */
+    auto Pos = Data.find(": ");
+    if (Pos == llvm::StringRef::npos)
+        return;
+
+    Data = Data.drop_front(Pos + 2);
+
+    std::string File;
+
+    auto Flush = [&]() {
+        if (!File.empty())
+            Files.push_back(std::move(File));
+
+        File.clear();
+    };
+
+    for (size_t i = 0, Size = Data.size(); i < Size; ++i) {
+        auto Char = Data[i];
+        auto Next = (i + 1 < Size) ? Data[i + 1] : '\0';
+
+        if (Char == '\\' && (Next == ' ' || Next == '#')) {
+            File += Next;
+            ++i;
+        } else if (Char == '$' && Next == '$') {
+            File += '$';
+            ++i;
+        } else if (Char == '\\' && (Next == '\n' || Next == '\r')) {
+            Flush();
+        } else if (llvm::isSpace(Char)) {
+            Flush();
+        } else {
+            File += Char;
+        }
+    }
+
+    Flush();
+}
+
+void writeMakePath(llvm::raw_ostream &OS, llvm::StringRef Path)
+{
+    /* Inverse of the escaping understood by "parseMakeDependencies" */
+    for (auto Char : Path) {
+        if (Char == ' ' || Char == '#')
+            OS << '\\';
+        else if (Char == '$')
+            OS << '$';
+
+        OS << Char;
+    }
+}
+
+Config makeOutputConfig(const Config &Config)
+{
+    /*
+     * Of the general settings only the ones written to the file header
+     * and the reproducible mode have an effect on the output. Everything
+     * else (e.g. the number of jobs) would only cause needless misses in
+     * the caches.
+     */
+    auto Copy = Config;
+    Copy.General = Config::GeneralSection();
+    Copy.General.BaseDirectory = Config.General.BaseDirectory;
+    Copy.General.Input = Config.General.Input;
+    Copy.General.Output = Config.General.Output;
+    Copy.General.Reproducible = Config.General.Reproducible;
+    Copy.General.WriteDate = Config.General.WriteDate;
+
+    return Copy;
+}
+
+bool writeOutput(const Config &Config,
+                 llvm::StringRef Content,
+                 llvm::raw_ostream &Stream)
+{
+    const auto &Path = Config.General.Output.native();
+    std::string Message;
+
+    if (Path.empty()) {
+        Stream << Content;
+        return true;
+    }
+
+    (void) util::fs::writeIfChanged(Path, Content, Message);
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::error() << Message << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t getPeakResidentMemory()
+{
+    auto Usage = rusage();
+
+    if (::getrusage(RUSAGE_SELF, &Usage) < 0)
+        return 0;
+
+    /* Linux reports the size in kilobytes */
+    return static_cast<uint64_t>(Usage.ru_maxrss) << 10;
+}
+
+bool isModifiedBetween(llvm::StringRef File,
+                       std::chrono::system_clock::time_point Begin,
+                       std::chrono::system_clock::time_point End)
+{
+    llvm::sys::fs::file_status Status;
+
+    if (llvm::sys::fs::status(File, Status))
+        return false;
+
+    /* Modification times in the future would trigger endless runs */
+    auto Time = Status.getLastModificationTime();
+
+    return Begin <= Time && Time <= End;
+}
+
+} // namespace
+
+Runner::Runner(std::shared_ptr<const Config> Config,
+               const clang::tooling::CompilationDatabase &Commands)
+    : Config_(std::move(Config)),
+      Commands_(&Commands),
+      Adjuster_(),
+      PCHAdjuster_(),
+      Preambles_(),
+      ModelThreads_(1),
+      ScanningService_(),
+      Workers_(),
+      FileCache_(),
+      ResultCache_(),
+      Mutex_(),
+      History_(),
+      HistoryFile_(),
+      CommonDependencies_()
+{
+}
+
+void Runner::appendArgumentsAdjuster(
+    clang::tooling::ArgumentsAdjuster Adjuster)
+{
+    Adjuster_ = clang::tooling::combineAdjusters(std::move(Adjuster_),
+                                                 std::move(Adjuster));
+}
+
+void Runner::setHistoryFile(const std::filesystem::path &Path)
+{
+    std::string Message;
+
+    /*
+     * The working directory might change while processing the batch,
+     * so remember where the history has to be written to.
+     */
+    HistoryFile_ = std::filesystem::absolute(Path);
+
+    History_.load(HistoryFile_, Message);
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::warning() << "ignoring history: " << Message
+                     << "\n";
+        History_ = History();
+    }
+}
+
+void Runner::setCommonDependencies(std::vector<std::string> Files)
+{
+    CommonDependencies_ = std::move(Files);
+}
+
+bool Runner::isUpToDate(const Batch &Batch) const
+{
+    for (const auto &Job : Batch.getJobs()) {
+        /* Outputs written to standard output have to be generated */
+        if (Job.Output.empty())
+            return false;
+
+        auto Manifest = OutputManifest();
+        std::string Message;
+
+        Manifest.load(OutputManifest::getPath(Job.Output), Message);
+        if (!Message.empty())
+            return false;
+
+        if (!Manifest.isUpToDate(getManifestKey(*makeConfig(Job))))
+            return false;
+    }
+
+    return true;
+}
+
+std::vector<double> Runner::estimate(const Batch &Batch) const
+{
+    auto Jobs = Batch.getJobs();
+    auto Costs = std::vector<double>(Jobs.size(), -1.0);
+    auto Sizes = std::vector<double>(Jobs.size(), 0.0);
+    double KnownCost = 0.0;
+    double KnownSize = 0.0;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        std::error_code Code;
+
+        auto FileSize = std::filesystem::file_size(Jobs[i].Input, Code);
+        if (!Code)
+            Sizes[i] = static_cast<double>(FileSize);
+
+        auto Hash = getCommandHash(Jobs[i]);
+
+        const auto *Entry = History_.lookup(Jobs[i].Input.native(), Hash);
+        if (!Entry)
+            continue;
+
+        Costs[i] = Entry->ParseTime + Entry->GenerateTime;
+        KnownCost += Costs[i];
+        KnownSize += Sizes[i];
+    }
+
+    /*
+     * Files without any recorded history get a cost proportional to their
+     * size. The average time per byte of all known files keeps both kinds
+     * of estimates comparable. Without any history at all, the size of a
+     * file is the only available estimate.
+     */
+    double Rate = (KnownSize > 0.0) ? KnownCost / KnownSize : 1.0;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        if (Costs[i] < 0.0)
+            Costs[i] = Sizes[i] * Rate;
+    }
+
+    return Costs;
+}
+
+std::vector<uint64_t> Runner::estimateMemory(const Batch &Batch) const
+{
+    /*
+     * Assumptions for the very first run without any recorded history and
+     * for files whose resident memory was never measured. The memory
+     * allocated for the AST, the preprocessor and the source manager is
+     * only a fraction of the resident memory required to process a file.
+     */
+    constexpr uint64_t DefaultMemory = uint64_t(512) << 20;
+    constexpr double DefaultRatio = 4.0;
+
+    auto Ratio = History_.getResidentRatio();
+    if (Ratio == 0.0)
+        Ratio = DefaultRatio;
+
+    auto Jobs = Batch.getJobs();
+    auto Memory = std::vector<uint64_t>(Jobs.size(), 0);
+    auto Sizes = std::vector<uint64_t>(Jobs.size(), 0);
+    uint64_t KnownMemory = 0;
+    uint64_t KnownSize = 0;
+    size_t KnownCount = 0;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        std::error_code Code;
+
+        auto FileSize = std::filesystem::file_size(Jobs[i].Input, Code);
+        if (!Code)
+            Sizes[i] = FileSize;
+
+        auto Hash = getCommandHash(Jobs[i]);
+
+        const auto *Entry = History_.lookup(Jobs[i].Input.native(), Hash);
+        if (!Entry || Entry->Memory == 0)
+            continue;
+
+        Memory[i] = Entry->Resident;
+        if (Memory[i] == 0)
+            Memory[i] = static_cast<uint64_t>(Entry->Memory * Ratio);
+
+        KnownMemory += Memory[i];
+        KnownSize += Sizes[i];
+        ++KnownCount;
+    }
+
+    if (KnownCount == 0) {
+        std::fill(Memory.begin(), Memory.end(), DefaultMemory);
+        return Memory;
+    }
+
+    /*
+     * Most of the memory is spent on included headers and not on the
+     * input file itself. Files without history therefore get at least
+     * the average of all known files, or more if they are larger than
+     * the known files.
+     */
+    auto Average = KnownMemory / KnownCount;
+    auto Rate = (KnownSize != 0) ? double(KnownMemory) / KnownSize : 0.0;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        if (Memory[i] == 0) {
+            auto Estimate = static_cast<uint64_t>(Sizes[i] * Rate);
+            Memory[i] = std::max(Estimate, Average);
+        }
+    }
+
+    return Memory;
+}
+
+int Runner::run(const Batch &Batch)
+{
+    return run(Batch, nullptr);
+}
+
+int Runner::watch(const Batch &Batch)
+{
+    /* Bursts of saves (e.g. "save all" in an editor) trigger a single run */
+    constexpr auto Delay = std::chrono::milliseconds(200);
+
+    auto Jobs = Batch.getJobs();
+    auto Dependencies = std::vector<std::vector<std::string>>(Jobs.size());
+    auto Watcher = util::FileWatcher();
+
+    auto Selection = std::vector<size_t>(Jobs.size());
+    std::iota(Selection.begin(), Selection.end(), 0);
+
+    /* Edits usually leave the included files of an input file untouched */
+    Preambles_ = std::make_shared<PreambleCache>();
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        std::string Message;
+
+        Dependencies[i].push_back(Jobs[i].Input.native());
+
+        /* Edits of the input files during the first run must not get lost */
+        Watcher.add(Jobs[i].Input.native(), Message);
+        if (!Message.empty())
+            llvm::errs() << util::cl::warning() << Message << "\n";
+    }
+
+    while (true) {
+        if (!Selection.empty()) {
+            auto Subset = ::Batch();
+            for (auto Item : Selection)
+                Subset.add(Batch::Job(Jobs[Item]));
+
+            auto Files = std::vector<std::vector<std::string>>();
+            auto Start = std::chrono::system_clock::now();
+
+            (void) run(Subset, &Files);
+
+            for (size_t i = 0, Size = Selection.size(); i < Size; ++i) {
+                auto &Item = Dependencies[Selection[i]];
+
+                /*
+                 * Keep the previous dependencies of a job which failed
+                 * early, so fixing any of its files triggers it again.
+                 */
+                if (Files[i].empty())
+                    continue;
+
+                Item = std::move(Files[i]);
+                Item.push_back(Jobs[Selection[i]].Input.native());
+            }
+
+            for (auto Item : Selection) {
+                for (const auto &File : Dependencies[Item]) {
+                    std::string Message;
+
+                    Watcher.add(File, Message);
+                    if (!Message.empty())
+                        llvm::errs() << util::cl::warning() << Message << "\n";
+                }
+            }
+
+            /*
+             * Dependencies found while running only get watched now, so
+             * their modifications during the run have to be checked by
+             * hand. Later modifications get reported by the watcher.
+             */
+            auto End = std::chrono::system_clock::now();
+            auto Stale = std::vector<size_t>();
+
+            for (auto Item : Selection) {
+                auto Match = llvm::any_of(Dependencies[Item], [&](auto &File) {
+                    return isModifiedBetween(File, Start, End);
+                });
+
+                if (Match)
+                    Stale.push_back(Item);
+            }
+
+            if (!Stale.empty()) {
+                if (Config_->General.Verbose) {
+                    llvm::errs() << util::cl::info() << "files of "
+                                 << Stale.size()
+                                 << " jobs changed while processing them\n";
+                }
+
+                Selection = std::move(Stale);
+                continue;
+            }
+        }
+
+        std::string Message;
+
+        auto Changed = Watcher.wait(Delay, Message);
+        if (!Message.empty()) {
+            llvm::errs() << util::cl::error() << Message << "\n";
+            return EXIT_FAILURE;
+        }
+
+        llvm::StringSet<> Files;
+
+        for (const auto &File : Changed) {
+            if (Config_->General.Verbose) {
+                auto Lock = std::lock_guard(Mutex_);
+
+                llvm::errs() << util::cl::info() << "changed \"" << File
+                             << "\"\n";
+            }
+
+            /* Cached contents of a changed file are stale */
+            if (FileCache_)
+                FileCache_->erase(File);
+
+            Files.insert(File);
+        }
+
+        /* Only regenerate the outputs depending on a changed file */
+        Selection.clear();
+
+        for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+            auto Match = llvm::any_of(Dependencies[i], [&](const auto &File) {
+                return Files.count(File) != 0;
+            });
+
+            if (Match)
+                Selection.push_back(i);
+        }
+    }
+}
+
+int Runner::run(const Batch &Batch,
+                std::vector<std::vector<std::string>> *Dependencies)
+{
+    auto Jobs = Batch.getJobs();
+    auto Pool = util::ThreadPool(Config_->General.Jobs);
+
+    initializeResultCache();
+    initializeWorkers(Pool.size());
+
+    /* Headers may have changed since the last run in watch mode */
+    PCHAdjuster_ = nullptr;
+
+    if (ResultCache_ && Config_->General.PCH) {
+        auto Manager = PCHManager(Config_, *Commands_, ResultCache_);
+        Manager.setArgumentsAdjuster(Adjuster_);
+        Manager.prepare(Batch, Pool);
+
+        PCHAdjuster_ = Manager.getArgumentsAdjuster();
+    }
+
+    /* Manifests and depfiles record the dependencies of each output */
+    auto Files = std::vector<std::vector<std::string>>();
+    if (!Dependencies && needsDependencies())
+        Dependencies = &Files;
+
+    auto Start = std::chrono::system_clock::now();
+
+    auto Stores = ResultCache_ ? ResultCache_->getCounters().Stores.load() : 0;
+
+    /*
+     * Jobs processing the same file with the same effective compile
+     * command only differ in their outputs (e.g. the backend). Parse each
+     * of these files only once and generate all outputs from its AST.
+     */
+    auto Groups = std::vector<std::vector<size_t>>();
+    llvm::StringMap<size_t> Keys;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        auto Result = Keys.try_emplace(getParseKey(Jobs[i]), Groups.size());
+        if (Result.second)
+            Groups.emplace_back();
+
+        Groups[Result.first->second].push_back(i);
+    }
+
+    /*
+     * A single translation unit leaves the other workers idle, so it may
+     * use them while resolving its model. Otherwise, nested thread pools
+     * would start up to "Jobs * Jobs" threads.
+     */
+    ModelThreads_ = Groups.size() == 1 ? Pool.size() : 1;
+
+    if (Config_->General.Verbose && Groups.size() != Jobs.size()) {
+        llvm::errs() << util::cl::info() << "parsing " << Groups.size()
+                     << " translation units for " << Jobs.size() << " jobs\n";
+    }
+
+    auto Items = std::vector<size_t>(Groups.size());
+    std::iota(Items.begin(), Items.end(), 0);
+
+    /*
+     * Hand out the most expensive jobs first (longest processing time
+     * first). Short jobs at the end fill up the gaps between the workers.
+     */
+    if (Pool.size() > 1) {
+        auto Costs = estimate(Batch);
+        auto GroupCosts = std::vector<double>(Groups.size(), 0.0);
+
+        for (size_t i = 0, Size = Groups.size(); i < Size; ++i) {
+            for (auto Index : Groups[i])
+                GroupCosts[i] = std::max(GroupCosts[i], Costs[Index]);
+        }
+
+        std::stable_sort(Items.begin(), Items.end(), [&](size_t A, size_t B) {
+            return GroupCosts[A] > GroupCosts[B];
+        });
+    }
+
+    /*
+     * Limit the number of concurrently processed jobs by their expected
+     * memory usage to not run out of memory with many heavy jobs.
+     */
+    auto Memory = std::vector<uint64_t>();
+    auto Budget = MemoryBudget(Config_->General.MemoryBudget);
+
+    if (Pool.size() > 1 && Config_->General.MemoryBudget != 0) {
+        auto JobMemory = estimateMemory(Batch);
+
+        Memory.resize(Groups.size(), 0);
+
+        for (size_t i = 0, Size = Groups.size(); i < Size; ++i) {
+            for (auto Index : Groups[i])
+                Memory[i] = std::max(Memory[i], JobMemory[Index]);
+        }
+    }
+
+    auto Results = std::vector<int>(Jobs.size(), 0);
+    auto Stats = std::vector<Statistics>(Jobs.size());
+    auto Output = OutputQueue(Jobs.size());
+
+    if (Dependencies)
+        Dependencies->assign(Jobs.size(), std::vector<std::string>());
+
+    /*
+     * The resident memory of the process can only be attributed to a job
+     * processed on its own, e.g. if a build system invokes ccmock once per
+     * file. These measurements calibrate the estimates of all other jobs.
+     * Earlier runs in watch mode already raised the peak of the process.
+     */
+    auto Alone = Jobs.size() == 1 && !Config_->General.Watch;
+    auto Peak = Alone ? getPeakResidentMemory() : 0;
+
+    Pool.run(Items, [&](size_t Item, unsigned int Worker) {
+        const auto &Group = Groups[Item];
+        auto Size = Memory.empty() ? 0 : Memory[Item];
+
+        auto Members = std::vector<const Batch::Job *>();
+        auto Buffers = std::vector<std::unique_ptr<llvm::raw_string_ostream>>();
+        auto Streams = std::vector<llvm::raw_string_ostream *>();
+        auto Measurements = std::vector<Statistics *>();
+
+        for (auto Index : Group) {
+            auto &Buffer = Output.getBuffer(Index);
+            auto OS = std::make_unique<llvm::raw_string_ostream>(Buffer);
+
+            Members.push_back(&Jobs[Index]);
+            Streams.push_back(OS.get());
+            Measurements.push_back(&Stats[Index]);
+            Buffers.push_back(std::move(OS));
+        }
+
+        auto *Files = Dependencies ? &(*Dependencies)[Group.front()] : nullptr;
+
+        Budget.acquire(Size);
+
+        int Result =
+            run(Members, Workers_[Worker], Streams, Measurements, Files);
+
+        Budget.release(Size);
+
+        /*
+         * PCHs are built from generated headers in the result cache, which
+         * the ASTReader reports as inputs. These belong to ccmock and not
+         * to the user, their modification times change with every rebuild.
+         */
+        if (Files && ResultCache_) {
+            auto Directory = ResultCache_->getDirectory().native();
+            Directory += llvm::sys::path::get_separator();
+
+            llvm::erase_if(*Files, [&](const std::string &File) {
+                return llvm::StringRef(File).startswith(Directory);
+            });
+        }
+
+        for (auto Index : Group) {
+            Results[Index] = Result;
+
+            if (Files && Index != Group.front())
+                (*Dependencies)[Index] = *Files;
+        }
+
+        for (size_t i = 0, Count = Group.size(); i < Count; ++i) {
+            Buffers[i]->flush();
+            Output.commit(Group[i]);
+        }
+    });
+
+    if (Alone) {
+        auto NewPeak = getPeakResidentMemory();
+        if (NewPeak > Peak)
+            Stats.front().Resident = NewPeak - Peak;
+    }
+
+    int Result = 0;
+
+    for (auto Value : Results) {
+        /*
+         * Keep the semantics of "ClangTool::run": a failed job (1) takes
+         * precedence over a skipped job (2).
+         */
+        if (Value != 0 && Result != 1)
+            Result = Value;
+    }
+
+    if (Config_->General.Verbose && FileCache_)
+        printFileCacheStatistics();
+
+    for (size_t i = 0, Size = Jobs.size(); Dependencies && i < Size; ++i) {
+        if (Results[i] != 0 || Jobs[i].Output.empty())
+            continue;
+
+        if (Config_->General.Incremental)
+            saveManifest(Jobs[i], (*Dependencies)[i], Start);
+
+        if (!writeDependencyFile(Jobs[i], (*Dependencies)[i]))
+            Result = 1;
+    }
+
+    if (ResultCache_) {
+        auto Usage = ResultCache::Usage();
+        auto Stored = ResultCache_->getCounters().Stores != Stores;
+
+        /* Only a grown cache can exceed its size limit */
+        if (Stored || Config_->General.CacheStats) {
+            std::string Message;
+
+            Usage = ResultCache_->evict(Message);
+            if (!Message.empty()) {
+                llvm::errs() << util::cl::warning()
+                             << "failed to clean up cache: " << Message
+                             << "\n";
+            }
+        }
+
+        if (Config_->General.CacheStats)
+            printResultCacheStatistics(Usage);
+    }
+
+    if (HistoryFile_.empty())
+        return Result;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        /* Reused outputs tell nothing about the processing costs */
+        if (Results[i] != 0 || Stats[i].Cached)
+            continue;
+
+        using Seconds = std::chrono::duration<double>;
+
+        auto Entry = History::Entry();
+        Entry.Hash = getCommandHash(Jobs[i]);
+        Entry.ParseTime = Seconds(Stats[i].ParseTime).count();
+        Entry.GenerateTime = Seconds(Stats[i].GenerateTime).count();
+        Entry.Memory = Stats[i].Memory;
+        Entry.Resident = Stats[i].Resident;
+
+        /* Keep the measurement of a previous run of the job on its own */
+        if (Entry.Resident == 0) {
+            const auto *Previous =
+                History_.lookup(Jobs[i].Input.native(), Entry.Hash);
+            if (Previous)
+                Entry.Resident = Previous->Resident;
+        }
+
+        History_.insert(Jobs[i].Input.native(), Entry);
+    }
+
+    std::string Message;
+
+    History_.save(HistoryFile_, Message);
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::warning() << "failed to save history: "
+                     << Message << "\n";
+    }
+
+    return Result;
+}
+
+void Runner::saveManifest(const Batch::Job &Job,
+                          llvm::ArrayRef<std::string> Dependencies,
+                          std::chrono::system_clock::time_point Start) const
+{
+    auto Manifest = OutputManifest();
+    auto Path = OutputManifest::getPath(Job.Output);
+    std::string Message;
+
+    /* Remove an outdated manifest in case no new one gets written */
+    (void) llvm::sys::fs::remove(Path.native());
+
+    for (const auto &File : collectDependencies(Job, Dependencies)) {
+        Manifest.add(File, Message);
+        if (!Message.empty())
+            return;
+    }
+
+    /*
+     * A file modified while the output was generated might have been
+     * read before the modification. Its recorded status would claim the
+     * output to be up to date forever, so leave the output without any
+     * manifest which causes the next run to process it again.
+     */
+    auto Time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Start.time_since_epoch());
+
+    for (const auto &File : Manifest.getFiles()) {
+        if (File.Time >= Time.count())
+            return;
+    }
+
+    /* Detect modified or removed outputs as well */
+    Manifest.add(Job.Output.native(), Message);
+    if (!Message.empty())
+        return;
+
+    Manifest.setKey(getManifestKey(*makeConfig(Job)));
+
+    for (auto &Command : Commands_->getCompileCommands(Job.Input.native())) {
+        auto Args = std::move(Command.CommandLine);
+        if (Adjuster_)
+            Args = Adjuster_(Args, Command.Filename);
+
+        Manifest.setCommand(std::move(Args));
+    }
+
+    Manifest.save(Path, Message);
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::warning() << "failed to save manifest: "
+                     << Message << "\n";
+    }
+}
+
+bool Runner::writeDependencyFile(const Batch::Job &Job,
+                                 llvm::ArrayRef<std::string> Dependencies) const
+{
+    auto Path = getDependencyFile(Job);
+    std::string Content, Message;
+
+    if (Path.empty())
+        return true;
+
+    /*
+     * Example of a depfile as written by "-MD -MP" of GCC and Clang:
+     *      /build/mocks/a.inc: \
+     *        /src/a.c \
+     *        /src/a.h
+     *
+     *      /src/a.h:
+     *
+     * The empty rules keep make from failing if a header gets removed.
+     */
+    auto Files = collectDependencies(Job, Dependencies);
+    llvm::raw_string_ostream OS(Content);
+
+    writeMakePath(OS, Job.Output.native());
+    OS << ":";
+
+    for (const auto &File : Files) {
+        OS << " \\\n  ";
+        writeMakePath(OS, File);
+    }
+
+    OS << "\n";
+
+    for (const auto &File : Files) {
+        if (File == Job.Input.native())
+            continue;
+
+        OS << "\n";
+        writeMakePath(OS, File);
+        OS << ":\n";
+    }
+
+    (void) util::fs::writeIfChanged(Path.native(), OS.str(), Message);
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::error() << Message << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void Runner::initializeWorkers(unsigned int Count)
+{
+    auto Options = clang::FileSystemOptions();
+
+    /*
+     * Headers are usually included by many translation units. Sharing
+     * their status and contents between all workers avoids querying the
+     * (possibly remote) file system over and over again.
+     */
+    if (Config_->General.FileCache && !FileCache_)
+        FileCache_ = std::make_shared<util::FileCache>();
+
+    Workers_.clear();
+    Workers_.reserve(Count);
+
+    /*
+     * The dependency scanner caches the (minimized) contents of all files
+     * it reads for all workers. It never revalidates the cached files, so
+     * each run gets a new scanner to pick up changes in watch mode.
+     */
+    ScanningService_.reset();
+
+    if (ResultCache_ && Config_->General.Cache
+        && Config_->General.CacheKey == Config::CACHEKEY_SCAN) {
+        using namespace clang::tooling::dependencies;
+
+#if LLVM_VERSION_MAJOR >= 16
+        auto Mode = ScanningMode::DependencyDirectivesScan;
+#else
+        auto Mode = ScanningMode::MinimizedSourcePreprocessing;
+#endif
+
+        ScanningService_ = std::make_unique<DependencyScanningService>(
+            Mode, ScanningOutputFormat::Make);
+    }
+
+    for (unsigned int i = 0; i < Count; ++i) {
+        auto Worker = Runner::Worker();
+
+        /*
+         * The "ClangTool" changes the working directory of its file system
+         * for each compile command. For the real file system this is the
+         * working directory of the whole process which would affect all
+         * other threads. Each worker of a parallel run therefore gets its
+         * own physical file system with a private working directory.
+         */
+        if (Count == 1) {
+            Worker.FileSystem = llvm::vfs::getRealFileSystem();
+        } else {
+            auto FileSystem = llvm::vfs::createPhysicalFileSystem();
+            Worker.FileSystem = FileSystem.release();
+        }
+
+        /*
+         * In watch mode, the cache outlives a run but only modifications
+         * of known dependencies get reported. Revalidating picks up other
+         * changes, e.g. a header created after an include failed, while
+         * the contents of unchanged files are still reused.
+         */
+        if (FileCache_) {
+            auto Revalidate = Config_->General.RevalidateFileCache
+                              || Config_->General.Watch;
+
+            Worker.FileSystem = new util::CachingFileSystem(
+                std::move(Worker.FileSystem), FileCache_, Revalidate);
+        }
+
+        Worker.FileManager = new clang::FileManager(Options, Worker.FileSystem);
+
+        if (ScanningService_) {
+            Worker.Scanner =
+                std::make_unique<DependencyScanningTool>(*ScanningService_);
+        }
+
+        Workers_.push_back(std::move(Worker));
+    }
+}
+
+void Runner::initializeResultCache()
+{
+    const auto &General = Config_->General;
+
+    if (!(General.Cache || General.ASTCache || General.PCH) || ResultCache_)
+        return;
+
+    auto Directory = Config_->General.CacheDirectory;
+    if (Directory.empty())
+        Directory = ResultCache::getDefaultDirectory();
+
+    if (Directory.empty()) {
+        llvm::errs() << util::cl::warning()
+                     << "failed to determine the cache directory, "
+                        "caching disabled\n";
+        return;
+    }
+
+    /*
+     * The working directory might change while processing the batch,
+     * so the cache directory has to be an absolute path.
+     */
+    std::error_code Code;
+
+    Directory = std::filesystem::absolute(Directory, Code);
+    if (Code) {
+        llvm::errs() << util::cl::warning() << "\"" << Directory.native()
+                     << "\": " << Code.message() << ", caching disabled\n";
+        return;
+    }
+
+    ResultCache_ = std::make_shared<ResultCache>(std::move(Directory),
+                                                 Config_->General.CacheSize);
+}
+
+void Runner::printFileCacheStatistics() const
+{
+    const auto &Counters = FileCache_->getCounters();
+
+    auto Print = [](llvm::StringRef Name, uint64_t Hits, uint64_t Misses) {
+        auto Total = Hits + Misses;
+        auto Rate = (Total != 0) ? 100.0 * Hits / Total : 0.0;
+
+        llvm::errs() << util::cl::info() << "file cache: " << Name << ": "
+                     << Hits << " of " << Total << " hits ("
+                     << llvm::format("%.1f", Rate) << "%)\n";
+    };
+
+    Print("status", Counters.StatusHits, Counters.StatusMisses);
+    Print("read", Counters.ReadHits, Counters.ReadMisses);
+}
+
+void Runner::printResultCacheStatistics(const ResultCache::Usage &Usage) const
+{
+    const auto &Counters = ResultCache_->getCounters();
+
+    auto Hits = Counters.Hits.load();
+    auto Total = Hits + Counters.Misses;
+    auto Rate = (Total != 0) ? 100.0 * Hits / Total : 0.0;
+
+    llvm::errs() << util::cl::info() << "cache: " << Hits << " of " << Total
+                 << " hits (" << llvm::format("%.1f", Rate) << "%), "
+                 << Counters.Stores << " stored, " << Usage.Evictions
+                 << " evicted\n";
+
+    llvm::errs() << util::cl::info() << "cache: "
+                 << llvm::format("%.1f", Usage.Size / 1048576.0) << " MiB in "
+                 << Usage.Count << " files at \""
+                 << ResultCache_->getDirectory().native() << "\"\n";
+}
+
+std::shared_ptr<Config> Runner::makeConfig(const Batch::Job &Job) const
+{
+    /*
+     * Each job gets its own copy of the already parsed configuration
+     * which only differs in the job specific settings.
+     */
+    auto Config = std::make_shared<::Config>(*Config_);
+    Config->General.Input = Job.Input;
+    Config->General.Output = Job.Output;
+
+    if (Job.Backend)
+        Config->Mocking.Backend = *Job.Backend;
+
+    return Config;
+}
+
+bool Runner::needsDependencies() const
+{
+    const auto &General = Config_->General;
+
+    return General.Incremental || General.WriteDependencyFile
+           || !General.DependencyFile.empty();
+}
+
+std::filesystem::path Runner::getDependencyFile(const Batch::Job &Job) const
+{
+    const auto &General = Config_->General;
+
+    if (Job.Output.empty())
+        return std::filesystem::path();
+
+    if (!General.DependencyFile.empty())
+        return General.DependencyFile;
+
+    if (!General.WriteDependencyFile)
+        return std::filesystem::path();
+
+    auto Path = Job.Output;
+    Path += ".d";
+
+    return Path;
+}
+
+std::vector<std::string>
+Runner::collectDependencies(const Batch::Job &Job,
+                            llvm::ArrayRef<std::string> Dependencies) const
+{
+    auto Files = llvm::StringSet<>();
+    Files.insert(Job.Input.native());
+
+    for (const auto &File : Dependencies)
+        Files.insert(File);
+
+    for (const auto &File : CommonDependencies_)
+        Files.insert(File);
+
+    auto Result = std::vector<std::string>();
+    Result.reserve(Files.size());
+
+    for (const auto &Item : Files)
+        Result.push_back(Item.getKey().str());
+
+    llvm::sort(Result);
+
+    return Result;
+}
+
+uint64_t Runner::getCommandHash(const Batch::Job &Job) const
+{
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    /*
+     * Hash the compile command after applying the adjusters from the
+     * command-line. Adding the backend accounts for the differing
+     * generation times of the backends.
+     */
+    for (auto &Command : Commands_->getCompileCommands(Job.Input.native())) {
+        auto Args = std::move(Command.CommandLine);
+        if (Adjuster_)
+            Args = Adjuster_(Args, Command.Filename);
+
+        OS << Command.Directory << '\0';
+
+        for (const auto &Arg : Args)
+            OS << Arg << '\0';
+    }
+
+    OS << static_cast<int>(Job.Backend.value_or(Config_->Mocking.Backend));
+
+    return llvm::xxHash64(OS.str());
+}
+
+std::string Runner::getParseKey(const Batch::Job &Job) const
+{
+    /*
+     * Apply the same adjusters as the "ClangTool" to recognize commands
+     * which only differ in output and dependency file arguments.
+     */
+    const auto &Strip = getStripAdjuster();
+
+    if (!Adjuster_)
+        return CompilationDatabase::getParseKey(*Commands_, Job.Input, Strip);
+
+    auto Adjuster = clang::tooling::combineAdjusters(Adjuster_, Strip);
+
+    return CompilationDatabase::getParseKey(*Commands_, Job.Input, Adjuster);
+}
+
+std::string Runner::getASTKey(const Batch::Job &Job) const
+{
+    /*
+     * AST files can only be read by the exact same clang version. Changes
+     * to any of the files read while parsing are detected when loading
+     * the AST file.
+     */
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    OS << "ast" << '\0' << CCMOCK_VERSION_CORE << '\0' << LLVM_VERSION_STRING
+       << '\0' << MockActionFactory::getResourceDirectory(*Config_) << '\0'
+       << getParseKey(Job);
+
+    auto Hash = llvm::SHA1();
+    Hash.update(OS.str());
+
+    return llvm::toHex(Hash.final(), true);
+}
+
+std::string Runner::getManifestKey(const ::Config &Config) const
+{
+    /*
+     * The compile command and the adjusters are covered by the status of
+     * the compilation database and the clang specific settings. Changing
+     * the set of common files, e.g. a newly created compilation database
+     * further up in the directory tree, changes the key.
+     */
+    auto Copy = makeOutputConfig(Config);
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    OS << CCMOCK_VERSION_CORE << '\0';
+
+    for (const auto &File : CommonDependencies_)
+        OS << File << '\0';
+
+    Copy.write(OS);
+
+    auto Hash = llvm::SHA1();
+    Hash.update(OS.str());
+
+    return llvm::toHex(Hash.final(), true);
+}
+
+std::string Runner::getResultKey(const ::Config &Config,
+                                 llvm::StringRef TokenHash) const
+{
+    /* Everything affecting the parsed translation unit is in the hash */
+    auto Copy = makeOutputConfig(Config);
+    Copy.Clang = ::Config::ClangSection();
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    OS << CCMOCK_VERSION_CORE << '\0' << TokenHash << '\0';
+    Copy.write(OS);
+
+    auto Hash = llvm::SHA1();
+    Hash.update(OS.str());
+
+    return llvm::toHex(Hash.final(), true);
+}
+
+std::string Runner::getModelKey(const ::Config &Config,
+                                llvm::StringRef TokenHash) const
+{
+    /*
+     * Of the configuration only the mocking settings have an effect on the
+     * model. The backend does not, so the model of a translation unit can
+     * be used to generate the outputs of any backend.
+     */
+    auto Copy = ::Config();
+    Copy.Mocking = Config.Mocking;
+    Copy.Mocking.Backend = ::Config::MockingSection().Backend;
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    OS << "model" << '\0' << CCMOCK_VERSION_CORE << '\0' << TokenHash << '\0';
+    Copy.write(OS);
+
+    auto Hash = llvm::SHA1();
+    Hash.update(OS.str());
+
+    return llvm::toHex(Hash.final(), true);
+}
+
+bool Runner::loadModel(llvm::StringRef Key, MockModel &Model)
+{
+    auto Path = std::filesystem::path();
+
+    if (!ResultCache_->lookupFile(Key, Path))
+        return false;
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Path.native());
+    if (!MemBuffer)
+        return false;
+
+    std::string Error;
+
+    Model.read(MemBuffer.get()->getBuffer(), Error);
+    if (!Error.empty()) {
+        llvm::errs() << util::cl::warning() << "\"" << Path.native()
+                     << "\": " << Error << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void Runner::storeModel(llvm::StringRef Key, const MockModel &Model)
+{
+    std::string Buffer, Message;
+    llvm::raw_string_ostream OS(Buffer);
+
+    Model.write(OS);
+
+    ResultCache_->storeFile(Key, OS.str(), Message);
+    if (!Message.empty())
+        llvm::errs() << util::cl::warning() << Message << "\n";
+}
+
+bool Runner::scanDependencies(const Batch::Job &Job,
+                              Worker &Worker,
+                              std::string &Hash,
+                              std::vector<std::string> *Dependencies)
+{
+    using namespace clang::tooling;
+
+    auto Commands = Commands_->getCompileCommands(Job.Input.native());
+    if (Commands.empty())
+        return false;
+
+    /*
+     * Scan with the same command-line as used for parsing. The clang
+     * resource directory is required to find the compiler headers.
+     */
+    auto &Command = Commands.front();
+    auto Args = std::move(Command.CommandLine);
+    if (Adjuster_)
+        Args = Adjuster_(Args, Command.Filename);
+
+    Args = getStripAdjuster()(Args, Command.Filename);
+
+    auto Directory = MockActionFactory::getResourceDirectory(*Config_);
+    if (!Directory.empty()) {
+        auto Arg = "-resource-dir=" + Directory;
+        auto Insert = getInsertArgumentAdjuster(Arg.c_str(),
+                                                ArgumentInsertPosition::BEGIN);
+
+        Args = Insert(Args, Command.Filename);
+    }
+
+    auto Output = Worker.Scanner->getDependencyFile(Args, Command.Directory);
+    if (!Output) {
+        llvm::consumeError(Output.takeError());
+        return false;
+    }
+
+    auto Files = std::vector<std::string>();
+    parseMakeDependencies(*Output, Files);
+
+    if (Files.empty())
+        return false;
+
+    /*
+     * Equal command-lines and equal contents of all files read by the
+     * preprocessor result in equal token streams. This is stricter than
+     * hashing the tokens, e.g. changing a comment causes a miss, but does
+     * not require preprocessing the input file at all.
+     */
+    auto SHA = llvm::SHA1();
+
+    auto Update = [&](llvm::StringRef Data) {
+        SHA.update(Data);
+        SHA.update(llvm::StringRef("\0", 1));
+    };
+
+    Update(Command.Directory);
+
+    for (const auto &Arg : ::CompilationDatabase::getKeyArguments(Args))
+        Update(Arg);
+
+    for (const auto &File : Files) {
+        auto Path = llvm::SmallString<256>(File);
+
+        llvm::sys::fs::make_absolute(Command.Directory, Path);
+        llvm::sys::path::remove_dots(Path, true);
+
+        /* File contents are shared with the parser by the file cache */
+        auto Buffer = Worker.FileSystem->getBufferForFile(Path);
+        if (!Buffer)
+            return false;
+
+        Update(Path);
+        Update(Buffer.get()->getBuffer());
+
+        if (Dependencies)
+            Dependencies->push_back(Path.str().str());
+    }
+
+    Hash = llvm::toHex(SHA.final(), true);
+
+    return true;
+}
+
+bool Runner::hashTokens(const Batch::Job &Job,
+                        Worker &Worker,
+                        const std::shared_ptr<const ::Config> &Config,
+                        std::string &Hash,
+                        std::vector<std::string> *Dependencies)
+{
+    auto Factory = TokenHashActionFactory();
+    Factory.setConfig(Config);
+    Factory.setHash(&Hash);
+    Factory.setDependencies(Dependencies);
+
+    auto Tool = clang::tooling::ClangTool(
+        *Commands_,
+        Job.Input.native(),
+        std::make_shared<clang::PCHContainerOperations>(),
+        Worker.FileSystem,
+        Worker.FileManager);
+
+    if (Adjuster_)
+        Tool.appendArgumentsAdjuster(Adjuster_);
+
+    /* Diagnostics are reported when parsing the translation unit */
+    auto Consumer = clang::IgnoringDiagConsumer();
+    Tool.setDiagnosticConsumer(&Consumer);
+
+    if (Tool.run(&Factory) != 0 || Hash.empty())
+        return false;
+
+    /*
+     * Arguments like "-fno-builtin" or "-fms-extensions" change the
+     * semantic analysis without changing a single token. As for the
+     * dependency scan, the effective compile command is part of the hash.
+     */
+    auto SHA = llvm::SHA1();
+    SHA.update(Hash);
+    SHA.update(getParseKey(Job));
+
+    Hash = llvm::toHex(SHA.final(), true);
+
+    return true;
+}
+
+void Runner::storeOutputs(
+    llvm::ArrayRef<std::string> Keys,
+    llvm::ArrayRef<std::shared_ptr<const ::Config>> Configs,
+    llvm::ArrayRef<llvm::raw_string_ostream *> Streams)
+{
+    for (size_t i = 0, Size = Keys.size(); i < Size; ++i) {
+        const auto &Path = Configs[i]->General.Output.native();
+        std::string Message;
+
+        if (Path.empty()) {
+            ResultCache_->store(Keys[i], Streams[i]->str(), Message);
+        } else {
+            auto MemBuffer = llvm::MemoryBuffer::getFile(Path);
+            if (!MemBuffer)
+                continue;
+
+            ResultCache_->store(Keys[i], MemBuffer.get()->getBuffer(), Message);
+        }
+
+        if (!Message.empty()) {
+            llvm::errs() << util::cl::warning()
+                         << "failed to cache output: " << Message << "\n";
+        }
+    }
+}
+
+int Runner::run(llvm::ArrayRef<const Batch::Job *> Jobs,
+                Worker &Worker,
+                llvm::ArrayRef<llvm::raw_string_ostream *> Streams,
+                llvm::ArrayRef<Statistics *> Stats,
+                std::vector<std::string> *Dependencies)
+{
+    auto Configs = std::vector<std::shared_ptr<const ::Config>>();
+    Configs.reserve(Jobs.size());
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+        const auto &Job = *Jobs[i];
+
+        auto Config = makeConfig(Job);
+
+        if (Config->General.Verbose) {
+            /* Avoid interleaving the messages of concurrently running jobs */
+            auto Lock = std::lock_guard(Mutex_);
+
+            llvm::errs() << util::cl::info() << "processing \""
+                         << Job.Input.native() << "\"";
+
+            if (!Job.Output.empty())
+                llvm::errs() << " -> \"" << Job.Output.native() << "\"";
+
+            llvm::errs() << "\n";
+        }
+
+        Configs.push_back(std::move(Config));
+    }
+
+    /*
+     * Preprocessing is much cheaper than parsing, so look up the outputs
+     * in the result cache first. On a single miss all outputs get
+     * generated again, either from the cached model of the translation
+     * unit, e.g. for outputs of another backend, or by parsing it.
+     */
+    auto Factory = MockActionFactory();
+    auto Keys = std::vector<std::string>();
+    auto ModelKey = std::string();
+    auto Cached = false;
+
+    for (size_t i = 0, Size = Jobs.size(); i < Size; ++i)
+        Factory.addOutput({Configs[i], Streams[i], Stats[i]});
+
+    Factory.setThreads(ModelThreads_);
+
+    if (ResultCache_ && Config_->General.Cache) {
+        auto Contents = std::vector<std::string>(Jobs.size());
+        std::string Hash;
+
+        auto Hashed = false;
+
+        /* Fall back to preprocessing if the dependency scan fails */
+        if (Worker.Scanner)
+            Hashed = scanDependencies(*Jobs.front(), Worker, Hash,
+                                      Dependencies);
+
+        if (!Hashed) {
+            if (Dependencies)
+                Dependencies->clear();
+
+            Hashed = hashTokens(*Jobs.front(), Worker, Configs.front(), Hash,
+                                Dependencies);
+        }
+
+        if (Hashed) {
+            for (const auto &Config : Configs)
+                Keys.push_back(getResultKey(*Config, Hash));
+
+            size_t Hits = 0;
+            while (Hits < Keys.size()
+                   && ResultCache_->lookup(Keys[Hits], Contents[Hits]))
+                ++Hits;
+
+            if (Hits == Keys.size()) {
+                for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+                    if (!writeOutput(*Configs[i], Contents[i], *Streams[i]))
+                        return 1;
+
+                    Stats[i]->Cached = true;
+                }
+
+                if (Config_->General.Verbose) {
+                    auto Lock = std::lock_guard(Mutex_);
+
+                    for (const auto *Job : Jobs) {
+                        llvm::errs() << util::cl::info() << "finished \""
+                                     << Job->Input.native() << "\" (cached)\n";
+                    }
+                }
+
+                return 0;
+            }
+
+            /* The dependencies are already known from hashing the tokens */
+            auto Model = MockModel();
+
+            ModelKey = getModelKey(*Configs.front(), Hash);
+            if (loadModel(ModelKey, Model)) {
+                Factory.setModel(std::move(Model));
+                Cached = true;
+
+                for (auto *Item : Stats)
+                    Item->Cached = true;
+            }
+        }
+
+        /* The dependencies get collected again while parsing */
+        if (Dependencies && !Cached)
+            Dependencies->clear();
+    }
+
+    if (!Cached)
+        Factory.setDependencies(Dependencies);
+
+    auto Start = std::chrono::steady_clock::now();
+
+    int Result = Cached ? 0 : -1;
+    std::string ASTKey, ASTFile;
+
+    if (!Cached && ResultCache_ && Config_->General.ASTCache) {
+        auto Path = std::filesystem::path();
+
+        ASTKey = getASTKey(*Jobs.front());
+
+        /* Stale AST files are rejected while loading them */
+        if (ResultCache_->lookupFile(ASTKey, Path)) {
+            if (auto Unit = MockActionFactory::loadASTFile(Path.native()))
+                Result = Factory.collect(*Unit) ? 0 : 1;
+        }
+
+        /* Loading an AST file tells nothing about the parsing costs */
+        if (Result >= 0) {
+            for (auto *Item : Stats)
+                Item->Cached = true;
+        }
+
+        if (Result < 0)
+            Factory.setASTFile(&ASTFile);
+    }
+
+    /* AST files must not depend on a PCH which may go away */
+    if (Result < 0)
+        Result = runTool(*Jobs.front(), Worker, Factory, ASTKey.empty());
+
+    if (Result == 0 && !ASTFile.empty()) {
+        std::string Message;
+
+        ResultCache_->storeFile(ASTKey, ASTFile, Message);
+        if (!Message.empty())
+            llvm::errs() << util::cl::warning() << Message << "\n";
+    }
+
+    /* The translation unit is released at this point */
+    if (Factory.getModel()) {
+        Factory.generate();
+
+        if (Result == 0 && !Cached && !ModelKey.empty())
+            storeModel(ModelKey, *Factory.getModel());
+    }
+
+    /* Everything apart from generating the outputs is spent on parsing */
+    auto Elapsed = std::chrono::steady_clock::now() - Start;
+    auto ParseTime = std::chrono::nanoseconds(Elapsed);
+
+    if (Result == 0 && !Keys.empty())
+        storeOutputs(Keys, Configs, Streams);
+
+    for (const auto *Item : Stats)
+        ParseTime -= Item->GenerateTime;
+
+    for (auto *Item : Stats)
+        Item->ParseTime = ParseTime;
+
+    if (Config_->General.Verbose) {
+        using Milliseconds = std::chrono::milliseconds;
+
+        auto Lock = std::lock_guard(Mutex_);
+
+        for (size_t i = 0, Size = Jobs.size(); i < Size; ++i) {
+            const auto &Item = *Stats[i];
+
+            auto Parse = std::chrono::duration_cast<Milliseconds>(ParseTime);
+            auto Generate =
+                std::chrono::duration_cast<Milliseconds>(Item.GenerateTime);
+
+            llvm::errs() << util::cl::info() << "finished \""
+                         << Jobs[i]->Input.native() << "\" (parse: "
+                         << Parse.count() << " ms, generate: "
+                         << Generate.count() << " ms, memory: "
+                         << (Item.Memory >> 20) << " MiB)\n";
+        }
+    }
+
+    return Result;
+}
+
+int Runner::runTool(const Batch::Job &Job,
+                    Worker &Worker,
+                    MockActionFactory &Factory,
+                    bool UsePCH)
+{
+    /*
+     * Passing the same file manager to every "ClangTool" of a worker
+     * allows to reuse already looked up file entries and loaded header
+     * files across all translation units processed by the worker.
+     */
+    auto Tool = clang::tooling::ClangTool(
+        *Commands_,
+        Job.Input.native(),
+        std::make_shared<clang::PCHContainerOperations>(),
+        Worker.FileSystem,
+        Worker.FileManager);
+
+    if (Adjuster_)
+        Tool.appendArgumentsAdjuster(Adjuster_);
+
+    if (UsePCH && PCHAdjuster_)
+        Tool.appendArgumentsAdjuster(PCHAdjuster_);
+
+    if (UsePCH && Preambles_)
+        Factory.setPreambleCache(Preambles_.get());
+
+    return Tool.run(&Factory);
+}
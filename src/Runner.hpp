@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RUNNER_HPP_
+#define RUNNER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <clang/Basic/FileManager.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/DependencyScanning/DependencyScanningService.h>
+#include <clang/Tooling/DependencyScanning/DependencyScanningTool.h>
+
+#include "Batch.hpp"
+#include "Config.hpp"
+#include "History.hpp"
+#include "MockAction.hpp"
+#include "PreambleCache.hpp"
+#include "ResultCache.hpp"
+#include "Statistics.hpp"
+#include "util/FileCache.hpp"
+
+/*
+ * Processes all jobs of a batch within the same process. The parsed
+ * configuration and the compilation database are shared by all
+ * translation units. Each worker thread owns a file system and a
+ * file manager which get reused for all jobs processed by it. All file
+ * systems share a single in-memory file cache. Outputs and mock models
+ * can be reused across invocations by a persistent result cache. While
+ * watching for changes, the preamble of each input file is kept as well.
+ */
+
+class Runner {
+public:
+    Runner(std::shared_ptr<const Config> Config,
+           const clang::tooling::CompilationDatabase &Commands);
+
+    void appendArgumentsAdjuster(clang::tooling::ArgumentsAdjuster Adjuster);
+    void setHistoryFile(const std::filesystem::path &Path);
+    void setCommonDependencies(std::vector<std::string> Files);
+
+    bool isUpToDate(const Batch &Batch) const;
+
+    std::vector<double> estimate(const Batch &Batch) const;
+    std::vector<uint64_t> estimateMemory(const Batch &Batch) const;
+
+    int run(const Batch &Batch);
+    int watch(const Batch &Batch);
+
+private:
+    using DependencyScanningService =
+        clang::tooling::dependencies::DependencyScanningService;
+    using DependencyScanningTool =
+        clang::tooling::dependencies::DependencyScanningTool;
+
+    struct Worker {
+    public:
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem;
+        llvm::IntrusiveRefCntPtr<clang::FileManager> FileManager;
+        std::unique_ptr<DependencyScanningTool> Scanner;
+    };
+
+    void initializeWorkers(unsigned int Count);
+    void initializeResultCache();
+    void printFileCacheStatistics() const;
+    void printResultCacheStatistics(const ResultCache::Usage &Usage) const;
+    void saveManifest(const Batch::Job &Job,
+                      llvm::ArrayRef<std::string> Dependencies,
+                      std::chrono::system_clock::time_point Start) const;
+    bool writeDependencyFile(const Batch::Job &Job,
+                             llvm::ArrayRef<std::string> Dependencies) const;
+    std::shared_ptr<::Config> makeConfig(const Batch::Job &Job) const;
+    bool needsDependencies() const;
+    std::filesystem::path getDependencyFile(const Batch::Job &Job) const;
+    std::vector<std::string>
+    collectDependencies(const Batch::Job &Job,
+                        llvm::ArrayRef<std::string> Dependencies) const;
+    uint64_t getCommandHash(const Batch::Job &Job) const;
+    std::string getParseKey(const Batch::Job &Job) const;
+    std::string getASTKey(const Batch::Job &Job) const;
+    std::string getManifestKey(const ::Config &Config) const;
+    std::string getResultKey(const ::Config &Config,
+                             llvm::StringRef TokenHash) const;
+    std::string getModelKey(const ::Config &Config,
+                            llvm::StringRef TokenHash) const;
+    bool loadModel(llvm::StringRef Key, MockModel &Model);
+    void storeModel(llvm::StringRef Key, const MockModel &Model);
+
+    int run(const Batch &Batch,
+            std::vector<std::vector<std::string>> *Dependencies);
+    int run(llvm::ArrayRef<const Batch::Job *> Jobs,
+            Worker &Worker,
+            llvm::ArrayRef<llvm::raw_string_ostream *> Streams,
+            llvm::ArrayRef<Statistics *> Stats,
+            std::vector<std::string> *Dependencies);
+    int runTool(const Batch::Job &Job,
+                Worker &Worker,
+                MockActionFactory &Factory,
+                bool UsePCH);
+    bool scanDependencies(const Batch::Job &Job,
+                          Worker &Worker,
+                          std::string &Hash,
+                          std::vector<std::string> *Dependencies);
+    bool hashTokens(const Batch::Job &Job,
+                    Worker &Worker,
+                    const std::shared_ptr<const ::Config> &Config,
+                    std::string &Hash,
+                    std::vector<std::string> *Dependencies);
+    void storeOutputs(llvm::ArrayRef<std::string> Keys,
+                      llvm::ArrayRef<std::shared_ptr<const ::Config>> Configs,
+                      llvm::ArrayRef<llvm::raw_string_ostream *> Streams);
+    std::shared_ptr<const Config> Config_;
+    const clang::tooling::CompilationDatabase *Commands_;
+    clang::tooling::ArgumentsAdjuster Adjuster_;
+    clang::tooling::ArgumentsAdjuster PCHAdjuster_;
+    std::shared_ptr<PreambleCache> Preambles_;
+
+    /* Threads available to each job for resolving its mock model */
+    unsigned int ModelThreads_;
+
+    std::unique_ptr<DependencyScanningService> ScanningService_;
+    std::vector<Worker> Workers_;
+    std::shared_ptr<util::FileCache> FileCache_;
+    std::shared_ptr<ResultCache> ResultCache_;
+    std::mutex Mutex_;
+    History History_;
+    std::filesystem::path HistoryFile_;
+    std::vector<std::string> CommonDependencies_;
+};
+
+#endif /* RUNNER_HPP_ */
@@ -0,0 +1,648 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Server.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "util/commandline.hpp"
+
+namespace {
+
+/*
+ * A request consists of a header with the size of the payload followed
+ * by the payload itself. The standard streams of the client are passed
+ * along with the header. The payload is a sequence of null-terminated
+ * strings:
+ *      <working directory> <environment> <argv[0]> ... <argv[argc - 1]>
+ *
+ * The environment consists of the values of the forwarded environment
+ * variables in order, where an empty string denotes an unset variable.
+ * The server answers with the exit status of the processed request.
+ */
+constexpr size_t StreamCount = 3;
+constexpr uint32_t MaxPayloadSize = 1 << 20;
+
+/*
+ * Environment variables of the client which influence the processing of
+ * a request, e.g. the include paths read by clang or the detection of
+ * colored output.
+ */
+constexpr std::array<const char *, 9> Environment = {
+    "CCMOCK_CONFIG",
+    "CPATH",
+    "C_INCLUDE_PATH",
+    "CPLUS_INCLUDE_PATH",
+    "OBJC_INCLUDE_PATH",
+    "OBJCPLUS_INCLUDE_PATH",
+    "SOURCE_DATE_EPOCH",
+    "TERM",
+    "TMPDIR",
+};
+
+/* NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables) */
+std::array<int, 2> SignalPipe = {-1, -1};
+volatile std::sig_atomic_t Terminate = 0;
+/* NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables) */
+
+void handleSignal(int Signal)
+{
+    int Errno = errno;
+    char Byte = 0;
+
+    if (Signal != SIGCHLD)
+        Terminate = 1;
+
+    /* Wake up the server waiting for new connections */
+    (void) ::write(SignalPipe[1], &Byte, sizeof(Byte));
+
+    errno = Errno;
+}
+
+std::string getErrorMessage()
+{
+    return std::error_code(errno, std::generic_category()).message();
+}
+
+bool makeAddress(const std::filesystem::path &Path, sockaddr_un &Address)
+{
+    const auto &Item = Path.native();
+
+    std::memset(&Address, 0, sizeof(Address));
+    Address.sun_family = AF_UNIX;
+
+    if (Item.size() >= sizeof(Address.sun_path))
+        return false;
+
+    std::memcpy(Address.sun_path, Item.c_str(), Item.size() + 1);
+
+    return true;
+}
+
+bool writeAll(int Socket, const void *Data, size_t Size)
+{
+    const auto *Ptr = static_cast<const char *>(Data);
+
+    while (Size > 0) {
+        auto Count = ::send(Socket, Ptr, Size, MSG_NOSIGNAL);
+        if (Count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        Ptr += Count;
+        Size -= Count;
+    }
+
+    return true;
+}
+
+bool readAll(int Socket, void *Data, size_t Size)
+{
+    auto *Ptr = static_cast<char *>(Data);
+
+    while (Size > 0) {
+        auto Count = ::recv(Socket, Ptr, Size, 0);
+        if (Count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        if (Count == 0)
+            return false;
+
+        Ptr += Count;
+        Size -= Count;
+    }
+
+    return true;
+}
+
+bool sendHeader(int Socket, uint32_t Size)
+{
+    const std::array<int, StreamCount> Streams = {
+        STDIN_FILENO,
+        STDOUT_FILENO,
+        STDERR_FILENO,
+    };
+
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(Streams))> Control;
+    Control.fill(0);
+
+    auto Vec = iovec{&Size, sizeof(Size)};
+    auto Message = msghdr();
+
+    Message.msg_iov = &Vec;
+    Message.msg_iovlen = 1;
+    Message.msg_control = Control.data();
+    Message.msg_controllen = Control.size();
+
+    auto *Header = CMSG_FIRSTHDR(&Message);
+    Header->cmsg_level = SOL_SOCKET;
+    Header->cmsg_type = SCM_RIGHTS;
+    Header->cmsg_len = CMSG_LEN(sizeof(Streams));
+
+    std::memcpy(CMSG_DATA(Header), Streams.data(), sizeof(Streams));
+
+    ssize_t Count;
+    do {
+        Count = ::sendmsg(Socket, &Message, MSG_NOSIGNAL);
+    } while (Count < 0 && errno == EINTR);
+
+    return Count == sizeof(Size);
+}
+
+bool receiveHeader(int Socket,
+                   uint32_t &Size,
+                   std::array<int, StreamCount> &Streams)
+{
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(Streams))> Control;
+    Control.fill(0);
+
+    auto Vec = iovec{&Size, sizeof(Size)};
+    auto Message = msghdr();
+
+    Message.msg_iov = &Vec;
+    Message.msg_iovlen = 1;
+    Message.msg_control = Control.data();
+    Message.msg_controllen = Control.size();
+
+    ssize_t Count;
+    do {
+        Count = ::recvmsg(Socket, &Message, MSG_CMSG_CLOEXEC);
+    } while (Count < 0 && errno == EINTR);
+
+    if (Count < 0)
+        return false;
+
+    /* Take ownership of all received file descriptors first */
+    auto *Header = CMSG_FIRSTHDR(&Message);
+    for (; Header; Header = CMSG_NXTHDR(&Message, Header)) {
+        if (Header->cmsg_level != SOL_SOCKET
+            || Header->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        auto Num = (Header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        Num = std::min(Num, Streams.size());
+
+        std::memcpy(Streams.data(), CMSG_DATA(Header), Num * sizeof(int));
+    }
+
+    if (Count != sizeof(Size) || (Message.msg_flags & MSG_CTRUNC))
+        return false;
+
+    return llvm::all_of(Streams, [](int Item) { return Item >= 0; });
+}
+
+void closeStreams(std::array<int, StreamCount> &Streams)
+{
+    for (auto &Item : Streams) {
+        if (Item >= 0)
+            ::close(Item);
+
+        Item = -1;
+    }
+}
+
+[[noreturn]] void execute(llvm::ArrayRef<llvm::StringRef> Payload,
+                          std::array<int, StreamCount> &Streams,
+                          llvm::function_ref<int(int, const char **)> Main)
+{
+    for (int i = 0; i < static_cast<int>(Streams.size()); ++i) {
+        if (Streams[i] != i)
+            ::dup2(Streams[i], i);
+    }
+
+    for (auto Item : Streams) {
+        if (Item >= static_cast<int>(Streams.size()))
+            ::close(Item);
+    }
+
+    /* The payload strings are null-terminated within the request */
+    auto Directory = Payload[0];
+    auto Values = Payload.slice(1, Environment.size());
+
+    if (::chdir(Directory.data()) < 0) {
+        llvm::errs() << util::cl::error() << "failed to change directory to \""
+                     << Directory << "\": " << getErrorMessage() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    /* Apply the environment before anything of the request reads it */
+    for (size_t i = 0, Size = Environment.size(); i < Size; ++i) {
+        if (Values[i].empty())
+            ::unsetenv(Environment[i]);
+        else
+            ::setenv(Environment[i], Values[i].data(), 1);
+    }
+
+    /*
+     * The streams belong to the client now, so colors must be detected
+     * again. All options still hold the values of the server invocation.
+     */
+    auto HasColors = llvm::sys::Process::FileDescriptorHasColors(STDERR_FILENO);
+    llvm::errs().enable_colors(HasColors);
+
+    llvm::cl::ResetAllOptionOccurrences();
+
+    auto Args = std::vector<const char *>();
+    Args.reserve(Payload.size() - Environment.size() - 1);
+
+    for (auto Item : Payload.drop_front(Environment.size() + 1))
+        Args.push_back(Item.data());
+
+    std::exit(Main(static_cast<int>(Args.size()), Args.data()));
+}
+
+[[noreturn]] void handle(int Connection,
+                         llvm::function_ref<int(int, const char **)> Main)
+{
+    std::signal(SIGCHLD, SIG_DFL);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    /* Do not let a misbehaving client keep this process around forever */
+    auto Timeout = timeval{5, 0};
+    ::setsockopt(Connection,
+                 SOL_SOCKET,
+                 SO_RCVTIMEO,
+                 &Timeout,
+                 sizeof(Timeout));
+
+    std::array<int, StreamCount> Streams = {-1, -1, -1};
+    std::string Buffer;
+    uint32_t Size = 0;
+
+    bool Ok = receiveHeader(Connection, Size, Streams);
+    if (Ok && Size <= MaxPayloadSize) {
+        Buffer.resize(Size);
+        Ok = readAll(Connection, Buffer.data(), Size);
+    }
+
+    /* Working directory, environment and at least one argument */
+    auto Payload = llvm::SmallVector<llvm::StringRef, 16>();
+    if (Ok && Size <= MaxPayloadSize && !Buffer.empty()
+        && Buffer.back() == '\0') {
+        llvm::StringRef(Buffer).drop_back().split(Payload, '\0');
+        Ok = Payload.size() >= Environment.size() + 2;
+    } else {
+        Ok = false;
+    }
+
+    if (!Ok) {
+        closeStreams(Streams);
+        std::exit(EXIT_FAILURE);
+    }
+
+    /* The server answers the client once this process exits */
+    ::close(Connection);
+
+    execute(Payload, Streams, Main);
+}
+
+bool isSameUser(int Connection)
+{
+    auto Credentials = ucred();
+    auto Length = static_cast<socklen_t>(sizeof(Credentials));
+
+    if (::getsockopt(Connection,
+                     SOL_SOCKET,
+                     SO_PEERCRED,
+                     &Credentials,
+                     &Length)
+        < 0)
+        return false;
+
+    return Credentials.uid == ::getuid();
+}
+
+} // namespace
+
+Server::Server(std::filesystem::path Path)
+    : Path_(std::move(Path))
+{
+}
+
+Server::~Server()
+{
+    for (const auto &Item : Children_)
+        ::close(Item.second);
+
+    if (Socket_ >= 0) {
+        std::error_code Code;
+
+        ::close(Socket_);
+        std::filesystem::remove(Path_, Code);
+    }
+}
+
+int Server::run(llvm::function_ref<int(int, const char **)> Main,
+                llvm::function_ref<void()> Refresh)
+{
+    std::string Error;
+
+    listen(Error);
+    if (!Error.empty()) {
+        llvm::errs() << util::cl::error() << Error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (::pipe2(SignalPipe.data(), O_CLOEXEC | O_NONBLOCK) < 0) {
+        llvm::errs() << util::cl::error() << "failed to create pipe: "
+                     << getErrorMessage() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction Action = {};
+    Action.sa_handler = handleSignal;
+    Action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&Action.sa_mask);
+
+    for (auto Signal : {SIGCHLD, SIGINT, SIGTERM})
+        ::sigaction(Signal, &Action, nullptr);
+
+    std::array<pollfd, 2> Files = {{
+        {Socket_, POLLIN, 0},
+        {SignalPipe[0], POLLIN, 0},
+    }};
+
+    while (!Terminate) {
+        if (::poll(Files.data(), Files.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            llvm::errs() << util::cl::error() << "failed to wait for "
+                         << "requests: " << getErrorMessage() << "\n";
+            return EXIT_FAILURE;
+        }
+
+        if (Files[1].revents & POLLIN) {
+            char Buffer[64];
+            while (::read(SignalPipe[0], Buffer, sizeof(Buffer)) > 0)
+                ;
+
+            reap();
+        }
+
+        if (Files[0].revents & POLLIN) {
+            /*
+             * Children inherit the state of the server, so bring it up
+             * to date before processing the next request.
+             */
+            Refresh();
+
+            accept(Main);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void Server::listen(std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+    std::error_code Code;
+    sockaddr_un Address;
+
+    if (!makeAddress(Path_, Address)) {
+        OS << "socket path \"" << Path_.native() << "\" is too long";
+        return;
+    }
+
+    /* Replace the socket of a server which did not shut down cleanly */
+    if (std::filesystem::is_socket(Path_, Code)) {
+        auto Other = Client(Path_);
+        std::string Message;
+
+        Other.connect(Message);
+        if (Message.empty()) {
+            OS << "\"" << Path_.native() << "\": server already running";
+            return;
+        }
+
+        std::filesystem::remove(Path_, Code);
+    }
+
+    int Socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (Socket < 0) {
+        OS << "failed to create socket: " << getErrorMessage();
+        return;
+    }
+
+    /*
+     * Requests are processed with the rights of the server, so no other
+     * user may connect to it. The socket file is created with the
+     * permissions granted by the umask.
+     */
+    auto Mask = ::umask(S_IRWXG | S_IRWXO);
+
+    auto *Addr = reinterpret_cast<const sockaddr *>(&Address);
+    if (::bind(Socket, Addr, sizeof(Address)) < 0) {
+        OS << "failed to bind \"" << Path_.native()
+           << "\": " << getErrorMessage();
+        ::umask(Mask);
+        ::close(Socket);
+        return;
+    }
+
+    ::umask(Mask);
+
+    Socket_ = Socket;
+
+    if (::listen(Socket_, SOMAXCONN) < 0)
+        OS << "failed to listen on \"" << Path_.native()
+           << "\": " << getErrorMessage();
+}
+
+void Server::accept(llvm::function_ref<int(int, const char **)> Main)
+{
+    int Connection = ::accept4(Socket_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (Connection < 0)
+        return;
+
+    /* Also reject other users if the socket permissions were changed */
+    if (!isSameUser(Connection)) {
+        ::close(Connection);
+        return;
+    }
+
+    /* Do not duplicate buffered output within the child */
+    llvm::outs().flush();
+
+    /*
+     * The request is read by the child, so a slow or stalled client
+     * never blocks the server from accepting other clients.
+     */
+    auto Pid = ::fork();
+    if (Pid == 0) {
+        for (const auto &Item : Children_)
+            ::close(Item.second);
+
+        ::close(Socket_);
+        ::close(SignalPipe[0]);
+        ::close(SignalPipe[1]);
+
+        handle(Connection, Main);
+    }
+
+    if (Pid < 0) {
+        int32_t Status = EXIT_FAILURE;
+
+        llvm::errs() << util::cl::error() << "failed to fork: "
+                     << getErrorMessage() << "\n";
+        (void) writeAll(Connection, &Status, sizeof(Status));
+        ::close(Connection);
+        return;
+    }
+
+    Children_[Pid] = Connection;
+}
+
+void Server::reap()
+{
+    int Status;
+    pid_t Pid;
+
+    while ((Pid = ::waitpid(-1, &Status, WNOHANG)) > 0) {
+        auto It = Children_.find(Pid);
+        if (It == Children_.end())
+            continue;
+
+        int32_t Result = EXIT_FAILURE;
+        if (WIFEXITED(Status))
+            Result = WEXITSTATUS(Status);
+        else if (WIFSIGNALED(Status))
+            Result = 128 + WTERMSIG(Status);
+
+        (void) writeAll(It->second, &Result, sizeof(Result));
+        ::close(It->second);
+
+        Children_.erase(It);
+    }
+}
+
+Client::Client(std::filesystem::path Path)
+    : Path_(std::move(Path))
+{
+}
+
+Client::~Client()
+{
+    if (Socket_ >= 0)
+        ::close(Socket_);
+}
+
+void Client::connect(std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+    sockaddr_un Address;
+
+    if (!makeAddress(Path_, Address)) {
+        OS << "socket path \"" << Path_.native() << "\" is too long";
+        return;
+    }
+
+    Socket_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (Socket_ < 0) {
+        OS << "failed to create socket: " << getErrorMessage();
+        return;
+    }
+
+    auto *Addr = reinterpret_cast<const sockaddr *>(&Address);
+    if (::connect(Socket_, Addr, sizeof(Address)) < 0) {
+        OS << "failed to connect to \"" << Path_.native()
+           << "\": " << getErrorMessage();
+        ::close(Socket_);
+        Socket_ = -1;
+    }
+}
+
+int Client::run(llvm::ArrayRef<const char *> Args)
+{
+    std::error_code Code;
+    std::string Payload;
+
+    auto Directory = std::filesystem::current_path(Code);
+    if (Code) {
+        llvm::errs() << util::cl::error() << "failed to get working "
+                     << "directory: " << Code.message() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    Payload += Directory.native();
+    Payload += '\0';
+
+    for (const auto *Name : Environment) {
+        if (const char *Value = ::getenv(Name))
+            Payload += Value;
+
+        Payload += '\0';
+    }
+
+    for (const auto *Arg : Args) {
+        Payload += Arg;
+        Payload += '\0';
+    }
+
+    if (Payload.size() > MaxPayloadSize) {
+        llvm::errs() << util::cl::error() << "command-line too long\n";
+        return EXIT_FAILURE;
+    }
+
+    auto Size = static_cast<uint32_t>(Payload.size());
+
+    if (!sendHeader(Socket_, Size)
+        || !writeAll(Socket_, Payload.data(), Payload.size())) {
+        llvm::errs() << util::cl::error() << "failed to send request to \""
+                     << Path_.native() << "\": " << getErrorMessage() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    /* The output of the request is written directly to our streams */
+    int32_t Status;
+    if (!readAll(Socket_, &Status, sizeof(Status))) {
+        llvm::errs() << util::cl::error() << "lost connection to \""
+                     << Path_.native() << "\"\n";
+        return EXIT_FAILURE;
+    }
+
+    return Status;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_HPP_
+#define SERVER_HPP_
+
+#include <filesystem>
+#include <string>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/STLExtras.h>
+
+/*
+ * Persistent ccmock process which answers requests sent over a Unix
+ * domain socket. Each request is processed by a forked child process, so
+ * every request starts with the state the server already initialized
+ * (e.g. loaded libraries, registered options and loaded compilation
+ * databases). A client passes its standard streams with the request and
+ * the child writes its output directly to them. Only clients of the same
+ * user are accepted.
+ */
+
+class Server {
+public:
+    explicit Server(std::filesystem::path Path);
+    ~Server();
+
+    int run(llvm::function_ref<int(int, const char **)> Main,
+            llvm::function_ref<void()> Refresh);
+
+private:
+    void listen(std::string &Error);
+    void accept(llvm::function_ref<int(int, const char **)> Main);
+    void reap();
+
+    std::filesystem::path Path_;
+    int Socket_ = -1;
+    llvm::DenseMap<int, int> Children_;
+};
+
+/*
+ * Forwards an invocation of ccmock to a server and waits for its result.
+ */
+
+class Client {
+public:
+    explicit Client(std::filesystem::path Path);
+    ~Client();
+
+    void connect(std::string &Error);
+    int run(llvm::ArrayRef<const char *> Args);
+
+private:
+    std::filesystem::path Path_;
+    int Socket_ = -1;
+};
+
+#endif /* SERVER_HPP_ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATISTICS_HPP_
+#define STATISTICS_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Measurements collected while processing a single translation unit.
+ */
+
+struct Statistics {
+public:
+    Statistics() = default;
+
+    std::chrono::nanoseconds ParseTime = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds GenerateTime = std::chrono::nanoseconds::zero();
+
+    /* Memory allocated by the compiler for the AST and the source code */
+    uint64_t Memory = 0;
+
+    /*
+     * Growth of the peak resident memory of the process while processing
+     * the translation unit. Only measured if it was processed on its own,
+     * as concurrent jobs share the resident memory of the process.
+     */
+    uint64_t Resident = 0;
+
+    /*
+     * The output or the model or AST of the translation unit was taken
+     * from the result cache, so the measurements do not reflect the costs
+     * of parsing it.
+     */
+    bool Cached = false;
+};
+
+#endif /* STATISTICS_HPP_ */
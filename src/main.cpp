@@ -21,14 +21,20 @@
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Tooling/Tooling.h>
 
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringSwitch.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
 
 #include "util/commandline.hpp"
 
+#include "ArgumentRewriter.hpp"
+#include "Batch.hpp"
 #include "CompilationDatabase.hpp"
 #include "Config.hpp"
 #include "MockAction.hpp"
+#include "Runner.hpp"
+#include "Server.hpp"
 
 #ifndef CCMOCK_VERSION_CORE
 #error Preprocessor macro "CCMOCK_VERSION_CORE" not defined.
@@ -44,12 +50,57 @@
 static llvm::cl::OptionCategory ToolCategory("Tool Options");
 
 
-static llvm::cl::opt<std::string> Input(
-    llvm::cl::desc("<file>"),
+static llvm::cl::list<std::string> Inputs(
+    llvm::cl::desc("<file>..."),
     llvm::cl::value_desc("file"),
     llvm::cl::ValueRequired,
     llvm::cl::Positional,
-    llvm::cl::Optional,
+    llvm::cl::ZeroOrMore,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> ASTCache(
+    "ast-cache",
+    llvm::cl::desc(
+        "Store parsed translation units as AST files in the cache and\n"
+        "load them instead of parsing an input file again if none of its\n"
+        "input files changed.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> AllFiles(
+    "all-files",
+    llvm::cl::desc(
+        "Process all files of the compilation database. Use \"--include\"\n"
+        "and \"--exclude\" to select a subset of the files.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<Config::ArgumentProfile> ArgumentProfile(
+    "args-profile",
+    llvm::cl::desc(
+        "Select a set of rules removing command-line arguments from the\n"
+        "invocation of the internally used clang compiler.\n"
+    ),
+    llvm::cl::values(
+        clEnumValN(
+            Config::ARGUMENTPROFILE_NONE,
+            "none",
+            "Keep all arguments (default)."
+        ),
+        clEnumValN(
+            Config::ARGUMENTPROFILE_SYNTAX_ONLY,
+            "syntax-only",
+            "Remove arguments which do not matter for parsing."
+        )
+    ),
+    llvm::cl::value_desc("profile"),
+    llvm::cl::init(Config::ARGUMENTPROFILE_NONE),
+    llvm::cl::ValueRequired,
     llvm::cl::cat(ToolCategory)
 );
 
@@ -111,6 +162,86 @@ static llvm::cl::opt<Config::Backend> Backend(
     llvm::cl::cat(ToolCategory)
 );
 
+static llvm::cl::opt<bool> Cache(
+    "cache",
+    llvm::cl::desc(
+        "Store generated outputs in a persistent cache and reuse them if\n"
+        "the preprocessed input file and the configuration did not\n"
+        "change. Reused outputs do not require parsing the input file.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> CacheDirectory(
+    "cache-dir",
+    llvm::cl::desc(
+        "Use directory <directory> for the cache enabled by \"--cache\".\n"
+        "Defaults to \"$XDG_CACHE_HOME/ccmock\" or \"~/.cache/ccmock\".\n"
+    ),
+    llvm::cl::value_desc("directory"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<Config::CacheKey> CacheKey(
+    "cache-key",
+    llvm::cl::desc(
+        "Select how the cache determines whether an input file changed.\n"
+    ),
+    llvm::cl::values(
+        clEnumValN(
+            Config::CACHEKEY_SCAN,
+            "scan",
+            "Hash all files found by a fast dependency scan (default)."
+        ),
+        clEnumValN(
+            Config::CACHEKEY_PREPROCESS,
+            "preprocess",
+            "Hash the tokens of the fully preprocessed input file."
+        )
+    ),
+    llvm::cl::value_desc("mode"),
+    llvm::cl::init(Config::CACHEKEY_SCAN),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> CacheSize(
+    "cache-size",
+    llvm::cl::desc(
+        "Limit the size of the cache to <size> bytes by removing the least\n"
+        "recently used outputs. The size accepts the suffixes K, M, G and\n"
+        "T. Defaults to \"1G\".\n"
+    ),
+    llvm::cl::value_desc("size"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> CacheStats(
+    "cache-stats",
+    llvm::cl::desc(
+        "Print the number of cache hits and misses after processing all\n"
+        "input files.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> ClientSocket(
+    "client",
+    llvm::cl::desc(
+        "Forward the invocation to the ccmock server listening on socket\n"
+        "<socket>. All other arguments are passed to the server unchanged.\n"
+        "The invocation is processed locally if the server is not\n"
+        "reachable.\n"
+    ),
+    llvm::cl::value_desc("socket"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::opt<std::string> CompileCommands(
     "compile-commands",
     llvm::cl::desc(
@@ -159,6 +290,16 @@ static llvm::cl::opt<bool> DumpConfig(
     llvm::cl::cat(ToolCategory)
 );
 
+static llvm::cl::opt<bool> ExplainArguments(
+    "explain-args",
+    llvm::cl::desc(
+        "Print the command-line arguments removed from the compile\n"
+        "command of each input file by the selected argument profile.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::list<std::string> ExtraArguments(
     "extra-args",
     llvm::cl::desc(
@@ -171,6 +312,39 @@ static llvm::cl::list<std::string> ExtraArguments(
     llvm::cl::cat(ToolCategory)
 );
 
+static llvm::cl::list<std::string> Exclude(
+    "exclude",
+    llvm::cl::desc(
+        "Do not process files of the compilation database with a path\n"
+        "matching <pattern>. Paths are relative to the base directory.\n"
+        "Only used together with \"--all-files\".\n"
+    ),
+    llvm::cl::value_desc("pattern"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> FastHeaders(
+    "fast-headers",
+    llvm::cl::desc(
+        "Skip the bodies of all functions defined outside of the input\n"
+        "file while parsing. Functions defined in headers are still\n"
+        "considered to be defined.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> FileCache(
+    "file-cache",
+    llvm::cl::desc(
+        "Cache the status and the contents of all files read while\n"
+        "processing the input files in memory. Enabled by default.\n"
+    ),
+    llvm::cl::init(true),
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::opt<bool> Force(
     "force",
     llvm::cl::desc(
@@ -187,6 +361,106 @@ static llvm::cl::alias ForceAlias(
     llvm::cl::NotHidden
 );
 
+static llvm::cl::opt<std::string> HistoryFile(
+    "history",
+    llvm::cl::desc(
+        "Read and update the processing times of all files in <file>.\n"
+        "Defaults to \".ccmock-history.json\" within the output directory.\n"
+        "If specified, \"--shard\" balances the shards by the recorded\n"
+        "times instead of by file size.\n"
+    ),
+    llvm::cl::value_desc("file"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> Incremental(
+    "incremental",
+    llvm::cl::desc(
+        "Record the status of all files an output depends on next to the\n"
+        "output. Exit immediately if none of these files changed since\n"
+        "the outputs were generated.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::list<std::string> Include(
+    "include",
+    llvm::cl::desc(
+        "Only process files of the compilation database with a path\n"
+        "matching <pattern>. Paths are relative to the base directory.\n"
+        "Only used together with \"--all-files\".\n"
+    ),
+    llvm::cl::value_desc("pattern"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> Manifest(
+    "manifest",
+    llvm::cl::desc(
+        "Read additional jobs from the JSON job manifest <file>. Each job\n"
+        "specifies an \"input\" file and optionally an \"output\" file\n"
+        "and a \"backend\". All jobs are processed by the same ccmock\n"
+        "process.\n"
+    ),
+    llvm::cl::value_desc("file"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<unsigned int> Jobs(
+    "jobs",
+    llvm::cl::desc(
+        "Process up to <N> input files in parallel. A value of 0 uses\n"
+        "one thread per available hardware thread.\n"
+    ),
+    llvm::cl::value_desc("N"),
+    llvm::cl::init(1),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::alias JobsAlias(
+    "j",
+    llvm::cl::desc("Same as --jobs"),
+    llvm::cl::aliasopt(Jobs),
+    llvm::cl::NotHidden
+);
+
+static llvm::cl::opt<bool> WriteDependencyFile(
+    "MD",
+    llvm::cl::desc(
+        "Write a Makefile depfile listing all files an output depends on\n"
+        "to \"<output>.d\". Jobs without an output file are ignored.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> DependencyFile(
+    "MF",
+    llvm::cl::desc(
+        "Write the depfile to <file> instead of \"<output>.d\". Implies\n"
+        "\"-MD\" and requires exactly one input and output file.\n"
+    ),
+    llvm::cl::value_desc("file"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> MemoryBudget(
+    "memory-budget",
+    llvm::cl::desc(
+        "Only process files in parallel as long as their expected memory\n"
+        "usage fits into <size> bytes. The size accepts the suffixes K, M,\n"
+        "G and T, e.g. \"12G\".\n"
+    ),
+    llvm::cl::value_desc("size"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::opt<bool> Verbose(
     "verbose",
     llvm::cl::desc(
@@ -203,6 +477,41 @@ static llvm::cl::alias VerboseAlias(
     llvm::cl::aliasopt(Verbose)
 );
 
+static llvm::cl::opt<std::string> ServerSocket(
+    "serve",
+    llvm::cl::desc(
+        "Run as a server listening on socket <socket> for invocations\n"
+        "forwarded by \"--client\". The server keeps the compilation\n"
+        "database loaded and reloads it if its file changes.\n"
+    ),
+    llvm::cl::value_desc("socket"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> Watch(
+    "watch",
+    llvm::cl::desc(
+        "Keep running after processing all input files and regenerate\n"
+        "the output of every input file as soon as the file itself or\n"
+        "any of its included files changes.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<std::string> Shard(
+    "shard",
+    llvm::cl::desc(
+        "Only process shard <I> of <N> shards of all jobs with 1 <= I <= N.\n"
+        "All shards together process every job exactly once. A manifest\n"
+        "of the processed jobs is written to the output directory.\n"
+    ),
+    llvm::cl::value_desc("I/N"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::opt<bool> Strict(
     "strict",
     llvm::cl::desc("Treat warnings as errors."),
@@ -238,6 +547,29 @@ static llvm::cl::opt<std::string> Output(
     llvm::cl::cat(ToolCategory)
 );
 
+static llvm::cl::opt<std::string> OutputDirectory(
+    "output-dir",
+    llvm::cl::desc(
+        "Write the output of all jobs without an explicit output file\n"
+        "to directory <directory>. The directory layout mirrors the\n"
+        "layout of the input files relative to the base directory.\n"
+    ),
+    llvm::cl::value_desc("directory"),
+    llvm::cl::ValueRequired,
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> PCH(
+    "pch",
+    llvm::cl::desc(
+        "Precompile the headers included first by all input files\n"
+        "compiled with the same flags. Precompiled headers are kept\n"
+        "in the cache directory.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::list<std::string> RemoveArguments(
     "remove-args",
     llvm::cl::desc(
@@ -251,6 +583,27 @@ static llvm::cl::list<std::string> RemoveArguments(
     llvm::cl::cat(ToolCategory)
 );
 
+static llvm::cl::opt<bool> Reproducible(
+    "reproducible",
+    llvm::cl::desc(
+        "Generate the same output on every machine and for every run.\n"
+        "Omits the date and the base directory from the file header and\n"
+        "sorts all mocks by name.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
+static llvm::cl::opt<bool> RevalidateFileCache(
+    "revalidate-file-cache",
+    llvm::cl::desc(
+        "Check the modification time of cached files on each access and\n"
+        "read modified files again.\n"
+    ),
+    llvm::cl::init(false),
+    llvm::cl::cat(ToolCategory)
+);
+
 static llvm::cl::opt<std::string> ResourceDirectory(
     "resource-directory",
     llvm::cl::desc(
@@ -328,6 +681,151 @@ private:
     llvm::StringMap<int> RemoveArgs_;
 };
 
+static uint64_t parseMemorySize(llvm::StringRef Value)
+{
+    auto Number = Value.rtrim("KMGT");
+    auto Suffix = Value.drop_front(Number.size());
+    uint64_t Size;
+
+    auto Shift = llvm::StringSwitch<int>(Suffix)
+                     .Case("", 0)
+                     .Case("K", 10)
+                     .Case("M", 20)
+                     .Case("G", 30)
+                     .Case("T", 40)
+                     .Default(-1);
+
+    if (Number.getAsInteger(10, Size) || Shift < 0
+        || Size > (UINT64_MAX >> Shift)) {
+        llvm::errs() << util::cl::error() << "invalid memory size \"" << Value
+                     << "\"\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    return Size << Shift;
+}
+
+static std::pair<unsigned int, unsigned int> parseShard(llvm::StringRef Value)
+{
+    unsigned int Index, Count;
+
+    auto [First, Second] = Value.split('/');
+
+    if (First.getAsInteger(10, Index) || Second.getAsInteger(10, Count)
+        || Count == 0 || Index == 0 || Index > Count) {
+        llvm::errs() << util::cl::error() << "invalid shard \"" << Value
+                     << "\", expected \"I/N\" with 1 <= I <= N\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    /* Shards are numbered starting from 1 on the command-line */
+    return {Index - 1, Count};
+}
+
+/* NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays) */
+static std::vector<const char *> makeClientArguments(int argc,
+                                                     const char *argv[])
+{
+    auto Args = std::vector<const char *>();
+    Args.reserve(argc);
+
+    /* Forward all arguments except the ones selecting the server */
+    for (int i = 0; i < argc; ++i) {
+        auto Arg = llvm::StringRef(argv[i]);
+
+        if (Arg.consume_front("--client") || Arg.consume_front("-client")) {
+            if (Arg.empty()) {
+                ++i;
+                continue;
+            }
+
+            if (Arg.startswith("="))
+                continue;
+        }
+
+        Args.push_back(argv[i]);
+    }
+
+    return Args;
+}
+
+static std::vector<std::string> makeCommonDependencies(const Config &Config,
+                                                       const Batch &Batch)
+{
+    auto Files = std::vector<std::string>();
+    std::error_code Code;
+
+    /*
+     * Every output depends on the configuration files and the compilation
+     * database. The database is searched for exactly like below, but
+     * without loading it.
+     */
+    auto Add = [&](const std::filesystem::path &Path) {
+        auto File = std::filesystem::absolute(Path, Code);
+        if (!Code)
+            Files.push_back(File.lexically_normal().native());
+    };
+
+    for (const auto &File : ConfigFile)
+        Add(File);
+
+    if (llvm::StringRef File = ::getenv("CCMOCK_CONFIG"); !File.empty())
+        Add(File.str());
+
+    auto Database = Config.Clang.CompileCommands;
+
+    if (Database.empty() && !Batch.empty()) {
+        auto Path = std::filesystem::absolute(Batch.getJobs().front().Input);
+        Database = CompilationDatabase::locate(Path);
+    } else if (Database.empty()) {
+        Database = CompilationDatabase::locate(Config.General.BaseDirectory);
+    }
+
+    if (!Database.empty())
+        Add(Database);
+
+    return Files;
+}
+
+static void explainArguments(const ArgumentRewriter &Rewriter,
+                             const CompilationDatabase &Commands,
+                             const Batch &Batch)
+{
+    /*
+     * Example:
+     *      info: "/src/a.c": removed "-g3" (rule "-g[0-3]")
+     *      info: "/src/a.c": removed "-Xlinker -z" (rule "-Xlinker")
+     */
+    for (const auto &Job : Batch.getJobs()) {
+        const auto &Input = Job.Input.native();
+        auto Removals = std::vector<ArgumentRewriter::Removal>();
+
+        for (const auto &Command : Commands.getCompileCommands(Input))
+            (void) Rewriter.rewrite(Command.CommandLine, &Removals);
+
+        for (const auto &Item : Removals) {
+            llvm::errs() << util::cl::info() << "\"" << Input
+                         << "\": removed \"" << llvm::join(Item.Arguments, " ")
+                         << "\" (rule \"" << Item.Rule << "\")\n";
+        }
+    }
+}
+
+static void preloadCompilationDatabase(const Config &Config)
+{
+    auto Commands = CompilationDatabase();
+    std::string Message;
+
+    /*
+     * Loaded compilation databases are cached for the lifetime of the
+     * process. Loading it again only parses the file if it was modified.
+     */
+    if (!Config.Clang.CompileCommands.empty())
+        Commands.load(Config.Clang.CompileCommands, Message);
+    else
+        Commands.detect(Config.General.BaseDirectory, Message);
+}
+
 /* NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays) */
 __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
 {
@@ -363,6 +861,22 @@ __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
         std::exit(EXIT_SUCCESS);
     }
 
+    /*
+     * The server parses the forwarded command-line on its own, so there
+     * is nothing left to do here if the server is reachable.
+     */
+    if (!ClientSocket.empty()) {
+        auto Client = ::Client(ClientSocket.getValue());
+
+        Client.connect(Message);
+        if (Message.empty())
+            return Client.run(makeClientArguments(argc, argv));
+
+        llvm::errs() << util::cl::warning() << Message
+                     << ", processing locally\n";
+        Message.clear();
+    }
+
     /*
      * Read in and merge all configuration files.
      * Precedence order is from highest to lowest:
@@ -379,6 +893,9 @@ __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
     if (llvm::StringRef File = ::getenv("CCMOCK_CONFIG"); !File.empty())
         Config->read(File);
 
+    if (ArgumentProfile.getNumOccurrences() != 0)
+        Config->Clang.ArgumentProfile = ArgumentProfile;
+
     if (!ExtraArguments.empty())
         Config->Clang.ExtraArguments = std::move(ExtraArguments);
 
@@ -391,6 +908,12 @@ __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
     if (!BaseDirectory.empty())
         Config->General.BaseDirectory = std::move(BaseDirectory);
 
+    if (!HistoryFile.empty())
+        Config->General.HistoryFile = std::move(HistoryFile);
+
+    if (!CacheDirectory.empty())
+        Config->General.CacheDirectory = std::move(CacheDirectory);
+
     if (Backend.getNumOccurrences() != 0)
         Config->Mocking.Backend = Backend;
 
@@ -403,18 +926,78 @@ __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
     if (CompileCommands.getNumOccurrences() != 0)
         Config->Clang.CompileCommands = std::move(CompileCommands);
 
+    if (Jobs.getNumOccurrences() != 0)
+        Config->General.Jobs = Jobs;
+
+    if (!MemoryBudget.empty())
+        Config->General.MemoryBudget = parseMemorySize(MemoryBudget);
+
+    if (ASTCache.getNumOccurrences() != 0)
+        Config->General.ASTCache = ASTCache;
+
+    if (Cache.getNumOccurrences() != 0)
+        Config->General.Cache = Cache;
+
+    if (CacheKey.getNumOccurrences() != 0)
+        Config->General.CacheKey = CacheKey;
+
+    if (!CacheSize.empty())
+        Config->General.CacheSize = parseMemorySize(CacheSize);
+
+    if (CacheStats.getNumOccurrences() != 0)
+        Config->General.CacheStats = CacheStats;
+
+    if (FastHeaders.getNumOccurrences() != 0)
+        Config->General.FastHeaders = FastHeaders;
+
+    if (FileCache.getNumOccurrences() != 0)
+        Config->General.FileCache = FileCache;
+
+    if (Incremental.getNumOccurrences() != 0)
+        Config->General.Incremental = Incremental;
+
+    if (PCH.getNumOccurrences() != 0)
+        Config->General.PCH = PCH;
+
+    if (Reproducible.getNumOccurrences() != 0)
+        Config->General.Reproducible = Reproducible;
+
+    if (RevalidateFileCache.getNumOccurrences() != 0)
+        Config->General.RevalidateFileCache = RevalidateFileCache;
+
     if (Verbose.getNumOccurrences() != 0)
         Config->General.Verbose = Verbose;
 
+    if (Watch.getNumOccurrences() != 0)
+        Config->General.Watch = Watch;
+
+    if (WriteDependencyFile.getNumOccurrences() != 0)
+        Config->General.WriteDependencyFile = WriteDependencyFile;
+
     if (Quiet.getNumOccurrences() != 0)
         Config->General.Quiet = Quiet;
 
-    if (!Input.empty())
-        Config->General.Input = std::move(Input);
+    if (Inputs.size() == 1)
+        Config->General.Input = Inputs.front();
 
     if (!Output.empty())
         Config->General.Output = std::move(Output);
 
+    if (!OutputDirectory.empty())
+        Config->General.OutputDirectory = std::move(OutputDirectory);
+
+    if (!DependencyFile.empty())
+        Config->General.DependencyFile = std::move(DependencyFile);
+
+    if (AllFiles.getNumOccurrences() != 0)
+        Config->General.AllFiles = AllFiles;
+
+    if (!Include.empty())
+        Config->General.Include = std::move(Include);
+
+    if (!Exclude.empty())
+        Config->General.Exclude = std::move(Exclude);
+
     /*
      * Dump the config now before adjusting it for program internal reasons
      * so the users can see their effective configuration settings.
@@ -441,6 +1024,10 @@ __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
         Path = std::filesystem::absolute(Path);
     }
 
+    auto &DepFile = Config->General.DependencyFile;
+    if (!DepFile.empty() && DepFile.is_relative())
+        DepFile = std::filesystem::absolute(DepFile);
+
     /* Enable or disable colored output */
     switch (Config->General.ColorMode) {
     case Config::COLORMODE_AUTO:
@@ -455,46 +1042,219 @@ __attribute__((used)) static int ccmock_main(int argc, const char *argv[])
         break;
     }
 
-    /* Prepare inputs for the invocation of the ClangTool */
+    /*
+     * Initialize everything which does not depend on a specific request
+     * once and let the server fork a child process for each request.
+     * Each child reads the configuration files specified by its request
+     * again, so changes to them are always picked up.
+     */
+    if (!ServerSocket.empty()) {
+        auto Server = ::Server(ServerSocket.getValue());
+        auto Refresh = [&Config]() { preloadCompilationDatabase(*Config); };
+
+        MockActionFactory::preload();
+        Refresh();
+
+        return Server.run(ccmock_main, Refresh);
+    }
+
+    /*
+     * Collect all jobs of this invocation. A single input file given by
+     * the command-line or the configuration is just a batch with exactly
+     * one job.
+     */
+    auto Batch = ::Batch();
+
+    if (!Manifest.empty()) {
+        Batch.load(Manifest.getValue(), Message);
+        if (!Message.empty()) {
+            llvm::errs() << util::cl::error() << Message << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    if (Inputs.size() > 1) {
+        for (const auto &Item : Inputs)
+            Batch.add({Item, std::filesystem::path(), std::nullopt});
+    } else if (!Config->General.Input.empty()) {
+        auto Output = Config->General.Output;
+        Batch.add({Config->General.Input, std::move(Output), std::nullopt});
+    }
+
+    /*
+     * Prepare inputs for the invocation of the ClangTool. The compilation
+     * database is loaded once and shared by all jobs.
+     */
     auto Commands = CompilationDatabase();
     Commands.setIndex(Config->Clang.CompileCommandIndex);
 
-    if (!Config->Clang.CompileCommands.empty())
+    auto Runner = ::Runner(Config, Commands);
+
+    /* Manifests and depfiles record the files all outputs depend on */
+    if (Config->General.Incremental || Config->General.WriteDependencyFile
+        || !Config->General.DependencyFile.empty()) {
+        Runner.setCommonDependencies(makeCommonDependencies(*Config, Batch));
+    }
+
+    /*
+     * Without "--all-files" all jobs are known at this point. If all of
+     * their outputs are up to date there is nothing to do, not even
+     * loading the compilation database.
+     */
+    if (Config->General.Incremental) {
+        if (!Config->General.AllFiles && !Config->General.Watch
+            && !Batch.empty()) {
+            auto Jobs = Batch;
+
+            Jobs.resolve(*Config, Message);
+            if (Message.empty() && Runner.isUpToDate(Jobs)) {
+                if (Config->General.Verbose) {
+                    llvm::errs() << util::cl::info()
+                                 << "all outputs are up to date\n";
+                }
+
+                return EXIT_SUCCESS;
+            }
+
+            Message.clear();
+        }
+    }
+
+    if (!Config->Clang.CompileCommands.empty()) {
         Commands.load(Config->Clang.CompileCommands, Message);
-    else
-        Commands.detect(Config->General.Input, Message);
+    } else if (!Batch.empty()) {
+        auto Path = std::filesystem::absolute(Batch.getJobs().front().Input);
+        Commands.detect(Path, Message);
+    } else {
+        Commands.detect(Config->General.BaseDirectory, Message);
+    }
 
     if (!Commands) {
         llvm::errs() << util::cl::error() << Message << "\n";
         std::exit(EXIT_FAILURE);
     }
 
-    if (Config->General.Input.empty()) {
+    if (Config->General.AllFiles) {
+        /* Drop messages about a failed detection with a working fallback */
+        Message.clear();
+
+        Batch.select(Commands.getAllFiles(), *Config, Message);
+        if (!Message.empty()) {
+            llvm::errs() << util::cl::error() << Message << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    if (Batch.empty()) {
         llvm::errs() << util::cl::error()
                      << "no input source file specified.\n";
         std::exit(EXIT_FAILURE);
     }
 
-    auto Factory = MockActionFactory();
-    Factory.setConfig(Config);
+    if (Batch.size() > 1 && !Config->General.Output.empty()) {
+        llvm::errs() << util::cl::error() << "option \"-o\" requires "
+                     << "exactly one input file, use \"--output-dir\" "
+                     << "instead.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (!Config->General.DependencyFile.empty()) {
+        auto Jobs = Batch.getJobs();
+
+        if (Jobs.size() > 1) {
+            llvm::errs() << util::cl::error() << "option \"-MF\" requires "
+                         << "exactly one input file, use \"-MD\" "
+                         << "instead.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        if (Jobs.front().Output.empty()
+            && Config->General.OutputDirectory.empty()) {
+            llvm::errs() << util::cl::error() << "option \"-MF\" requires "
+                         << "an output file.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    Batch.resolve(*Config, Message);
+    if (!Message.empty()) {
+        llvm::errs() << util::cl::error() << Message << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    /*
+     * The profile applies to the compile commands as they are found in
+     * the compilation database, so it never removes any extra arguments.
+     */
+    if (Config->Clang.ArgumentProfile == Config::ARGUMENTPROFILE_SYNTAX_ONLY) {
+        const auto &Profile = ArgumentRewriter::getSyntaxOnlyProfile();
+
+        Runner.appendArgumentsAdjuster(
+            [&Profile](const clang::tooling::CommandLineArguments &Args,
+                       llvm::StringRef File) {
+                (void) File;
 
-    /* Perform the ClangTool invocation */
-    const auto &Input = Config->General.Input.native();
-    auto Tool = clang::tooling::ClangTool(Commands, Input);
+                return Profile.rewrite(Args);
+            });
 
-    auto &ExtraArgs = Config->Clang.ExtraArguments;
+        if (ExplainArguments)
+            explainArguments(Profile, Commands, Batch);
+    }
+
+    /*
+     * The runner shares the configuration, so keep the arguments in there.
+     * They are part of the keys of the manifests.
+     */
+    auto ExtraArgs = Config->Clang.ExtraArguments;
     if (!ExtraArgs.empty()) {
         auto Adjuster = ExtraArgumentsAdjuster(std::move(ExtraArgs));
-        Tool.appendArgumentsAdjuster(std::move(Adjuster));
+        Runner.appendArgumentsAdjuster(std::move(Adjuster));
     }
 
-    auto &RemoveArgs = Config->Clang.RemoveArguments;
+    auto RemoveArgs = Config->Clang.RemoveArguments;
     if (!RemoveArgs.empty()) {
         auto Adjuster = RemoveArgumentsAdjuster(std::move(RemoveArgs));
-        Tool.appendArgumentsAdjuster(std::move(Adjuster));
+        Runner.appendArgumentsAdjuster(std::move(Adjuster));
     }
 
-    return Tool.run(&Factory);
+    /*
+     * Remember the processing times of all files next to the generated
+     * output files. Subsequent runs use them to schedule the jobs.
+     */
+    const auto &OutputDir = Config->General.OutputDirectory;
+
+    if (!Config->General.HistoryFile.empty())
+        Runner.setHistoryFile(Config->General.HistoryFile);
+
+    if (!Shard.empty()) {
+        auto [Index, Count] = parseShard(Shard);
+
+        /*
+         * All shards must compute the same partition. A history only
+         * written by a single shard would result in different partitions,
+         * so only an explicitly specified history file is used here.
+         */
+        Batch.shard(Index, Count, Runner.estimate(Batch));
+
+        if (!OutputDir.empty()) {
+            auto Name = ".ccmock-shard-" + std::to_string(Index + 1) + "-of-"
+                + std::to_string(Count) + ".json";
+
+            Batch.save(OutputDir / Name, *Config, Message);
+            if (!Message.empty()) {
+                llvm::errs() << util::cl::error() << Message << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (Config->General.HistoryFile.empty() && !OutputDir.empty())
+        Runner.setHistoryFile(OutputDir / ".ccmock-history.json");
+
+    if (Config->General.Watch)
+        return Runner.watch(Batch);
+
+    return Runner.run(Batch);
 }
 
 #ifndef UNIT_TESTS_ENABLED
@@ -17,9 +17,8 @@
 
 #include "CMocka.hpp"
 
-CMocka::CMocka(std::shared_ptr<const Config> Config,
-               clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "cmocka")
+CMocka::CMocka(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "cmocka")
 {
 }
 
@@ -46,39 +45,27 @@ void CMocka::writeMockFunctions()
 {
     auto &Writer = getWriter();
 
-    for (const auto *Decl : getFunctionDecls()) {
-        if (Decl->isExternC())
+    for (const auto *Function : getFunctions()) {
+        if (Function->IsExternC)
             Writer.write("CCMOCK_LINKAGE ");
 
-        Writer.writeReturnType(Decl);
+        Writer.writeReturnType(*Function);
         Writer.write("\n");
-        Writer.writeFullyQualifiedName(Decl);
-        Writer.writeFunctionParameterList(Decl);
+        Writer.writeFullyQualifiedName(*Function);
+        Writer.writeFunctionParameterList(*Function);
         Writer.write("\n");
-        writeFunctionBody(Decl);
+        writeFunctionBody(Function);
         Writer.write("\n");
     }
 }
 
-void CMocka::writeFunctionBody(const clang::FunctionDecl *Decl)
+void CMocka::writeFunctionBody(const MockModel::Function *Function)
 {
-    auto Parameters = Decl->parameters();
+    const auto &Parameters = Function->Parameters;
     auto &Writer = getWriter();
 
-    auto IsOutParam = [](const clang::ParmVarDecl *Decl) {
-        auto Type = Decl->getType();
-        auto Pointee = Type->getPointeeType();
-
-        if (Pointee.isNull() || Pointee->isVoidType())
-            return false;
-
-        if (Pointee->isFunctionType())
-            return false;
-
-        if (Pointee.isConstQualified())
-            return false;
-
-        return true;
+    auto IsOutParam = [](const MockModel::Parameter &Parameter) {
+        return Parameter.IsOutput;
     };
 
     Writer.write("{\n");
@@ -94,19 +81,13 @@ void CMocka::writeFunctionBody(const clang::FunctionDecl *Decl)
     if (!Parameters.empty()) {
         Writer.write("\n");
 
-        for (unsigned int i = 0, N = Parameters.size(); i < N; ++i) {
-            if (Parameters[i]->getType()->isPointerType())
+        for (const auto &Parameter : Parameters) {
+            if (Parameter.IsPointer)
                 Writer.write("    check_expected_ptr(");
             else
                 Writer.write("    check_expected(");
 
-            if (!Parameters[i]->getName().empty()) {
-                Writer.write(Parameters[i]->getName());
-            } else {
-                Writer.write("arg");
-                Writer.write(i + 1);
-            }
-
+            Writer.write(Parameter.Name);
             Writer.write(");\n");
         }
     }
@@ -115,50 +96,33 @@ void CMocka::writeFunctionBody(const clang::FunctionDecl *Decl)
         Writer.write("\n");
 
         /* Treat non-const pointer as output parameters */
-        for (unsigned int i = 0, N = Parameters.size(); i < N; ++i) {
-            auto Type = Parameters[i]->getType();
-
-            if (!IsOutParam(Parameters[i]))
+        for (const auto &Parameter : Parameters) {
+            if (!IsOutParam(Parameter))
                 continue;
 
             Writer.write("    mock_ptr = mock_ptr_type(");
-            Writer.writeType(Type);
+            Writer.writeType(Parameter.Type);
             Writer.write(");\n"
                          "    if (mock_ptr)\n"
                          "        memmove(");
-
-            if (!Parameters[i]->getName().empty()) {
-                Writer.write(Parameters[i]->getName());
-            } else {
-                Writer.write("arg");
-                Writer.write(i + 1);
-            }
-
+            Writer.write(Parameter.Name);
             Writer.write(", mock_ptr, sizeof(*");
-
-            if (!Parameters[i]->getName().empty()) {
-                Writer.write(Parameters[i]->getName());
-            } else {
-                Writer.write("arg");
-                Writer.write(i + 1);
-            }
-
+            Writer.write(Parameter.Name);
             Writer.write("));\n"
                          "\n");
         }
     }
 
-    auto Type = Decl->getReturnType();
-    if (!Type->isVoidType()) {
+    if (!Function->ReturnsVoid) {
         Writer.write("\n"
                      "    return ");
 
-        if (Type->isPointerType())
+        if (Function->ReturnsPointer)
             Writer.write("mock_ptr_type(");
         else
             Writer.write("mock_type(");
 
-        Writer.writeType(Type);
+        Writer.writeReturnType(*Function);
         Writer.write(");\n");
     }
 
@@ -22,7 +22,7 @@
 
 class CMocka : public OutputGenerator {
 public:
-    CMocka(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy);
+    explicit CMocka(std::shared_ptr<const Config> Config);
 
     void run() override;
 
@@ -30,7 +30,7 @@ private:
     void writeIncludeDirectives();
     void writeMockFunctions();
 
-    void writeFunctionBody(const clang::FunctionDecl *Decl);
+    void writeFunctionBody(const MockModel::Function *Function);
     const Config::CMockaSection &getConfig() const;
 };
 
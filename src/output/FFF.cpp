@@ -17,19 +17,18 @@
 
 #include "FFF.hpp"
 
-#include "util/Decl.hpp"
-#include "util/commandline.hpp"
 
-static void
-createTypedefName(std::string &Name, const clang::NamedDecl *Decl, size_t index)
+static void createTypedefName(std::string &Name,
+                              const MockModel::Function *Function,
+                              size_t index)
 {
     llvm::raw_string_ostream OS(Name);
 
-    OS << *Decl << "_fn" << index + 1 << "_t";
+    OS << Function->Name << "_fn" << index + 1 << "_t";
 }
 
-FFF::FFF(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "fff")
+FFF::FFF(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "fff")
 {
 }
 
@@ -83,9 +82,9 @@ void FFF::writeMacros()
 
     getWriter().write(Data);
 
-    for (const auto *Decl : getFunctionDecls()) {
+    for (const auto *Function : getFunctions()) {
         getWriter().write("    FAKE(");
-        getWriter().write(Decl->getName());
+        getWriter().write(Function->Name);
         getWriter().write(") \\\n");
     }
 
@@ -95,22 +94,21 @@ void FFF::writeMacros()
 void FFF::writeTypedefs()
 {
     auto &Writer = getWriter();
-    std::string Name;
+    std::string Key, Name;
 
-    for (const auto *Decl : getFunctionDecls()) {
-        auto Parameters = Decl->parameters();
+    for (const auto *Function : getFunctions()) {
+        const auto &Parameters = Function->Parameters;
 
         for (size_t i = 0, Size = Parameters.size(); i < Size; ++i) {
-            auto Type = Parameters[i]->getType();
+            const auto &Declarator = Parameters[i].Declarator;
 
-            auto Pointee = Type->getPointeeType();
-            if (Pointee.isNull() || !Pointee->isFunctionType())
+            if (!Parameters[i].IsFunctionPointer || Parameters[i].IsTypedef)
                 continue;
 
-            if (Type->isTypedefNameType())
-                continue;
+            Key = Declarator.Head;
+            Key += Declarator.Tail;
 
-            if (TypedefMap_.count(Type.getTypePtr()))
+            if (TypedefMap_.count(Key))
                 continue;
 
             /*
@@ -118,22 +116,13 @@ void FFF::writeTypedefs()
              * the mocks with FFF macros.
              */
             Name.clear();
-            createTypedefName(Name, Decl, i);
-
-            auto &Context = Decl->getASTContext();
-            auto *VarDecl = util::decl::fakeVarDecl(Context, Type, Name);
+            createTypedefName(Name, Function, i);
 
             Writer.write("typedef ");
-            Writer.writeVarDecl(VarDecl);
+            Writer.writeDeclarator(Declarator, Name);
             Writer.write(";\n");
 
-            auto [_, Ok] = TypedefMap_.insert({Type.getTypePtr(), VarDecl});
-            if (!Ok) {
-                /* FIXME: use diagnostic engine */
-                llvm::errs() << util::cl::error()
-                             << "failed to store new typedef information\n";
-                std::exit(EXIT_FAILURE);
-            }
+            TypedefMap_.try_emplace(Key, std::move(Name));
         }
     }
 
@@ -148,14 +137,13 @@ void FFF::writeMocks()
                  "extern \"C\" {\n"
                  "#endif\n\n");
 
-    for (const auto *Decl : getFunctionDecls()) {
+    for (const auto *Function : getFunctions()) {
         llvm::StringRef Suffix;
 
-        if (Decl->isVariadic())
+        if (Function->IsVariadic)
             Suffix = "_VARARG";
 
-        auto Type = Decl->getReturnType();
-        if (Type->isVoidType()) {
+        if (Function->ReturnsVoid) {
             Writer.write("FAKE_VOID_FUNC");
             Writer.write(Suffix);
             Writer.write("(");
@@ -163,7 +151,7 @@ void FFF::writeMocks()
             Writer.write("FAKE_VALUE_FUNC");
             Writer.write(Suffix);
             Writer.write("(");
-            Writer.writeType(Type);
+            Writer.writeReturnType(*Function);
             Writer.write(", ");
         }
 
@@ -172,32 +160,31 @@ void FFF::writeMocks()
             Writer.write(", ");
         }
 
-        Writer.write(Decl->getName());
+        Writer.write(Function->Name);
+
+        for (const auto &Parameter : Function->Parameters) {
+            Writer.write(", ");
 
-        auto Parameters = Decl->parameters();
-        if (!Parameters.empty()) {
-            for (const auto *ParmVarDecl : Parameters) {
-                Writer.write(", ");
+            if (Parameter.IsFunctionPointer && !Parameter.IsTypedef) {
+                const auto &Declarator = Parameter.Declarator;
 
-                auto Type = ParmVarDecl->getType();
-                auto It = TypedefMap_.find(Type.getTypePtr());
+                auto It = TypedefMap_.find(Declarator.Head + Declarator.Tail);
                 if (It != TypedefMap_.end()) {
-                    Writer.write(It->second->getName());
+                    Writer.write(It->second);
                     continue;
                 }
-
-                /*
-                 * FFF's mocking macros create structs containing variables
-                 * which get derived from function parameters.
-                 * These structs therefore do not work well with const
-                 * types, so we have to remove potential consts here.
-                 */
-                Type.removeLocalConst();
-                Writer.writeType(Type);
             }
+
+            /*
+             * FFF's mocking macros create structs containing variables
+             * which get derived from function parameters.
+             * These structs therefore do not work well with const
+             * types, so the model does not keep them for parameters.
+             */
+            Writer.writeType(Parameter.Type);
         }
 
-        if (Decl->isVariadic())
+        if (Function->IsVariadic)
             Writer.write(", ...");
 
         Writer.write(");\n");
@@ -18,11 +18,13 @@
 #ifndef FFF_HPP_
 #define FFF_HPP_
 
+#include <llvm/ADT/StringMap.h>
+
 #include "OutputGenerator.hpp"
 
 class FFF : public OutputGenerator {
 public:
-    FFF(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy);
+    explicit FFF(std::shared_ptr<const Config> Config);
 
     void run() override;
 
@@ -35,7 +37,8 @@ private:
 
     const Config::FFFSection &getConfig() const;
 
-    llvm::DenseMap<const clang::Type *, const clang::VarDecl *> TypedefMap_;
+    /* Maps the spelling of function pointer types to their typedef names */
+    llvm::StringMap<std::string> TypedefMap_;
 };
 
 #endif /* FFF_HPP_ */
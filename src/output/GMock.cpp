@@ -16,35 +16,28 @@
  */
 
 #include "GMock.hpp"
-#include "util/Decl.hpp"
-
-#include <clang/AST/ASTContext.h>
-#include <clang/AST/DeclLookups.h>
 
 namespace {
 
-inline bool requiresPointerVariable(
-    const clang::DeclContext *Context,
-    const llvm::DenseSet<const clang::DeclContext *> &Children)
+inline bool hasReturnType(const MockModel::Function *Function)
 {
-    if (!util::decl::isGlobalContext(Context))
+    switch (Function->Kind) {
+    case MockModel::Function::KIND_CONSTRUCTOR:
+    case MockModel::Function::KIND_DESTRUCTOR:
+    case MockModel::Function::KIND_CONVERSION:
         return false;
-
-    if (!Context->isTranslationUnit())
+    default:
         return true;
-
-    return util::decl::containsFunctionDecls(Children);
+    }
 }
 
 } /* namespace */
 
-GMock::GMock(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "gmock"), ContextMap_()
+GMock::GMock(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "gmock"), ContextMap_()
 {
     /* There is not much choice here as the gmock library is written in C++ */
-    getWriter().getPrintingPolicy().SuppressTagKeyword = true;
-    getWriter().getPrintingPolicy().Bool = true;
-    getWriter().getPrintingPolicy().UseVoidForZeroParams = false;
+    getWriter().setCXX(true);
 }
 
 void GMock::run()
@@ -84,48 +77,35 @@ void GMock::writeIncludeDirectives()
 
 void GMock::writeMockClass()
 {
-    writeMockClass(getASTContext().getTranslationUnitDecl());
+    writeMockClass(&getModel().getContext(0));
 }
 
-void GMock::writeMockClass(const clang::DeclContext *Context,
+void GMock::writeMockClass(const MockModel::Context *Context,
                            unsigned int Indent)
 {
-    llvm::StringRef Name;
-
-    switch (Context->getDeclKind()) {
-    case clang::Decl::TranslationUnit:
+    switch (Context->Kind) {
+    case MockModel::Context::KIND_TRANSLATION_UNIT:
         writeMockClass(Context, getConfig().ClassName, Indent);
-        break;
-    case clang::Decl::Namespace:
-    case clang::Decl::CXXRecord:
-        Name = clang::cast<clang::NamedDecl>(Context)->getName();
-
-        writeMockClass(Context, Name, Indent);
-        break;
-    case clang::Decl::Function:
-    case clang::Decl::CXXConstructor:
-    case clang::Decl::CXXDestructor:
-    case clang::Decl::CXXConversion:
-    case clang::Decl::CXXMethod:
-        writeMockMethod(Context, Indent);
-
         break;
     default:
+        writeMockClass(Context, Context->Name, Indent);
         break;
     }
 }
 
-void GMock::writeMockClass(const clang::DeclContext *Context,
+void GMock::writeMockClass(const MockModel::Context *Context,
                            llvm::StringRef Name,
                            unsigned int Indent)
 {
-    bool IsGlobalContext = util::decl::isGlobalContext(Context);
-    const auto &Children = ContextMap_[Context];
+    bool IsGlobalContext = getModel().isGlobalContext(*Context);
+    bool IsTranslationUnit =
+        Context->Kind == MockModel::Context::KIND_TRANSLATION_UNIT;
+    const auto &Scope = ContextMap_[Context];
 
     getWriter().indent(Indent);
     getWriter().write("class");
 
-    if (Context->isTranslationUnit()) {
+    if (IsTranslationUnit) {
         getWriter().write(" ");
         getWriter().write(Name);
     } else if (IsGlobalContext) {
@@ -138,10 +118,13 @@ void GMock::writeMockClass(const clang::DeclContext *Context,
     getWriter().indent(Indent);
     getWriter().write("public:\n");
 
-    for (const auto &Child : Children)
+    for (const auto *Child : Scope.Contexts)
         writeMockClass(Child, Indent + 4);
 
-    if (requiresPointerVariable(Context, Children))
+    for (const auto *Function : Scope.Functions)
+        writeMockMethod(Function, Indent + 4);
+
+    if (requiresPointerVariable(Context, Scope))
         writeMockPointerInstance(Context, Indent + 4);
 
     getWriter().indent(Indent);
@@ -163,8 +146,8 @@ void GMock::writePointerDefinitions()
      *      testing::StrictMock<DeclName> *DeclName::ccmock_ptr = nullptr;
      */
 
-    for (const auto &[Context, Children] : ContextMap_) {
-        if (!requiresPointerVariable(Context, Children))
+    for (const auto &[Context, Scope] : ContextMap_) {
+        if (!requiresPointerVariable(Context, Scope))
             continue;
 
         getWriter().write("thread_local testing::");
@@ -218,14 +201,13 @@ void GMock::writeFixtureSetUpFunction()
      * variables.
      */
 
-    for (const auto &[Context, Children] : ContextMap_) {
+    for (const auto &[Context, Scope] : ContextMap_) {
         /*
-         * Keys in 'ContextMap' can only be 'TranslationUnitDecls',
-         * 'NamespaceDecls' and 'CXXRecordDecls' but only the latter two
-         * have a name.
+         * Keys in 'ContextMap' can only be the translation unit,
+         * namespaces and records but only the latter two have a name.
          */
 
-        if (!requiresPointerVariable(Context, Children))
+        if (!requiresPointerVariable(Context, Scope))
             continue;
 
         writeMockPointerAccess(Context, Indent);
@@ -249,14 +231,13 @@ void GMock::writeFixtureTearDownFunction()
      * variables.
      */
 
-    for (const auto &[Context, Children] : ContextMap_) {
+    for (const auto &[Context, Scope] : ContextMap_) {
         /*
-         * Keys in 'ContextMap' can only be 'TranslationUnitDecls',
-         * 'NamespaceDecls' and 'CXXRecordDecls' but only the latter two
-         * have a name.
+         * Keys in 'ContextMap' can only be the translation unit,
+         * namespaces and records but only the latter two have a name.
          */
 
-        if (!requiresPointerVariable(Context, Children))
+        if (!requiresPointerVariable(Context, Scope))
             continue;
 
         writeMockPointerAccess(Context, Indent);
@@ -271,8 +252,8 @@ void GMock::writeFixtureVariables()
 {
     constexpr unsigned int Indent = 4;
 
-    for (const auto &[Context, Children] : ContextMap_) {
-        if (!requiresPointerVariable(Context, Children))
+    for (const auto &[Context, Scope] : ContextMap_) {
+        if (!requiresPointerVariable(Context, Scope))
             continue;
 
         getWriter().indent(Indent);
@@ -282,46 +263,43 @@ void GMock::writeFixtureVariables()
         writeQualifiedMockDeclarationName(Context);
         getWriter().write("> ");
 
-        if (Context->isTranslationUnit())
+        if (Context->Kind == MockModel::Context::KIND_TRANSLATION_UNIT)
             getWriter().write("_");
         else
-            getWriter().write(
-                clang::cast<clang::NamedDecl>(Context)->getName());
+            getWriter().write(Context->Name);
 
         getWriter().write(";\n");
     }
 }
 
-void GMock::writeFixtureVariableAccess(const clang::DeclContext *Context)
+void GMock::writeFixtureVariableAccess(const MockModel::Context *Context)
 {
     constexpr size_t Size = 8;
-    llvm::SmallVector<const clang::DeclContext *, Size> Vec;
+    llvm::SmallVector<const MockModel::Context *, Size> Vec;
 
     getWriter().write("(*this)");
 
-    if (Context->isTranslationUnit()) {
+    if (Context->Kind == MockModel::Context::KIND_TRANSLATION_UNIT) {
         getWriter().write(".");
         getWriter().write(getConfig().GlobalNamespaceName);
         return;
     }
 
-    util::decl::collectAllContexts(Context, Vec);
+    collectAllContexts(Context, Vec);
 
-    /* We don't need the 'TranslationUnitDecl' */
+    /* We don't need the translation unit */
     Vec.pop_back();
 
     for (const auto *Context : llvm::reverse(Vec)) {
-        const auto *Decl = clang::cast<clang::NamedDecl>(Context);
-
         getWriter().write(".");
-        getWriter().write(Decl->getName());
+        getWriter().write(Context->Name);
     }
 }
 
 void GMock::writeMockFunctions()
 {
-    for (const auto &Decl : getFunctionDecls())
-        writeFunction(Decl);
+    for (const auto *Function : getFunctions())
+        writeFunction(Function);
 }
 
 void GMock::writeMain()
@@ -337,29 +315,27 @@ void GMock::writeMain()
                       "}\n\n");
 }
 
-void GMock::writeMockMethod(const clang::DeclContext *Context,
+void GMock::writeMockMethod(const MockModel::Function *Function,
                             unsigned int Indent)
 {
-    const auto *Decl = clang::cast<clang::FunctionDecl>(Context);
-
     getWriter().indent(Indent);
     getWriter().write("MOCK_METHOD((");
 
-    if (util::decl::hasReturnType(Decl))
-        getWriter().writeReturnType(Decl);
+    if (hasReturnType(Function))
+        getWriter().writeReturnType(*Function);
     else
         getWriter().write("void");
 
     getWriter().write("), ");
-    getWriter().writeMockName(Decl);
+    getWriter().writeMockName(*Function);
     getWriter().write(", ");
-    getWriter().writeFunctionParameterList(Decl,
+    getWriter().writeFunctionParameterList(*Function,
                                            /* ParameterNames */ false,
                                            /* VarArgList */ true);
     getWriter().write(");\n");
 }
 
-void GMock::writeMockPointerInstance(const clang::DeclContext *Context,
+void GMock::writeMockPointerInstance(const MockModel::Context *Context,
                                      unsigned int Indent)
 {
     /*
@@ -372,10 +348,10 @@ void GMock::writeMockPointerInstance(const clang::DeclContext *Context,
     getWriter().write(getConfig().MockType);
     getWriter().write("<");
 
-    if (Context->isTranslationUnit()) {
+    if (Context->Kind == MockModel::Context::KIND_TRANSLATION_UNIT) {
         getWriter().write(getConfig().ClassName);
     } else {
-        getWriter().write(clang::cast<clang::NamedDecl>(Context)->getName());
+        getWriter().write(Context->Name);
         getWriter().write("_");
     }
 
@@ -384,7 +360,7 @@ void GMock::writeMockPointerInstance(const clang::DeclContext *Context,
     getWriter().write(";\n");
 }
 
-void GMock::writeMockPointerAccess(const clang::DeclContext *Context,
+void GMock::writeMockPointerAccess(const MockModel::Context *Context,
                                    unsigned int Indent)
 {
     /*
@@ -397,18 +373,19 @@ void GMock::writeMockPointerAccess(const clang::DeclContext *Context,
      * Exemplary mock pointer for a namespace for record:
      *      ccmock_::ClassName::ccmock_ptr_
      */
-    const auto *Parent = Context->getParent();
-    while (Parent && !Parent->isTranslationUnit()) {
+    const auto *Parent = getModel().getParent(*Context);
+    while (Parent &&
+           Parent->Kind != MockModel::Context::KIND_TRANSLATION_UNIT) {
         Context = Parent;
-        Parent = Parent->getParent();
+        Parent = getModel().getParent(*Parent);
     }
 
     getWriter().indent(Indent);
     getWriter().write(getConfig().ClassName);
 
-    if (const auto *Decl = clang::dyn_cast<clang::NamedDecl>(Context)) {
+    if (Context->Kind != MockModel::Context::KIND_TRANSLATION_UNIT) {
         getWriter().write("::");
-        getWriter().write(Decl->getName());
+        getWriter().write(Context->Name);
         getWriter().write("_");
     }
 
@@ -416,84 +393,78 @@ void GMock::writeMockPointerAccess(const clang::DeclContext *Context,
     writeConfigPointerName();
 }
 
-void GMock::writeQualifiedMockDeclarationName(const clang::DeclContext *Context)
+void GMock::writeQualifiedMockDeclarationName(
+    const MockModel::Context *Context)
 {
     constexpr size_t Size = 8;
-    llvm::SmallVector<const clang::DeclContext *, Size> Vec;
+    llvm::SmallVector<const MockModel::Context *, Size> Vec;
 
-    util::decl::collectAllContexts(Context, Vec);
+    collectAllContexts(Context, Vec);
 
-    /* We don't need the 'TranslationUnitDecl' */
+    /* We don't need the translation unit */
     Vec.pop_back();
 
     getWriter().write(getConfig().ClassName);
 
     for (const auto *Item : llvm::reverse(Vec)) {
-        const auto *Decl = clang::cast<clang::NamedDecl>(Item);
-
         /* FIXME: duplicate code */
         getWriter().write("::");
-        getWriter().write(Decl->getName());
+        getWriter().write(Item->Name);
         getWriter().write("_");
     }
 }
 
-void GMock::writeFunction(const clang::FunctionDecl *Decl)
+void GMock::writeFunction(const MockModel::Function *Function)
 {
-    if (Decl->isExternC())
+    if (Function->IsExternC)
         getWriter().write("CCMOCK_LINKAGE ");
 
-    if (util::decl::hasReturnType(Decl)) {
-        getWriter().writeReturnType(Decl);
+    if (hasReturnType(Function)) {
+        getWriter().writeReturnType(*Function);
         getWriter().write("\n");
     }
 
-    getWriter().writeFullyQualifiedName(Decl);
-    getWriter().writeFunctionParameterList(Decl);
-    getWriter().writeFunctionSpecifiers(Decl);
-    getWriter().writeFunctionReferenceQualifiers(Decl);
+    getWriter().writeFullyQualifiedName(*Function);
+    getWriter().writeFunctionParameterList(*Function);
+    getWriter().writeFunctionSpecifiers(*Function);
+    getWriter().writeFunctionReferenceQualifiers(*Function);
     getWriter().write("\n");
-    writeFunctionBody(Decl);
+    writeFunctionBody(Function);
     getWriter().write("\n");
 }
 
-void GMock::writeMockCall(const clang::FunctionDecl *Decl)
+void GMock::writeMockCall(const MockModel::Function *Function)
 {
-    writeMockCallPointerAccess(Decl);
+    writeMockCallPointerAccess(Function);
 
-    getWriter().writeMockName(Decl);
+    getWriter().writeMockName(*Function);
     getWriter().write("(");
 
     /* Write out required function arguments. */
-    auto Parameters = Decl->parameters();
+    const auto &Parameters = Function->Parameters;
 
     for (unsigned int i = 0, Size = Parameters.size(); i < Size; ++i) {
         if (i != 0)
             getWriter().write(", ");
 
-        bool useMove = Parameters[i]->getType()->isRValueReferenceType();
+        bool useMove = Parameters[i].IsRValueReference;
 
         if (useMove)
             getWriter().write("std::move(");
 
-        if (!Parameters[i]->getName().empty()) {
-            getWriter().write(Parameters[i]->getName());
-        } else {
-            getWriter().write("arg");
-            getWriter().write(i + 1);
-        }
+        getWriter().write(Parameters[i].Name);
 
         if (useMove)
             getWriter().write(")");
     }
 
-    if (Decl->isVariadic())
+    if (Function->IsVariadic)
         getWriter().write(", vargs_");
 
     getWriter().write(");\n");
 }
 
-void GMock::writeMockCallPointerAccess(const clang::FunctionDecl *Decl)
+void GMock::writeMockCallPointerAccess(const MockModel::Function *Function)
 {
     /*
      * Example for translation unit:
@@ -502,10 +473,12 @@ void GMock::writeMockCallPointerAccess(const clang::FunctionDecl *Decl)
      *      (*ccmock_::Namespace_::Class::ccmock_ptr).
      *      (*ccmock_::Class1_::Class2::ccmock_ptr).
      */
+    const auto *Context = &getModel().getContext(Function->Context);
+
     getWriter().write("(*");
     getWriter().write(getConfig().ClassName);
 
-    if (Decl->getParent()->isTranslationUnit()) {
+    if (Context->Kind == MockModel::Context::KIND_TRANSLATION_UNIT) {
         getWriter().write("::");
         writeConfigPointerName();
         getWriter().write(").");
@@ -514,20 +487,17 @@ void GMock::writeMockCallPointerAccess(const clang::FunctionDecl *Decl)
     }
 
     constexpr size_t Size = 8;
-    llvm::SmallVector<const clang::DeclContext *, Size> Vec;
+    llvm::SmallVector<const MockModel::Context *, Size> Vec;
 
-    util::decl::collectAllContexts(Decl->getParent(), Vec);
+    collectAllContexts(Context, Vec);
 
-    /* We don't need the 'TranslationUnitDecl' */
+    /* We don't need the translation unit */
     Vec.pop_back();
 
     for (const auto *Item : llvm::reverse(Vec)) {
-        const auto *Decl = clang::cast<clang::NamedDecl>(Item);
-        const auto Name = Decl->getName();
-
-        if (util::decl::isGlobalContext(Item)) {
+        if (getModel().isGlobalContext(*Item)) {
             getWriter().write("::");
-            getWriter().write(Name);
+            getWriter().write(Item->Name);
             getWriter().write("_::");
 
             writeConfigPointerName();
@@ -537,20 +507,20 @@ void GMock::writeMockCallPointerAccess(const clang::FunctionDecl *Decl)
         }
 
         getWriter().write(".");
-        getWriter().write(Name);
+        getWriter().write(Item->Name);
     }
 
     getWriter().write(".");
 }
 
-void GMock::writeFunctionBody(const clang::FunctionDecl *Decl)
+void GMock::writeFunctionBody(const MockModel::Function *Function)
 {
     /* Open the function body */
     getWriter().write("{\n");
 
-    switch (Decl->getDeclKind()) {
-    case clang::Decl::CXXConstructor:
-    case clang::Decl::CXXDestructor:
+    switch (Function->Kind) {
+    case MockModel::Function::KIND_CONSTRUCTOR:
+    case MockModel::Function::KIND_DESTRUCTOR:
         /*
          * Constructors and destructors of global objects cannot be checked
          * via the mock mechanism as no appropriate test fixture is set up
@@ -561,7 +531,7 @@ void GMock::writeFunctionBody(const clang::FunctionDecl *Decl)
          *          return;
          */
         getWriter().write("    if (!");
-        writeMockPointerAccess(Decl->getDeclContext());
+        writeMockPointerAccess(&getModel().getContext(Function->Context));
         getWriter().write(")\n"
                           "        return;\n\n");
         break;
@@ -575,12 +545,12 @@ void GMock::writeFunctionBody(const clang::FunctionDecl *Decl)
      *      return mock.func(arg1, arg2);
      *  }
      */
-    if (!Decl->isVariadic()) {
+    if (!Function->IsVariadic) {
         getWriter().write("    ");
-        if (!Decl->getReturnType()->isVoidType())
+        if (!Function->ReturnsVoid)
             getWriter().write("return ");
 
-        writeMockCall(Decl);
+        writeMockCall(Function);
 
         /* Close the function body */
         getWriter().write("}\n");
@@ -602,28 +572,17 @@ void GMock::writeFunctionBody(const clang::FunctionDecl *Decl)
     getWriter().write("    va_list vargs_;\n"
                       "\n"
                       "    va_start(vargs_, ");
-
-    auto Parameters = Decl->parameters();
-
-    const auto *ParmVarDecl = Parameters.back();
-
-    if (!ParmVarDecl->getName().empty())
-        getWriter().write(ParmVarDecl->getName());
-    else {
-        getWriter().write("arg");
-        getWriter().write(Parameters.size());
-    }
-
+    getWriter().write(Function->Parameters.back().Name);
     getWriter().write(");\n"
                       "    ");
-    if (!Decl->getReturnType()->isVoidType())
+    if (!Function->ReturnsVoid)
         getWriter().write("auto ccmock_val_ = ");
 
-    writeMockCall(Decl);
+    writeMockCall(Function);
 
     getWriter().write("    va_end(vargs_);\n");
 
-    if (!Decl->getReturnType()->isVoidType()) {
+    if (!Function->ReturnsVoid) {
         getWriter().write("\n"
                           "    return ccmock_val_;\n");
     }
@@ -632,6 +591,32 @@ void GMock::writeFunctionBody(const clang::FunctionDecl *Decl)
     getWriter().write("}\n");
 }
 
+bool GMock::requiresPointerVariable(const MockModel::Context *Context,
+                                    const Scope &Scope) const
+{
+    if (!getModel().isGlobalContext(*Context))
+        return false;
+
+    if (Context->Kind != MockModel::Context::KIND_TRANSLATION_UNIT)
+        return true;
+
+    constexpr auto IsFunction = [](const MockModel::Function *Function) {
+        return Function->Kind == MockModel::Function::KIND_FUNCTION;
+    };
+
+    return llvm::any_of(Scope.Functions, IsFunction);
+}
+
+void GMock::collectAllContexts(
+    const MockModel::Context *Context,
+    llvm::SmallVectorImpl<const MockModel::Context *> &Vec) const
+{
+    while (Context) {
+        Vec.push_back(Context);
+        Context = getModel().getParent(*Context);
+    }
+}
+
 const Config::GMockSection &GMock::getConfig() const
 {
     return OutputGenerator::getConfig().GMock;
@@ -18,13 +18,13 @@
 #ifndef GMOCK_HPP_
 #define GMOCK_HPP_
 
-#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SmallVector.h>
 
 #include "OutputGenerator.hpp"
 
 class GMock : public OutputGenerator {
 public:
-    GMock(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy);
+    explicit GMock(std::shared_ptr<const Config> Config);
 
     void run() override;
 
@@ -34,9 +34,9 @@ private:
     void writeIncludeDirectives();
 
     void writeMockClass();
-    void writeMockClass(const clang::DeclContext *Context,
+    void writeMockClass(const MockModel::Context *Context,
                         unsigned int Indent = 0);
-    void writeMockClass(const clang::DeclContext *Context,
+    void writeMockClass(const MockModel::Context *Context,
                         llvm::StringRef Name,
                         unsigned int Indent = 0);
 
@@ -46,34 +46,35 @@ private:
     void writeFixtureSetUpFunction();
     void writeFixtureTearDownFunction();
     void writeFixtureVariables();
-    void writeFixtureVariableAccess(const clang::DeclContext *Context);
+    void writeFixtureVariableAccess(const MockModel::Context *Context);
 
     void writeMockFunctions();
     void writeMain();
 
-    void writeMockMethod(const clang::DeclContext *Context,
+    void writeMockMethod(const MockModel::Function *Function,
                          unsigned int Indent = 0);
-    void writeMockPointerInstance(const clang::DeclContext *Context,
+    void writeMockPointerInstance(const MockModel::Context *Context,
                                   unsigned int Indent = 0);
-    void writeMockPointerAccess(const clang::DeclContext *Context,
+    void writeMockPointerAccess(const MockModel::Context *Context,
                                 unsigned int Indent = 0);
 
-    void writeQualifiedMockDeclarationName(const clang::DeclContext *Context);
+    void writeQualifiedMockDeclarationName(const MockModel::Context *Context);
 
-    void writeFunction(const clang::FunctionDecl *Decl);
-    void writeMockCall(const clang::FunctionDecl *Decl);
-    void writeMockCallPointerAccess(const clang::FunctionDecl *Decl);
-    void writeFunctionBody(const clang::FunctionDecl *Decl);
+    void writeFunction(const MockModel::Function *Function);
+    void writeMockCall(const MockModel::Function *Function);
+    void writeMockCallPointerAccess(const MockModel::Function *Function);
+    void writeFunctionBody(const MockModel::Function *Function);
+
+    bool requiresPointerVariable(const MockModel::Context *Context,
+                                 const Scope &Scope) const;
+    void collectAllContexts(
+        const MockModel::Context *Context,
+        llvm::SmallVectorImpl<const MockModel::Context *> &Vec) const;
 
     const Config::GMockSection &getConfig() const;
     void writeConfigPointerName();
 
-    /* clang-format off */
-    llvm::DenseMap<
-        const clang::DeclContext *, 
-        llvm::DenseSet<const clang::DeclContext *>
-    > ContextMap_;
-    /* clang-format on */
+    ContextMap ContextMap_;
 };
 
 #endif /* GMOCK_HPP_ */
@@ -17,380 +17,110 @@
 
 #include "OutputGenerator.hpp"
 
-#include <clang/AST/RecursiveASTVisitor.h>
-#include <clang/Basic/SourceManager.h>
-#include <llvm/ADT/StringSet.h>
-#include <llvm/Support/GlobPattern.h>
+#include <array>
+#include <chrono>
+#include <ctime>
 
-#include "util/Decl.hpp"
-#include "util/Glob.hpp"
+#include "util/FileSystem.hpp"
 #include "util/commandline.hpp"
 
 namespace {
 
-const llvm::StringMap<int> InternalBlacklist = {
-    {"environ", 0},
-    {"stdin", 0},
-    {"stdout", 0},
-    {"stderr", 0},
-    {"std::cin", 0},
-    {"std::wcin", 0},
-    {"std::cout", 0},
-    {"std::wcout", 0},
-    {"std::cerr", 0},
-    {"std::wcerr", 0},
-};
-
-class ASTVisitor : public clang::RecursiveASTVisitor<ASTVisitor> {
-public:
-    static void run(clang::ASTContext &Context, OutputGenerator &Generator);
-
-    bool VisitCallExpr(clang::CallExpr *CallExpr);
-    bool VisitCXXConstructExpr(clang::CXXConstructExpr *ConstructExpr);
-    bool VisitDeclRefExpr(clang::DeclRefExpr *DeclRefExpr);
-
-    bool shouldWalkTypesOfTypeLocs() const;
-
-private:
-    ASTVisitor(clang::ASTContext &Context, OutputGenerator *Generator);
-
-    const Config &getConfig() const;
-
-    void dispatch(const clang::Expr *Expr, const clang::FunctionDecl *Decl);
-    bool isVisited(const clang::DeclaratorDecl *Decl);
-
-    void doVisitCallExpr(const clang::CallExpr *CallExpr);
-    void doVisitCXXConstructExpr(const clang::CXXConstructExpr *ConstructExpr);
-    void doVisitDeclRefExpr(const clang::DeclRefExpr *DeclRefExpr);
-
-    OutputGenerator *Generator_;
-
-    std::vector<std::pair<llvm::StringRef, llvm::GlobPattern>> GlobBlacklist_;
-    llvm::DenseSet<int64_t> Visited_;
-    llvm::StringMap<int> Blacklist_;
-    clang::SourceManager *SourceManager_;
-
-    std::string Buffer_;
-};
-
-void ASTVisitor::run(clang::ASTContext &Context, OutputGenerator &Generator)
+template <typename T> void sortByQualifiedName(std::vector<const T *> &Items)
 {
-    ASTVisitor Visitor(Context, &Generator);
-
-    Visitor.TraverseDecl(Context.getTranslationUnitDecl());
+    /* Overloaded functions keep the order of their first use */
+    llvm::stable_sort(Items, [](const T *A, const T *B) {
+        return A->QualifiedName < B->QualifiedName;
+    });
 }
 
-ASTVisitor::ASTVisitor(clang::ASTContext &Context, OutputGenerator *Generator)
-    : Generator_(Generator),
-      GlobBlacklist_(),
-      Visited_(64),
-      Blacklist_(32),
-      SourceManager_(&Context.getSourceManager()),
-      Buffer_()
-{
-    Buffer_.reserve(256);
-
-    for (const auto &Name : getConfig().Mocking.Blacklist) {
-        if (!util::glob::isPattern(Name)) {
-            Blacklist_.insert({Name, 0});
-            continue;
-        }
-
-        auto ExpectedGlob = llvm::GlobPattern::create(Name);
-        if (!ExpectedGlob) {
-            llvm::errs() << util::cl::error() << ExpectedGlob.takeError()
-                         << "\n";
-
-            std::exit(EXIT_FAILURE);
-        }
-
-        GlobBlacklist_.push_back({Name, std::move(*ExpectedGlob)});
-    }
-}
-
-const Config &ASTVisitor::getConfig() const
-{
-    return Generator_->getConfig();
-}
-
-bool ASTVisitor::VisitCallExpr(clang::CallExpr *CallExpr)
-{
-    doVisitCallExpr(CallExpr);
-
-    return true;
-}
-
-bool ASTVisitor::VisitCXXConstructExpr(clang::CXXConstructExpr *ConstructExpr)
-{
-    doVisitCXXConstructExpr(ConstructExpr);
-
-    return true;
-}
-
-bool ASTVisitor::VisitDeclRefExpr(clang::DeclRefExpr *DeclRefExpr)
-{
-    doVisitDeclRefExpr(DeclRefExpr);
-
-    return true;
-}
+} /* namespace */
 
-bool ASTVisitor::shouldWalkTypesOfTypeLocs() const
+OutputGenerator::OutputGenerator(std::shared_ptr<const Config> Config,
+                                 llvm::StringRef GeneratorName)
+    : Model_(nullptr),
+      Config_(std::move(Config)),
+      Writer_(),
+      OutputStream_(&llvm::outs()),
+      Statistics_(nullptr),
+      Functions_(),
+      Variables_(),
+      Name_(GeneratorName),
+      AnyVariadic_(false)
 {
-    return false;
 }
 
-void ASTVisitor::dispatch(const clang::Expr *Expr,
-                          const clang::FunctionDecl *Decl)
+void OutputGenerator::generate(const MockModel &Model)
 {
-    llvm::raw_string_ostream OS(Buffer_);
-
-    /*
-     * Call expressions via function pointers don't have a function
-     * declaration associated with them.
-     */
-    if (!Decl)
-        return;
-
-    if (!SourceManager_->isInMainFile(Expr->getExprLoc()))
-        return;
-
-    if (Decl->isDefined())
-        return;
-
-    /*
-     * Mocking this function raises a lot of issues as it is heavily used
-     * when dealing with system calls. This most likely will negatively
-     * impact any unit test framework before even running any tests.
-     */
-    if (Decl->getIdentifier() && Decl->getName().equals("__errno_location"))
-        return;
-
-    /*
-     * Deal with builtin functions which might refer to compiler builtins
-     * like "__builtin_expect" or standard library functions.
-     */
-    const auto &Config = getConfig();
-
-    if (Decl->getBuiltinID()) {
-        auto Name = Decl->getName();
-
-        /* Non standard library builtins */
-        if (Name.startswith("__builtin_") && !Config.Mocking.MockBuiltins) {
-            if (Config.General.Verbose) {
-                llvm::errs() << util::cl::info() << "skipping builtin \""
-                             << Name << "\"\n";
-            }
-
-            return;
-        }
-
-        /* C++ standard library functions */
-        if (Decl->isInStdNamespace() && !Config.Mocking.MockCXXStdLib) {
-            if (Config.General.Verbose) {
-                llvm::errs() << util::cl::info()
-                             << "skipping C++ standard library function \"";
-                Decl->printQualifiedName(llvm::errs());
-                llvm::errs() << "\"\n";
-            }
-
-            return;
-        }
-
-        /* C standard library functions */
-        if (!Config.Mocking.MockCStdLib) {
-            if (Config.General.Verbose) {
-                llvm::errs() << util::cl::info()
-                             << "skipping C standard library function \"";
-                Decl->printQualifiedName(llvm::errs());
-                llvm::errs() << "\"\n";
-            }
-
-            return;
-        }
-    }
-
-    Buffer_.clear();
-    Decl->printQualifiedName(OS);
-
-    if (Blacklist_.count(Buffer_)) {
-        if (Config.General.Verbose) {
-            llvm::errs() << util::cl::info() << "skipping \"" << Buffer_
-                         << "\" due to blacklist entry\n";
-        }
-        return;
-    }
-
-    for (const auto &[Pattern, Glob] : GlobBlacklist_) {
-        if (Glob.match(Buffer_)) {
-            if (Config.General.Verbose) {
-                llvm::errs()
-                    << util::cl::info() << "skipping \"" << Buffer_
-                    << "\" due to blacklist entry \"" << Pattern << "\"\n";
-            }
+    auto Start = std::chrono::steady_clock::now();
 
-            return;
-        }
-    }
+    Model_ = &Model;
 
-    if (isVisited(Decl))
-        return;
+    Functions_.clear();
+    Functions_.reserve(Model.getFunctions().size());
 
-    if (Decl->isVariadic()) {
-        if (!Config.Mocking.MockVariadicFunctions)
-            return;
+    for (const auto &Item : Model.getFunctions()) {
+        if (Item.IsVariadic)
+            AnyVariadic_ = true;
 
-        if (Decl->param_empty()) {
-            llvm::errs() << util::cl::error()
-                         << "unable to mock variadic function \"";
-            Decl->printQualifiedName(llvm::errs());
-            llvm::errs() << "\" with no parameters\n";
-
-            std::exit(EXIT_FAILURE);
-        }
+        Functions_.push_back(&Item);
     }
 
-    Generator_->addDecl(Decl);
-}
+    Variables_.clear();
+    Variables_.reserve(Model.getVariables().size());
 
-bool ASTVisitor::isVisited(const clang::DeclaratorDecl *Decl)
-{
-    auto [It, Ok] = Visited_.insert(Decl->getID());
-    if (!Ok && It == Visited_.end()) {
-        llvm::errs() << util::cl::error() << ": ";
-        Decl->printQualifiedName(llvm::errs());
-        llvm::errs() << ": failed to mark declaration as visited\n";
+    for (const auto &Item : Model.getVariables())
+        Variables_.push_back(&Item);
 
-        std::exit(EXIT_FAILURE);
-    }
+    if (Config_->General.Reproducible)
+        sortDecls();
 
-    return !Ok;
-}
+    /* Empty parameter lists are only written as "(void)" for C */
+    Writer_.setVoidForZeroParams(!Writer_.isCXX() && !Model.isCPlusPlus());
 
-void ASTVisitor::doVisitCallExpr(const clang::CallExpr *CallExpr)
-{
-    const auto *Decl = CallExpr->getDirectCallee();
-
-    dispatch(CallExpr, Decl);
-}
-
-void ASTVisitor::doVisitCXXConstructExpr(
-    const clang::CXXConstructExpr *ConstructExpr)
-{
-    const auto *Decl = ConstructExpr->getConstructor();
+    writeFileHeader();
+    run();
+    write();
 
-    dispatch(ConstructExpr, Decl);
-    dispatch(ConstructExpr, Decl->getParent()->getDestructor());
+    if (Statistics_)
+        Statistics_->GenerateTime = std::chrono::steady_clock::now() - Start;
 }
 
-void ASTVisitor::doVisitDeclRefExpr(const clang::DeclRefExpr *DeclRefExpr)
+OutputGenerator::ContextMap OutputGenerator::createContextMap() const
 {
-    llvm::raw_string_ostream OS(Buffer_);
+    auto Map = ContextMap();
 
-    const auto *Decl = clang::dyn_cast<clang::VarDecl>(DeclRefExpr->getDecl());
-    if (!Decl)
-        return;
-
-    //    if (!Decl->hasGlobalStorage())
-    //        return;
-    //
-    if (!Decl->isExternallyVisible())
-        return;
-
-    if (!SourceManager_->isInMainFile(DeclRefExpr->getExprLoc()))
-        return;
-
-    //    if (Decl->getDefinition())
-    //        return;
-
-    if (const auto *CXXRecordDecl = Decl->getType()->getAsCXXRecordDecl()) {
-        /*
-         * On encountering an external declared object we might have to add
-         * its constructor to the list of functions that need to be mocked.
-         */
-        for (const auto *Decl : CXXRecordDecl->ctors()) {
-            if (!Decl->isDefined()) {
-                dispatch(DeclRefExpr, Decl);
-                dispatch(DeclRefExpr, CXXRecordDecl->getDestructor());
-            }
-        }
-    }
+    /*
+     * Create a mapping of all used contexts to their respective child
+     * contexts and functions. Both keep the order of the functions, so
+     * sorting them also sorts the contexts.
+     */
+    for (const auto *Function : getFunctions()) {
+        const auto *Context = &Model_->getContext(Function->Context);
+        const auto *Parent = Model_->getParent(*Context);
 
-    Buffer_.clear();
-    Decl->printQualifiedName(OS);
+        Map[Context].Functions.push_back(Function);
 
-    if (InternalBlacklist.count(Buffer_)) {
-        if (getConfig().General.Verbose) {
-            llvm::errs() << util::cl::info() << "skipping \"" << Buffer_
-                         << "\" due to internal blacklist entry\n";
-        }
-        return;
-    }
+        while (Parent) {
+            Map[Parent].Contexts.insert(Context);
 
-    if (Blacklist_.count(Buffer_)) {
-        if (getConfig().General.Verbose) {
-            llvm::errs() << util::cl::info() << "skipping \"" << Buffer_
-                         << "\" due to blacklist entry\n";
+            Context = Parent;
+            Parent = Model_->getParent(*Parent);
         }
-        return;
     }
 
-    if (isVisited(Decl))
-        return;
-
-    Generator_->addDecl(Decl);
-}
-
-} /* namespace */
-
-OutputGenerator::OutputGenerator(std::shared_ptr<const Config> Config,
-                                 clang::PrintingPolicy Policy,
-                                 llvm::StringRef GeneratorName)
-    : ASTConsumer(),
-      ASTContext_(nullptr),
-      Config_(std::move(Config)),
-      Writer_(Policy),
-      FunctionDecls_(),
-      VarDecls_(),
-      Name_(GeneratorName),
-      AnyVariadic_(false)
-{
-    FunctionDecls_.reserve(32);
-    VarDecls_.reserve(32);
+    return Map;
 }
 
-void OutputGenerator::HandleTranslationUnit(clang::ASTContext &Context)
+void OutputGenerator::sortDecls()
 {
-    ASTContext_ = &Context;
-
-    /* Collect all undefined function and variable declarations */
-    ASTVisitor::run(Context, *this);
-
-    writeFileHeader();
-    run();
-    write();
-}
-
-clang::DiagnosticBuilder
-OutputGenerator::diag(llvm::StringRef Description,
-                      clang::DiagnosticIDs::Level Level)
-{
-    auto &Diags = ASTContext_->getDiagnostics();
-
-    auto ID = Diags.getDiagnosticIDs()->getCustomDiagID(Level, Description);
-
-    return Diags.Report(ID);
-}
-
-clang::DiagnosticBuilder
-OutputGenerator::diag(clang::SourceLocation Loc,
-                      llvm::StringRef Description,
-                      clang::DiagnosticIDs::Level Level)
-{
-    auto &Diags = ASTContext_->getDiagnostics();
-
-    auto ID = Diags.getDiagnosticIDs()->getCustomDiagID(Level, Description);
-
-    return Diags.Report(Loc, ID);
+    /*
+     * The declarations are collected in the order of their first use.
+     * Sorting them by name keeps the output stable if only the order of
+     * the uses within the input file changes.
+     */
+    sortByQualifiedName(Functions_);
+    sortByQualifiedName(Variables_);
 }
 
 void OutputGenerator::writeFileHeader()
@@ -401,7 +131,10 @@ void OutputGenerator::writeFileHeader()
                   " *\n");
     /* clang-format on */
 
-    if (Config_->General.WriteDate) {
+    /* Reproducible outputs must not depend on the time or the machine */
+    auto Reproducible = Config_->General.Reproducible;
+
+    if (Config_->General.WriteDate && !Reproducible) {
         /* Looks like I do not understand std::chrono... */
         constexpr std::size_t Size = 64;
         auto buf = std::array<char, Size>();
@@ -428,9 +161,11 @@ void OutputGenerator::writeFileHeader()
     Writer_.write(Name_);
     Writer_.write("\n");
 
-    Writer_.write(" *    Directory   : ");
-    Writer_.write(Base);
-    Writer_.write("\n");
+    if (!Reproducible) {
+        Writer_.write(" *    Directory   : ");
+        Writer_.write(Base);
+        Writer_.write("\n");
+    }
 
     Writer_.write(" *    Input       : ");
     Writer_.write(Input);
@@ -455,67 +190,33 @@ void OutputGenerator::writeMacroDefinitions()
 
 void OutputGenerator::writeGlobalVariables()
 {
-    bool SavedValue = Writer_.getPrintingPolicy().SuppressTagKeyword;
-
-    Writer_.getPrintingPolicy().SuppressTagKeyword = false;
-
     /* FIXME: make this disableable with a config value */
-    for (const auto *Decl : getVarDecls()) {
-        auto Type = Decl->getType();
-
-        /*
-         * These variable declarations here will all be declared with
-         * "extern" so we have to remove it. Also some might have
-         * gcc attributes assigned to them which also need to be removed.
-         */
-        auto Pointee = Type->getPointeeType();
-        if (!Pointee.isNull() && Pointee->isFunctionType()) {
-            constexpr size_t Size = 64;
-            llvm::SmallString<Size> Buffer;
-            llvm::raw_svector_ostream OS(Buffer);
-
-            Decl->printQualifiedName(OS, Writer_.getPrintingPolicy());
-
-            Writer_.writeType(Type, Buffer.str());
-            Writer_.write(";\n");
-
-            continue;
-        }
-
-        if (const auto *CXXRecordDecl = Type->getAsCXXRecordDecl()) {
-            if (!CXXRecordDecl->hasDefaultConstructor())
-                continue;
-        }
-
-        Writer_.writeType(Type);
-        Writer_.write(" ");
-        Writer_.writeFullyQualifiedName(Decl);
+    for (const auto *Variable : getVariables()) {
+        Writer_.writeVariable(*Variable);
         Writer_.write(";\n");
     }
 
-    if (!getVarDecls().empty())
+    if (!getVariables().empty())
         Writer_.write("\n");
-
-    Writer_.getPrintingPolicy().SuppressTagKeyword = SavedValue;
 }
 
 void OutputGenerator::write()
 {
     const auto &Path = getConfig().General.Output.native();
-    std::error_code error;
+    std::string Content, Error;
 
     if (Path.empty()) {
-        Writer_.flush(llvm::outs());
+        Writer_.flush(*OutputStream_);
         return;
     }
 
-    auto Out = llvm::raw_fd_ostream(Path, error);
-    if (error) {
-        llvm::errs() << util::cl::error() << "failed to open \""
-                     << Config_->General.Output.native()
-                     << "\": " << error.message() << "\n";
+    llvm::raw_string_ostream OS(Content);
+    Writer_.flush(OS);
+
+    /* Keep unchanged outputs to not rebuild anything including them */
+    (void) util::fs::writeIfChanged(Path, OS.str(), Error);
+    if (!Error.empty()) {
+        llvm::errs() << util::cl::error() << Error << "\n";
         std::exit(EXIT_FAILURE);
     }
-
-    Writer_.flush(Out);
 }
@@ -18,71 +18,78 @@
 #ifndef OUTPUTGENERATOR_HPP_
 #define OUTPUTGENERATOR_HPP_
 
-#include <clang/AST/ASTConsumer.h>
-#include <clang/AST/Decl.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/SetVector.h>
 #include <memory>
 #include <vector>
 
 #include "Config.hpp"
+#include "MockModel.hpp"
 #include "OutputWriter.hpp"
+#include "Statistics.hpp"
 
-class OutputGenerator : public clang::ASTConsumer {
+/*
+ * Base class of all backends. Outputs are generated from the mock model
+ * alone, so the AST of the translation unit is not required anymore.
+ */
+
+class OutputGenerator {
 public:
+    /*
+     * The child contexts and the functions of a context, both in the
+     * order of their first use.
+     */
+    struct Scope {
+    public:
+        llvm::SetVector<const MockModel::Context *> Contexts;
+        std::vector<const MockModel::Function *> Functions;
+    };
+
+    using ContextMap = llvm::MapVector<const MockModel::Context *, Scope>;
+
     OutputGenerator(std::shared_ptr<const Config> Config,
-                    clang::PrintingPolicy Policy,
                     llvm::StringRef GeneratorName);
+    virtual ~OutputGenerator() = default;
 
     virtual void run() = 0;
-    void HandleTranslationUnit(clang::ASTContext &Context) override;
-
-    inline void addDecl(const clang::FunctionDecl *Decl);
-    inline void addDecl(const clang::VarDecl *Decl);
+    void generate(const MockModel &Model);
 
     inline const Config &getConfig() const;
-
-    clang::DiagnosticBuilder
-    diag(llvm::StringRef Description,
-         clang::DiagnosticIDs::Level Level = clang::DiagnosticIDs::Warning);
-
-    clang::DiagnosticBuilder
-    diag(clang::SourceLocation Loc,
-         llvm::StringRef Description,
-         clang::DiagnosticIDs::Level Level = clang::DiagnosticIDs::Warning);
+    inline void setOutputStream(llvm::raw_ostream *OS);
+    inline void setStatistics(Statistics *Stats);
 
 protected:
-    inline const clang::ASTContext &getASTContext() const;
+    inline const MockModel &getModel() const;
     inline OutputWriter &getWriter();
-    inline llvm::ArrayRef<const clang::FunctionDecl *> getFunctionDecls() const;
-    inline llvm::ArrayRef<const clang::VarDecl *> getVarDecls() const;
+    inline llvm::ArrayRef<const MockModel::Function *> getFunctions() const;
+    inline llvm::ArrayRef<const MockModel::Variable *> getVariables() const;
     inline bool anyVariadic() const;
 
-    /* clang-format off */
-    inline llvm::DenseMap<
-        const clang::DeclContext *,
-        llvm::DenseSet<const clang::DeclContext *>
-    > createContextMap();
-    /* clang-format on */
+    ContextMap createContextMap() const;
 
     void writeFileHeader();
     void writeMacroDefinitions();
     void writeGlobalVariables();
 
 private:
+    void sortDecls();
     void write();
 
-    const clang::ASTContext *ASTContext_;
+    const MockModel *Model_;
     std::shared_ptr<const Config> Config_;
     OutputWriter Writer_;
-    std::vector<const clang::FunctionDecl *> FunctionDecls_;
-    std::vector<const clang::VarDecl *> VarDecls_;
+    llvm::raw_ostream *OutputStream_;
+    Statistics *Statistics_;
+    std::vector<const MockModel::Function *> Functions_;
+    std::vector<const MockModel::Variable *> Variables_;
     llvm::StringRef Name_;
 
     bool AnyVariadic_;
 };
 
-inline const clang::ASTContext &OutputGenerator::getASTContext() const
+inline const MockModel &OutputGenerator::getModel() const
 {
-    return *ASTContext_;
+    return *Model_;
 }
 
 inline OutputWriter &OutputGenerator::getWriter()
@@ -90,34 +97,31 @@ inline OutputWriter &OutputGenerator::getWriter()
     return Writer_;
 }
 
-inline void OutputGenerator::addDecl(const clang::FunctionDecl *Decl)
+inline const Config &OutputGenerator::getConfig() const
 {
-    if (Decl->isVariadic() && !AnyVariadic_)
-        AnyVariadic_ = true;
-
-    FunctionDecls_.push_back(Decl);
+    return *Config_;
 }
 
-inline void OutputGenerator::addDecl(const clang::VarDecl *Decl)
+inline void OutputGenerator::setOutputStream(llvm::raw_ostream *OS)
 {
-    VarDecls_.push_back(Decl);
+    OutputStream_ = OS;
 }
 
-inline const Config &OutputGenerator::getConfig() const
+inline void OutputGenerator::setStatistics(Statistics *Stats)
 {
-    return *Config_;
+    Statistics_ = Stats;
 }
 
-inline llvm::ArrayRef<const clang::FunctionDecl *>
-OutputGenerator::getFunctionDecls() const
+inline llvm::ArrayRef<const MockModel::Function *>
+OutputGenerator::getFunctions() const
 {
-    return llvm::ArrayRef(FunctionDecls_);
+    return llvm::ArrayRef(Functions_);
 }
 
-inline llvm::ArrayRef<const clang::VarDecl *>
-OutputGenerator::getVarDecls() const
+inline llvm::ArrayRef<const MockModel::Variable *>
+OutputGenerator::getVariables() const
 {
-    return llvm::ArrayRef(VarDecls_);
+    return llvm::ArrayRef(Variables_);
 }
 
 inline bool OutputGenerator::anyVariadic() const
@@ -125,40 +129,4 @@ inline bool OutputGenerator::anyVariadic() const
     return AnyVariadic_;
 }
 
-inline llvm::DenseMap<const clang::DeclContext *,
-                      llvm::DenseSet<const clang::DeclContext *>>
-OutputGenerator::createContextMap()
-{
-    auto Size = getFunctionDecls().size();
-
-    /* clang-format off */
-    auto Map = llvm::DenseMap<
-        const clang::DeclContext *,
-        llvm::DenseSet<const clang::DeclContext *>
-    >(Size);
-    /* clang-format on */
-
-    /*
-     * Create a mapping of all used declaration contexts to their respective
-     * child contexts.
-     */
-    for (const auto *Decl : getFunctionDecls()) {
-        const auto *Context = clang::cast<clang::DeclContext>(Decl);
-        const auto *Parent = Context->getParent();
-
-        Context = Context->getPrimaryContext();
-
-        while (Parent) {
-            Parent = Parent->getPrimaryContext();
-
-            Map[Parent].insert(Context);
-
-            Context = Parent;
-            Parent = Parent->getParent();
-        }
-    }
-
-    return Map;
-}
-
 #endif /* OUTPUTGENERATOR_HPP_ */
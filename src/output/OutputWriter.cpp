@@ -17,16 +17,15 @@
 
 #include "OutputWriter.hpp"
 
-#include "util/Decl.hpp"
-
-void OutputWriter::writeFunctionParameterList(const clang::FunctionDecl *Decl,
-                                              bool ParameterNames,
-                                              bool VarArgList)
+void OutputWriter::writeFunctionParameterList(
+    const MockModel::Function &Function,
+    bool ParameterNames,
+    bool VarArgList)
 {
-    auto Parameters = Decl->parameters();
+    const auto &Parameters = Function.Parameters;
 
     if (Parameters.empty()) {
-        if (PrintingPolicy_.UseVoidForZeroParams)
+        if (VoidForZeroParams_)
             Out_ << "(void)";
         else
             Out_ << "()";
@@ -36,65 +35,17 @@ void OutputWriter::writeFunctionParameterList(const clang::FunctionDecl *Decl,
 
     Out_ << "(";
 
-    for (unsigned int i = 0, Size = Parameters.size(); i < Size; ++i) {
-        const auto *Decl = Parameters[i];
-
+    for (size_t i = 0, Size = Parameters.size(); i < Size; ++i) {
         if (i != 0)
             Out_ << ", ";
 
-        if (!ParameterNames) {
-            writeType(Parameters[i]);
-            continue;
-        }
-
-        /* Ensure that every parameter will have a name associated to it */
-        if (!Parameters[i]->getName().empty()) {
-            writeVarDecl(Parameters[i]);
-            continue;
-        }
-
-        auto Type = Parameters[i]->getType();
-        auto Pointee = Type->getPointeeType();
-
-        if (Pointee.isNull() || !Pointee->isFunctionType()) {
-            writeType(Type);
-
-            /*
-             * We need to be aware of something like "char *const ptr;".
-             * Just checking for "isPointerType()" or "isReferenceType()" to
-             * determine whether we need to append a space character or not is
-             * not sufficient to correctly print such a type declaration.
-             */
-            if (auto C = Buffer_.back(); C != '&' && C != '*')
-                Out_ << " ";
-
-            Out_ << "arg" << i + 1;
-
-            continue;
-        }
-
-        /*
-         * Function pointers or references can be extremely tricky to print
-         * as the name of the corresponding variable is surrounded by its own
-         * type, e.g.:
-         *      void *(*func)(void (*)(int, int))
-         *             ^~~~
-         * We therefore create a new VarDecl (which is obviously not part of
-         * the parsed source code) with an appropriate name and then let
-         * clang's "Decl::print" function do the heavy lifting.
-         */
-        std::string Name;
-        llvm::raw_string_ostream OS(Name);
-
-        OS << "arg" << i + 1;
-
-        auto &Context = Decl->getASTContext();
-
-        const auto *VarDecl = util::decl::fakeVarDecl(Context, Type, Name);
-        writeVarDecl(VarDecl);
+        if (ParameterNames)
+            writeDeclarator(Parameters[i].Declarator, Parameters[i].Name);
+        else
+            writeType(Parameters[i].Type);
     }
 
-    if (Decl->isVariadic()) {
+    if (Function.IsVariadic) {
         if (VarArgList)
             Out_ << ", va_list";
         else
@@ -104,199 +55,39 @@ void OutputWriter::writeFunctionParameterList(const clang::FunctionDecl *Decl,
     Out_ << ")";
 }
 
-void OutputWriter::writeFunctionSpecifiers(const clang::FunctionDecl *Decl)
+void OutputWriter::writeFunctionSpecifiers(const MockModel::Function &Function)
 {
-    const auto *MethodDecl = clang::dyn_cast<clang::CXXMethodDecl>(Decl);
-    if (!MethodDecl)
-        return;
-
-    auto QualType = MethodDecl->getType();
-    const auto *FuncProtoType = QualType->castAs<clang::FunctionProtoType>();
-
-    if (FuncProtoType->isConst())
+    if (Function.IsConst)
         write(" const");
 
-    /*
-     * Seems like destructors can get the noexcept attribute attached
-     * automatically which can cause a warning if we manually attach it
-     * to the definition.
-     */
-    bool IsNoexcept = FuncProtoType->hasNoexceptExceptionSpec();
-    if (IsNoexcept && Decl->getExceptionSpecSourceRange().isValid())
+    if (Function.IsNoexcept)
         write(" noexcept");
 }
 
 void OutputWriter::writeFunctionReferenceQualifiers(
-    const clang::FunctionDecl *Decl)
+    const MockModel::Function &Function)
 {
-    const auto *MethodDecl = clang::dyn_cast<clang::CXXMethodDecl>(Decl);
-    if (!MethodDecl)
-        return;
-
-    switch (MethodDecl->getRefQualifier()) {
-    case clang::RefQualifierKind::RQ_LValue:
+    switch (Function.RefQualifier) {
+    case MockModel::Function::REFQUALIFIER_LVALUE:
         write(" &");
         break;
-    case clang::RefQualifierKind::RQ_RValue:
+    case MockModel::Function::REFQUALIFIER_RVALUE:
         write(" &&");
         break;
-    case clang::RefQualifierKind::RQ_None:
+    case MockModel::Function::REFQUALIFIER_NONE:
     default:
         break;
     }
 }
 
-void OutputWriter::writeMockName(const clang::FunctionDecl *Decl)
+void OutputWriter::writeVariable(const MockModel::Variable &Variable)
 {
-    switch (Decl->getKind()) {
-    case clang::Decl::CXXConstructor:
-        Out_ << "constructor";
-        return;
-    case clang::Decl::CXXDestructor:
-        Out_ << "destructor";
-        return;
-    case clang::Decl::CXXConversion:
-        /* FIXME: implement conversion handling */
-        return;
-    default:
-        break;
-    }
-
-    switch (Decl->getOverloadedOperator()) {
-    case clang::OO_None:
-        Out_ << Decl->getName();
-        break;
-    case clang::OO_New:
-        Out_ << "op_new";
-        break;
-    case clang::OO_Delete:
-        Out_ << "op_delete";
-        break;
-    case clang::OO_Array_New:
-        Out_ << "op_array_new";
-        break;
-    case clang::OO_Array_Delete:
-        Out_ << "op_array_delete";
-        break;
-    case clang::OO_Plus:
-        Out_ << "op_plus";
-        break;
-    case clang::OO_Minus:
-        Out_ << "op_minus";
-        break;
-    case clang::OO_Star:
-        Out_ << "op_star";
-        break;
-    case clang::OO_Slash:
-        Out_ << "op_slash";
-        break;
-    case clang::OO_Percent:
-        Out_ << "op_percent";
-        break;
-    case clang::OO_Caret:
-        Out_ << "op_caret";
-        break;
-    case clang::OO_Amp:
-        Out_ << "op_amp";
-        break;
-    case clang::OO_Pipe:
-        Out_ << "op_pipe";
-        break;
-    case clang::OO_Tilde:
-        Out_ << "op_tilde";
-        break;
-    case clang::OO_Exclaim:
-        Out_ << "op_exclaim";
-        break;
-    case clang::OO_Equal:
-        Out_ << "op_equal";
-        break;
-    case clang::OO_Less:
-        Out_ << "op_less";
-        break;
-    case clang::OO_Greater:
-        Out_ << "op_greater";
-        break;
-    case clang::OO_PlusEqual:
-        Out_ << "op_plus_equal";
-        break;
-    case clang::OO_MinusEqual:
-        Out_ << "op_minus_equal";
-        break;
-    case clang::OO_StarEqual:
-        Out_ << "op_star_equal";
-        break;
-    case clang::OO_SlashEqual:
-        Out_ << "op_slash_equal";
-        break;
-    case clang::OO_PercentEqual:
-        Out_ << "op_percent_equal";
-        break;
-    case clang::OO_CaretEqual:
-        Out_ << "op_caret_equal";
-        break;
-    case clang::OO_AmpEqual:
-        Out_ << "op_amp_equal";
-        break;
-    case clang::OO_PipeEqual:
-        Out_ << "op_pipe_equal";
-        break;
-    case clang::OO_LessLess:
-        Out_ << "op_less_less";
-        break;
-    case clang::OO_GreaterGreater:
-        Out_ << "op_greater_greater";
-        break;
-    case clang::OO_LessLessEqual:
-        Out_ << "op_less_less_equal";
-        break;
-    case clang::OO_GreaterGreaterEqual:
-        Out_ << "op_greater_greater_equal";
-        break;
-    case clang::OO_EqualEqual:
-        Out_ << "op_equal_equal";
-        break;
-    case clang::OO_ExclaimEqual:
-        Out_ << "op_exclaim_equal";
-        break;
-    case clang::OO_LessEqual:
-        Out_ << "op_less_equal";
-        break;
-    case clang::OO_GreaterEqual:
-        Out_ << "op_greater_equal";
-        break;
-    case clang::OO_Spaceship:
-        Out_ << "op_spaceship";
-        break;
-    case clang::OO_AmpAmp:
-        Out_ << "op_amp_amp";
-        break;
-    case clang::OO_PipePipe:
-        Out_ << "op_pipe_pipe";
-        break;
-    case clang::OO_PlusPlus:
-        Out_ << "op_plus_plus";
-        break;
-    case clang::OO_MinusMinus:
-        Out_ << "op_minus_minus";
-        break;
-    case clang::OO_Comma:
-        Out_ << "op_comma";
-        break;
-    case clang::OO_ArrowStar:
-        Out_ << "op_arrow_star";
-        break;
-    case clang::OO_Arrow:
-        Out_ << "op_arrow";
-        break;
-    case clang::OO_Call:
-        Out_ << "op_call";
-        break;
-    case clang::OO_Subscript:
-        Out_ << "op_subscript";
-        break;
-    default:
-        llvm_unreachable("unknown overloaded operator");
-        break;
-    }
+    /*
+     * Variables are declared with "extern" and might have attributes
+     * attached to them, so write only their type and name.
+     */
+    if (CXX_)
+        writeDeclarator(Variable.CXXDeclarator, Variable.QualifiedName);
+    else
+        writeDeclarator(Variable.Declarator, Variable.QualifiedName);
 }
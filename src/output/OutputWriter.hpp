@@ -18,49 +18,52 @@
 #ifndef OUTPUTWRITER_HPP_
 #define OUTPUTWRITER_HPP_
 
-#include <clang/AST/ASTContext.h>
-#include <clang/AST/Decl.h>
-#include <clang/AST/PrettyPrinter.h>
+#include <cstdio>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "MockModel.hpp"
 
 class OutputWriter {
 public:
-    explicit inline OutputWriter(clang::PrintingPolicy Policy);
+    inline OutputWriter();
 
     inline void indent(unsigned int N);
-    inline void writeDeclName(const clang::DeclContext *Context);
-    inline void writeFullyQualifiedName(const clang::NamedDecl *Decl);
-    inline void writeFunctionDecl(const clang::FunctionDecl *Decl,
-                                  unsigned int Indent = 0);
-    void writeFunctionParameterList(const clang::FunctionDecl *Decl,
+    inline void writeFullyQualifiedName(const MockModel::Function &Function);
+    inline void writeFunctionDecl(const MockModel::Function &Function);
+    void writeFunctionParameterList(const MockModel::Function &Function,
                                     bool ParameterNames = true,
                                     bool VarArgList = false);
-    void writeFunctionSpecifiers(const clang::FunctionDecl *Decl);
-    void writeFunctionReferenceQualifiers(const clang::FunctionDecl *Decl);
-    void writeMockName(const clang::FunctionDecl *Decl);
-    inline void writeReturnType(const clang::FunctionDecl *Decl,
-                                llvm::Twine Twine = llvm::Twine());
-    inline void writeType(const clang::VarDecl *Decli,
-                          llvm::Twine Twine = llvm::Twine());
-    inline void writeType(clang::QualType Type,
-                          llvm::Twine Twine = llvm::Twine());
-    inline void writeVarDecl(const clang::VarDecl *Decl,
-                             bool PrintInstantiation = false);
+    void writeFunctionSpecifiers(const MockModel::Function &Function);
+    void writeFunctionReferenceQualifiers(const MockModel::Function &Function);
+    inline void writeMockName(const MockModel::Function &Function);
+    inline void writeReturnType(const MockModel::Function &Function);
+    inline void writeType(const MockModel::Type &Type);
+    inline void writeDeclarator(const MockModel::Declarator &Declarator,
+                                llvm::StringRef Name);
+    void writeVariable(const MockModel::Variable &Variable);
 
     template <typename T> void write(T Data);
 
     inline void flush(llvm::raw_ostream &OS);
 
-    inline clang::PrintingPolicy &getPrintingPolicy();
-    const inline clang::PrintingPolicy &getPrintingPolicy() const;
+    inline void setCXX(bool Value);
+    inline void setVoidForZeroParams(bool Value);
+    inline bool isCXX() const;
 
 private:
-    clang::PrintingPolicy PrintingPolicy_;
     std::string Buffer_;
     llvm::raw_string_ostream Out_;
+
+    /* Print types suitable for C++, e.g. "bool" instead of "_Bool" */
+    bool CXX_;
+    bool VoidForZeroParams_;
 };
 
-OutputWriter::OutputWriter(clang::PrintingPolicy Policy)
-    : PrintingPolicy_(Policy), Buffer_(), Out_(Buffer_)
+inline OutputWriter::OutputWriter()
+    : Buffer_(), Out_(Buffer_), CXX_(false), VoidForZeroParams_(false)
 {
     Buffer_.reserve(BUFSIZ);
 }
@@ -70,45 +73,37 @@ inline void OutputWriter::indent(unsigned int N)
     Out_.indent(N);
 }
 
-inline void OutputWriter::writeDeclName(const clang::DeclContext *Context)
-{
-    Out_ << clang::cast<clang::NamedDecl>(Context)->getName();
-}
-
-inline void OutputWriter::writeFullyQualifiedName(const clang::NamedDecl *Decl)
+inline void
+OutputWriter::writeFullyQualifiedName(const MockModel::Function &Function)
 {
-    Decl->printQualifiedName(Out_);
+    Out_ << Function.QualifiedName;
 }
 
-inline void OutputWriter::writeFunctionDecl(const clang::FunctionDecl *Decl,
-                                            unsigned int Indent)
+inline void OutputWriter::writeFunctionDecl(const MockModel::Function &Function)
 {
-    Decl->print(Out_, PrintingPolicy_, Indent);
+    Out_ << Function.Declaration;
 }
 
-inline void OutputWriter::writeReturnType(const clang::FunctionDecl *Decl,
-                                          llvm::Twine Twine)
+inline void OutputWriter::writeMockName(const MockModel::Function &Function)
 {
-    auto Type = Decl->getReturnType();
-
-    writeType(Type, Twine);
+    Out_ << Function.MockName;
 }
 
-inline void OutputWriter::writeType(const clang::VarDecl *Decl,
-                                    llvm::Twine Twine)
+inline void OutputWriter::writeReturnType(const MockModel::Function &Function)
 {
-    writeType(Decl->getType(), Twine);
+    writeType(Function.ReturnType);
 }
 
-inline void OutputWriter::writeType(clang::QualType Type, llvm::Twine Twine)
+inline void OutputWriter::writeType(const MockModel::Type &Type)
 {
-    Type.getCanonicalType().print(Out_, PrintingPolicy_, Twine);
+    Out_ << (CXX_ ? Type.CXXSpelling : Type.Spelling);
 }
 
-inline void OutputWriter::writeVarDecl(const clang::VarDecl *Decl,
-                                       bool PrintInstantiation)
+inline void
+OutputWriter::writeDeclarator(const MockModel::Declarator &Declarator,
+                              llvm::StringRef Name)
 {
-    Decl->print(Out_, PrintInstantiation);
+    Out_ << Declarator.Head << Name << Declarator.Tail;
 }
 
 template <typename T> void OutputWriter::write(T Data)
@@ -122,14 +117,19 @@ inline void OutputWriter::flush(llvm::raw_ostream &OS)
     Buffer_.clear();
 }
 
-inline clang::PrintingPolicy &OutputWriter::getPrintingPolicy()
+inline void OutputWriter::setCXX(bool Value)
+{
+    CXX_ = Value;
+}
+
+inline void OutputWriter::setVoidForZeroParams(bool Value)
 {
-    return PrintingPolicy_;
+    VoidForZeroParams_ = Value;
 }
 
-const inline clang::PrintingPolicy &OutputWriter::getPrintingPolicy() const
+inline bool OutputWriter::isCXX() const
 {
-    return PrintingPolicy_;
+    return CXX_;
 }
 
 #endif /* OUTPUTWRITER_HPP_ */
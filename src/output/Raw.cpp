@@ -17,11 +17,9 @@
 
 #include "Raw.hpp"
 
-#include "clang/AST/DeclCXX.h"
-
-Raw::Raw(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "Raw"),
-      CurrentAccess_(clang::AccessSpecifier::AS_none)
+Raw::Raw(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "Raw"),
+      CurrentAccess_(MockModel::Function::ACCESS_NONE)
 {
 }
 
@@ -29,89 +27,96 @@ void Raw::run()
 {
     ContextMap_ = createContextMap();
 
-    visit(getASTContext().getTranslationUnitDecl());
+    visit(&getModel().getContext(0));
 }
 
-void Raw::visit(const clang::DeclContext *Context, unsigned int Indent)
+void Raw::visit(const MockModel::Context *Context, unsigned int Indent)
 {
-    switch (Context->getDeclKind()) {
-    case clang::Decl::TranslationUnit:
-        for (const auto &Child : ContextMap_[Context])
+    const auto &Scope = ContextMap_[Context];
+
+    switch (Context->Kind) {
+    case MockModel::Context::KIND_TRANSLATION_UNIT:
+        for (const auto *Child : Scope.Contexts)
             visit(Child, Indent);
 
+        for (const auto *Function : Scope.Functions)
+            visit(Function, Indent);
+
         break;
-    case clang::Decl::Namespace:
+    case MockModel::Context::KIND_NAMESPACE:
         getWriter().indent(Indent);
         getWriter().write("namespace ");
-        getWriter().writeDeclName(Context);
+        getWriter().write(Context->Name);
         getWriter().write(" {\n\n");
 
-        for (const auto &Child : ContextMap_[Context])
+        for (const auto *Child : Scope.Contexts)
             visit(Child, Indent);
 
+        for (const auto *Function : Scope.Functions)
+            visit(Function, Indent);
+
         getWriter().write("\n} /* namespace ");
-        getWriter().writeDeclName(Context);
+        getWriter().write(Context->Name);
         getWriter().write(" */\n\n");
         break;
-    case clang::Decl::CXXRecord:
+    case MockModel::Context::KIND_CLASS:
+    case MockModel::Context::KIND_STRUCT:
+    case MockModel::Context::KIND_UNION:
         getWriter().indent(Indent);
 
-        switch (clang::cast<clang::CXXRecordDecl>(Context)->getTagKind()) {
-        case clang::TagTypeKind::TTK_Class:
+        switch (Context->Kind) {
+        case MockModel::Context::KIND_CLASS:
             getWriter().write("class ");
             break;
-        case clang::TagTypeKind::TTK_Struct:
+        case MockModel::Context::KIND_STRUCT:
             getWriter().write("struct ");
             break;
-        case clang::TagTypeKind::TTK_Union:
+        default:
             /* FIXME: Test needed! */
             getWriter().write("union ");
             break;
-        default:
-            break;
         }
 
-        getWriter().writeDeclName(Context);
+        getWriter().write(Context->Name);
         getWriter().write(" {\n");
 
-        for (const auto &Child : ContextMap_[Context])
+        for (const auto *Child : Scope.Contexts)
             visit(Child, Indent + 4);
 
+        for (const auto *Function : Scope.Functions)
+            visit(Function, Indent + 4);
+
         getWriter().write("};\n\n");
 
-        CurrentAccess_ = clang::AccessSpecifier::AS_none;
+        CurrentAccess_ = MockModel::Function::ACCESS_NONE;
         break;
-    case clang::Decl::Function:
-    case clang::Decl::CXXConstructor:
-    case clang::Decl::CXXDestructor:
-    case clang::Decl::CXXConversion:
-    case clang::Decl::CXXMethod: {
-        const auto *Decl = clang::cast<clang::FunctionDecl>(Context);
-
-        auto Access = Decl->getAccess();
-        if (Access != CurrentAccess_) {
-            switch (Access) {
-            case clang::AccessSpecifier::AS_public:
-                getWriter().write("public:\n");
-                break;
-            case clang::AccessSpecifier::AS_protected:
-                getWriter().write("protected:\n");
-                break;
-            case clang::AccessSpecifier::AS_private:
-                getWriter().write("private:\n");
-                break;
-            default:
-                break;
-            }
-
-            CurrentAccess_ = Access;
-        }
-
-        getWriter().indent(Indent);
-        getWriter().writeFunctionDecl(Decl, Indent);
-        getWriter().write(";\n");
-    }
     default:
         break;
     };
 }
+
+void Raw::visit(const MockModel::Function *Function, unsigned int Indent)
+{
+    auto Access = Function->Access;
+    if (Access != CurrentAccess_) {
+        switch (Access) {
+        case MockModel::Function::ACCESS_PUBLIC:
+            getWriter().write("public:\n");
+            break;
+        case MockModel::Function::ACCESS_PROTECTED:
+            getWriter().write("protected:\n");
+            break;
+        case MockModel::Function::ACCESS_PRIVATE:
+            getWriter().write("private:\n");
+            break;
+        default:
+            break;
+        }
+
+        CurrentAccess_ = Access;
+    }
+
+    getWriter().indent(Indent);
+    getWriter().writeFunctionDecl(*Function);
+    getWriter().write(";\n");
+}
@@ -22,21 +22,17 @@
 
 class Raw : public OutputGenerator {
 public:
-    Raw(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy);
+    explicit Raw(std::shared_ptr<const Config> Config);
 
     void run() override;
 
 private:
-    void visit(const clang::DeclContext *Context, unsigned int Indent = 0);
+    void visit(const MockModel::Context *Context, unsigned int Indent = 0);
+    void visit(const MockModel::Function *Function, unsigned int Indent = 0);
 
-    /* clang-format off */
-    llvm::DenseMap<
-        const clang::DeclContext *, 
-        llvm::DenseSet<const clang::DeclContext *>
-    > ContextMap_;
-    /* clang-format on */
+    ContextMap ContextMap_;
 
-    clang::AccessSpecifier CurrentAccess_;
+    enum MockModel::Function::Access CurrentAccess_;
 };
 
 #endif /* RAW_HPP_ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileCache.hpp"
+
+#include <mutex>
+
+#include <llvm/Support/Path.h>
+
+namespace {
+
+bool isUnchanged(const llvm::ErrorOr<llvm::vfs::Status> &A,
+                 const llvm::ErrorOr<llvm::vfs::Status> &B)
+{
+    if (!A || !B)
+        return !A && !B && A.getError() == B.getError();
+
+    return A->getUniqueID() == B->getUniqueID()
+           && A->getLastModificationTime() == B->getLastModificationTime()
+           && A->getSize() == B->getSize();
+}
+
+/*
+ * Hands out the contents of a cached file without copying them. The
+ * cached buffer stays alive as long as any file refers to it.
+ */
+class CachedFile : public llvm::vfs::File {
+public:
+    CachedFile(llvm::vfs::Status Status,
+               std::shared_ptr<const llvm::MemoryBuffer> Buffer);
+
+    llvm::ErrorOr<llvm::vfs::Status> status() override;
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+    getBuffer(const llvm::Twine &Name,
+              int64_t FileSize,
+              bool RequiresNullTerminator,
+              bool IsVolatile) override;
+
+    std::error_code close() override;
+
+private:
+    llvm::vfs::Status Status_;
+    std::shared_ptr<const llvm::MemoryBuffer> Buffer_;
+};
+
+CachedFile::CachedFile(llvm::vfs::Status Status,
+                       std::shared_ptr<const llvm::MemoryBuffer> Buffer)
+    : Status_(std::move(Status)), Buffer_(std::move(Buffer))
+{
+}
+
+llvm::ErrorOr<llvm::vfs::Status> CachedFile::status()
+{
+    return Status_;
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+CachedFile::getBuffer(const llvm::Twine &Name,
+                      int64_t FileSize,
+                      bool RequiresNullTerminator,
+                      bool IsVolatile)
+{
+    (void) FileSize;
+    (void) IsVolatile;
+
+    auto Data = Buffer_->getBuffer();
+
+    return llvm::MemoryBuffer::getMemBuffer(Data,
+                                            Name.str(),
+                                            RequiresNullTerminator);
+}
+
+std::error_code CachedFile::close()
+{
+    return std::error_code();
+}
+
+} // namespace
+
+namespace util {
+
+std::optional<llvm::ErrorOr<llvm::vfs::Status>>
+FileCache::getStatus(llvm::StringRef Path) const
+{
+    auto Lock = std::shared_lock(Mutex_);
+
+    auto It = Entries_.find(Path);
+    if (It == Entries_.end())
+        return std::nullopt;
+
+    return It->second.Status;
+}
+
+void FileCache::setStatus(llvm::StringRef Path,
+                          llvm::ErrorOr<llvm::vfs::Status> Status)
+{
+    auto Lock = std::unique_lock(Mutex_);
+
+    auto [It, Inserted] = Entries_.try_emplace(Path);
+    auto &Entry = It->second;
+
+    /* Cached contents of a modified file are stale */
+    if (!Inserted && !isUnchanged(Entry.Status, Status))
+        Entry.Buffer.reset();
+
+    Entry.Status = std::move(Status);
+}
+
+std::shared_ptr<const llvm::MemoryBuffer>
+FileCache::getBuffer(llvm::StringRef Path) const
+{
+    auto Lock = std::shared_lock(Mutex_);
+
+    auto It = Entries_.find(Path);
+    if (It == Entries_.end())
+        return nullptr;
+
+    return It->second.Buffer;
+}
+
+void FileCache::setBuffer(llvm::StringRef Path,
+                          std::shared_ptr<const llvm::MemoryBuffer> Buffer)
+{
+    auto Lock = std::unique_lock(Mutex_);
+
+    Entries_[Path].Buffer = std::move(Buffer);
+}
+
+void FileCache::erase(llvm::StringRef Path)
+{
+    auto Lock = std::unique_lock(Mutex_);
+
+    Entries_.erase(Path);
+}
+
+CachingFileSystem::CachingFileSystem(
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+    std::shared_ptr<FileCache> Cache,
+    bool Revalidate)
+    : ProxyFileSystem(std::move(FS)),
+      Cache_(std::move(Cache)),
+      Revalidate_(Revalidate)
+{
+}
+
+llvm::ErrorOr<llvm::vfs::Status>
+CachingFileSystem::status(const llvm::Twine &Path)
+{
+    auto &Counters = Cache_->getCounters();
+    llvm::SmallString<256> Key;
+
+    if (!makeKey(Path, Key))
+        return ProxyFileSystem::status(Path);
+
+    auto Cached = Cache_->getStatus(Key);
+
+    if (Cached && !Revalidate_) {
+        ++Counters.StatusHits;
+
+        if (!*Cached)
+            return Cached->getError();
+
+        return llvm::vfs::Status::copyWithNewName(**Cached, Path);
+    }
+
+    auto Status = ProxyFileSystem::status(Path);
+
+    if (Cached && isUnchanged(*Cached, Status))
+        ++Counters.StatusHits;
+    else
+        ++Counters.StatusMisses;
+
+    Cache_->setStatus(Key, Status);
+
+    return Status;
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+CachingFileSystem::openFileForRead(const llvm::Twine &Path)
+{
+    auto &Counters = Cache_->getCounters();
+    llvm::SmallString<256> Key;
+
+    if (!makeKey(Path, Key))
+        return ProxyFileSystem::openFileForRead(Path);
+
+    /* Also takes care of the revalidation of cached contents */
+    auto Status = status(Path);
+    if (!Status)
+        return Status.getError();
+
+    if (!Status->isRegularFile())
+        return ProxyFileSystem::openFileForRead(Path);
+
+    if (auto Buffer = Cache_->getBuffer(Key)) {
+        ++Counters.ReadHits;
+
+        return std::make_unique<CachedFile>(*Status, std::move(Buffer));
+    }
+
+    ++Counters.ReadMisses;
+
+    auto File = ProxyFileSystem::openFileForRead(Path);
+    if (!File)
+        return File.getError();
+
+    /*
+     * Read volatile files into memory instead of mapping them, as mapped
+     * files which get modified later on would change the cached contents.
+     */
+    auto Size = static_cast<int64_t>(Status->getSize());
+    auto Buffer = (*File)->getBuffer(Path, Size, true, true);
+    if (!Buffer)
+        return Buffer.getError();
+
+    auto Shared = std::shared_ptr<const llvm::MemoryBuffer>(std::move(*Buffer));
+
+    Cache_->setBuffer(Key, Shared);
+
+    return std::make_unique<CachedFile>(*Status, std::move(Shared));
+}
+
+bool CachingFileSystem::makeKey(const llvm::Twine &Path,
+                                llvm::SmallVectorImpl<char> &Key) const
+{
+    Path.toVector(Key);
+
+    /*
+     * The same file might be referred to by differently spelled paths.
+     * Only remove "." components as removing ".." is not safe in the
+     * presence of symbolic links.
+     */
+    if (makeAbsolute(Key))
+        return false;
+
+    llvm::sys::path::remove_dots(Key, false);
+
+    return true;
+}
+
+} /* namespace util */
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILECACHE_HPP_
+#define FILECACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+namespace util {
+
+/*
+ * Thread-safe cache of file status information and file contents which
+ * is shared by all file systems of a run. Failed lookups get cached as
+ * well, as header searches probe lots of non-existing paths.
+ */
+
+class FileCache {
+public:
+    struct Counters {
+    public:
+        std::atomic<uint64_t> StatusHits = 0;
+        std::atomic<uint64_t> StatusMisses = 0;
+        std::atomic<uint64_t> ReadHits = 0;
+        std::atomic<uint64_t> ReadMisses = 0;
+    };
+
+    FileCache() = default;
+
+    std::optional<llvm::ErrorOr<llvm::vfs::Status>>
+    getStatus(llvm::StringRef Path) const;
+    void setStatus(llvm::StringRef Path,
+                   llvm::ErrorOr<llvm::vfs::Status> Status);
+
+    std::shared_ptr<const llvm::MemoryBuffer>
+    getBuffer(llvm::StringRef Path) const;
+    void setBuffer(llvm::StringRef Path,
+                   std::shared_ptr<const llvm::MemoryBuffer> Buffer);
+
+    void erase(llvm::StringRef Path);
+
+    inline Counters &getCounters();
+    inline const Counters &getCounters() const;
+
+private:
+    struct Entry {
+    public:
+        llvm::ErrorOr<llvm::vfs::Status> Status = std::error_code();
+        std::shared_ptr<const llvm::MemoryBuffer> Buffer;
+    };
+
+    mutable std::shared_mutex Mutex_;
+    llvm::StringMap<Entry> Entries_;
+    Counters Counters_;
+};
+
+inline FileCache::Counters &FileCache::getCounters()
+{
+    return Counters_;
+}
+
+inline const FileCache::Counters &FileCache::getCounters() const
+{
+    return Counters_;
+}
+
+/*
+ * File system which serves status information and file contents from a
+ * shared "FileCache" and only falls back to the underlying file system on
+ * cache misses. With revalidation enabled, every lookup still queries the
+ * status of a file and drops cached contents of modified files.
+ */
+
+class CachingFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+    CachingFileSystem(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+                      std::shared_ptr<FileCache> Cache,
+                      bool Revalidate);
+
+    llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine &Path) override;
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(const llvm::Twine &Path) override;
+
+private:
+    bool makeKey(const llvm::Twine &Path,
+                 llvm::SmallVectorImpl<char> &Key) const;
+
+    std::shared_ptr<FileCache> Cache_;
+    bool Revalidate_;
+};
+
+} /* namespace util */
+
+#endif /* FILECACHE_HPP_ */
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileSystem.hpp"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace {
+
+bool hasContent(llvm::StringRef Path,
+                const llvm::sys::fs::file_status &Status,
+                llvm::StringRef Content)
+{
+    /* Comparing the sizes first avoids reading most changed files */
+    if (Status.type() != llvm::sys::fs::file_type::regular_file
+        || Status.getSize() != Content.size())
+        return false;
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Path, false, false);
+    if (!MemBuffer)
+        return false;
+
+    return MemBuffer.get()->getBuffer() == Content;
+}
+
+} // namespace
+
+namespace util {
+namespace fs {
+
+bool writeIfChanged(llvm::StringRef Path,
+                    llvm::StringRef Content,
+                    std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+    llvm::sys::fs::file_status Status;
+    llvm::SmallString<128> Temporary;
+    std::error_code Code;
+    int FD;
+
+    auto Exists = !llvm::sys::fs::status(Path, Status);
+    if (Exists && hasContent(Path, Status, Content))
+        return false;
+
+    /* Output directories of batch jobs might not exist yet */
+    auto Directory = llvm::sys::path::parent_path(Path);
+    if (!Directory.empty()) {
+        Code = llvm::sys::fs::create_directories(Directory);
+        if (Code) {
+            OS << "failed to create \"" << Directory
+               << "\": " << Code.message();
+            return false;
+        }
+    }
+
+    auto Model = Path.str() + ".%%%%%%.tmp";
+
+    Code = llvm::sys::fs::createUniqueFile(Model, FD, Temporary);
+    if (Code) {
+        OS << "failed to create \"" << Model << "\": " << Code.message();
+        return false;
+    }
+
+    {
+        auto Out = llvm::raw_fd_ostream(FD, true);
+        Out << Content;
+        Out.close();
+
+        if (Out.has_error()) {
+            OS << "failed to write \"" << Temporary
+               << "\": " << Out.error().message();
+            Out.clear_error();
+            (void) llvm::sys::fs::remove(Temporary);
+            return false;
+        }
+    }
+
+    /* The replaced file keeps its permissions */
+    if (Exists)
+        (void) llvm::sys::fs::setPermissions(Temporary, Status.permissions());
+
+    Code = llvm::sys::fs::rename(Temporary, Path);
+    if (Code) {
+        OS << "failed to rename \"" << Temporary << "\": " << Code.message();
+        (void) llvm::sys::fs::remove(Temporary);
+        return false;
+    }
+
+    return true;
+}
+
+} /* namespace fs */
+} /* namespace util */
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILESYSTEM_HPP_
+#define FILESYSTEM_HPP_
+
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+
+namespace util {
+namespace fs {
+
+/*
+ * Writes "Content" to the file at "Path" unless the file already holds
+ * exactly this content. Unchanged files keep their modification time, so
+ * build systems do not rebuild anything depending on them. Changed files
+ * are replaced by renaming a temporary file, so readers never see a
+ * partially written file. Returns whether the file was written.
+ */
+bool writeIfChanged(llvm::StringRef Path,
+                    llvm::StringRef Content,
+                    std::string &Error);
+
+} /* namespace fs */
+} /* namespace util */
+
+#endif /* FILESYSTEM_HPP_ */
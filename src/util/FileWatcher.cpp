@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FileWatcher.hpp"
+
+#include <array>
+#include <cerrno>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace util {
+
+FileWatcher::FileWatcher()
+    : Handle_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      Errno_((Handle_ < 0) ? errno : 0),
+      Directories_(),
+      Watches_(),
+      Files_()
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (Handle_ >= 0)
+        ::close(Handle_);
+}
+
+void FileWatcher::add(llvm::StringRef File, std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+
+    if (Handle_ < 0) {
+        OS << "failed to initialize inotify: "
+           << std::error_code(Errno_, std::generic_category()).message();
+        return;
+    }
+
+    if (!Files_.insert(File).second)
+        return;
+
+    /* Files of the same directory share a single watch */
+    auto Directory = llvm::sys::path::parent_path(File);
+    if (Directory.empty() || Watches_.count(Directory))
+        return;
+
+    constexpr uint32_t Mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+        | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+    auto Item = Directory.str();
+
+    int Watch = ::inotify_add_watch(Handle_, Item.c_str(), Mask);
+    if (Watch < 0) {
+        /* Try again with the next file of this directory */
+        Files_.erase(File);
+
+        OS << "failed to watch \"" << Item << "\": "
+           << std::error_code(errno, std::generic_category()).message();
+        return;
+    }
+
+    Watches_[Item] = Watch;
+    Directories_[Watch] = std::move(Item);
+}
+
+std::vector<std::string> FileWatcher::wait(std::chrono::milliseconds Delay,
+                                           std::string &Error)
+{
+    llvm::StringSet<> Changed;
+
+    /* Block until the first watched file gets modified */
+    while (Changed.empty()) {
+        if (!read(-1, Changed, Error))
+            return std::vector<std::string>();
+    }
+
+    /*
+     * Saving a file often results in a burst of events, sometimes spread
+     * over multiple files. Only report the changes after the watched
+     * directories did not change for the given delay.
+     */
+    while (read(static_cast<int>(Delay.count()), Changed, Error))
+        ;
+
+    auto Files = std::vector<std::string>();
+    Files.reserve(Changed.size());
+
+    for (const auto &Item : Changed)
+        Files.push_back(Item.getKey().str());
+
+    llvm::sort(Files);
+
+    return Files;
+}
+
+bool FileWatcher::read(int Timeout,
+                       llvm::StringSet<> &Changed,
+                       std::string &Error)
+{
+    llvm::raw_string_ostream OS(Error);
+
+    if (Handle_ < 0) {
+        OS << "failed to initialize inotify: "
+           << std::error_code(Errno_, std::generic_category()).message();
+        return false;
+    }
+
+    auto File = pollfd{Handle_, POLLIN, 0};
+
+    int Count = ::poll(&File, 1, Timeout);
+    if (Count < 0 && errno == EINTR)
+        return true;
+
+    if (Count < 0) {
+        OS << "failed to wait for file events: "
+           << std::error_code(errno, std::generic_category()).message();
+        return false;
+    }
+
+    if (Count == 0)
+        return false;
+
+    alignas(inotify_event) std::array<char, 4096> Buffer;
+
+    auto Size = ::read(Handle_, Buffer.data(), Buffer.size());
+    if (Size < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return true;
+
+        OS << "failed to read file events: "
+           << std::error_code(errno, std::generic_category()).message();
+        return false;
+    }
+
+    for (ssize_t i = 0; i < Size;) {
+        const auto *Event = reinterpret_cast<inotify_event *>(&Buffer[i]);
+        i += sizeof(*Event) + Event->len;
+
+        /* Events got lost, so any watched file might have changed */
+        if (Event->mask & IN_Q_OVERFLOW) {
+            for (const auto &Item : Files_)
+                Changed.insert(Item.getKey());
+
+            continue;
+        }
+
+        auto It = Directories_.find(Event->wd);
+        if (It == Directories_.end())
+            continue;
+
+        /*
+         * The directory is gone. Its files are reported as changed and
+         * must be added again to watch the recreated directory.
+         */
+        if (Event->mask & IN_IGNORED) {
+            auto Directory = std::move(It->second);
+
+            Watches_.erase(Directory);
+            Directories_.erase(It);
+
+            auto Files = std::vector<llvm::StringRef>();
+            for (const auto &Item : Files_) {
+                if (llvm::sys::path::parent_path(Item.getKey()) == Directory)
+                    Files.push_back(Item.getKey());
+            }
+
+            for (auto File : Files) {
+                Changed.insert(File);
+                Files_.erase(File);
+            }
+
+            continue;
+        }
+
+        if (Event->len == 0)
+            continue;
+
+        auto Path = It->second + "/" + Event->name;
+        if (Files_.count(Path))
+            Changed.insert(Path);
+    }
+
+    return true;
+}
+
+} /* namespace util */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILEWATCHER_HPP_
+#define FILEWATCHER_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+
+namespace util {
+
+/*
+ * Reports modifications of a set of files based on inotify. The parent
+ * directories of the files get watched instead of the files themselves,
+ * as many editors save a file by replacing it with a new one.
+ */
+
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &Other) = delete;
+    FileWatcher &operator=(const FileWatcher &Other) = delete;
+
+    void add(llvm::StringRef File, std::string &Error);
+
+    std::vector<std::string> wait(std::chrono::milliseconds Delay,
+                                  std::string &Error);
+
+private:
+    bool read(int Timeout, llvm::StringSet<> &Changed, std::string &Error);
+
+    int Handle_;
+    int Errno_;
+    llvm::DenseMap<int, std::string> Directories_;
+    llvm::StringMap<int> Watches_;
+    llvm::StringSet<> Files_;
+};
+
+} /* namespace util */
+
+#endif /* FILEWATCHER_HPP_ */
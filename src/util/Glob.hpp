@@ -18,8 +18,15 @@
 #ifndef GLOB_HPP_
 #define GLOB_HPP_
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/GlobPattern.h>
 
 namespace util {
 namespace glob {
@@ -31,6 +38,66 @@ static inline bool isPattern(llvm::StringRef Str)
     return llvm::any_of(Str, Pred);
 }
 
+/*
+ * Matches strings against a list of entries. Entries without any glob
+ * meta characters are looked up directly, all other entries are
+ * compiled to glob patterns.
+ */
+class Matcher {
+public:
+    Matcher() = default;
+
+    inline llvm::Error add(llvm::StringRef Entry);
+
+    inline bool empty() const;
+    inline bool contains(llvm::StringRef Str) const;
+    inline std::optional<llvm::StringRef> match(llvm::StringRef Str) const;
+
+private:
+    llvm::StringSet<> Strings_;
+    std::vector<std::pair<std::string, llvm::GlobPattern>> Globs_;
+};
+
+inline llvm::Error Matcher::add(llvm::StringRef Entry)
+{
+    if (!isPattern(Entry)) {
+        Strings_.insert(Entry);
+        return llvm::Error::success();
+    }
+
+    auto ExpectedGlob = llvm::GlobPattern::create(Entry);
+    if (!ExpectedGlob)
+        return ExpectedGlob.takeError();
+
+    Globs_.emplace_back(Entry.str(), std::move(*ExpectedGlob));
+
+    return llvm::Error::success();
+}
+
+inline bool Matcher::empty() const
+{
+    return Strings_.empty() && Globs_.empty();
+}
+
+/* Only looks up the entries without any glob meta characters */
+inline bool Matcher::contains(llvm::StringRef Str) const
+{
+    return Strings_.count(Str);
+}
+
+inline std::optional<llvm::StringRef> Matcher::match(llvm::StringRef Str) const
+{
+    if (auto It = Strings_.find(Str); It != Strings_.end())
+        return It->getKey();
+
+    for (const auto &[Pattern, Glob] : Globs_) {
+        if (Glob.match(Str))
+            return llvm::StringRef(Pattern);
+    }
+
+    return std::nullopt;
+}
+
 } /* namespace glob */
 } /* namespace util */
 
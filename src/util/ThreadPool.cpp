@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ThreadPool.hpp"
+
+#include <thread>
+
+namespace util {
+
+ThreadPool::ThreadPool(unsigned int Size) : Queues_()
+{
+    if (Size == 0)
+        Size = std::max(std::thread::hardware_concurrency(), 1u);
+
+    Queues_.reserve(Size);
+
+    for (unsigned int i = 0; i < Size; ++i)
+        Queues_.push_back(std::make_unique<Queue>());
+}
+
+void ThreadPool::run(
+    llvm::ArrayRef<size_t> Items,
+    llvm::function_ref<void(size_t Item, unsigned int Worker)> Func)
+{
+    /* Nothing to gain from additional threads, keep everything serial */
+    if (Queues_.size() == 1 || Items.size() <= 1) {
+        for (auto Item : Items)
+            Func(Item, 0);
+
+        return;
+    }
+
+    /*
+     * Distribute the items round-robin. This way each worker starts with
+     * the items which come first in the given order.
+     */
+    for (size_t i = 0, Size = Items.size(); i < Size; ++i)
+        Queues_[i % Queues_.size()]->Items.push_back(Items[i]);
+
+    auto Count = std::min<size_t>(Queues_.size(), Items.size());
+
+    std::vector<std::thread> Threads;
+    Threads.reserve(Count);
+
+    for (unsigned int i = 0; i < Count; ++i)
+        Threads.emplace_back([this, i, Func]() { work(i, Func); });
+
+    for (auto &Thread : Threads)
+        Thread.join();
+}
+
+void ThreadPool::work(unsigned int Worker,
+                      llvm::function_ref<void(size_t, unsigned int)> Func)
+{
+    size_t Item;
+
+    /*
+     * No new items get added while the workers are running. So if there
+     * is nothing left to steal, all work has been handed out.
+     */
+    while (pop(Worker, Item) || steal(Worker, Item))
+        Func(Item, Worker);
+}
+
+bool ThreadPool::pop(unsigned int Worker, size_t &Item)
+{
+    auto &Queue = *Queues_[Worker];
+    auto Lock = std::lock_guard(Queue.Mutex);
+
+    if (Queue.Items.empty())
+        return false;
+
+    Item = Queue.Items.front();
+    Queue.Items.pop_front();
+
+    return true;
+}
+
+bool ThreadPool::steal(unsigned int Worker, size_t &Item)
+{
+    for (size_t i = 1, Size = Queues_.size(); i < Size; ++i) {
+        auto &Queue = *Queues_[(Worker + i) % Size];
+        auto Lock = std::lock_guard(Queue.Mutex);
+
+        if (Queue.Items.empty())
+            continue;
+
+        Item = Queue.Items.back();
+        Queue.Items.pop_back();
+
+        return true;
+    }
+
+    return false;
+}
+
+} /* namespace util */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREADPOOL_HPP_
+#define THREADPOOL_HPP_
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/STLExtras.h>
+
+namespace util {
+
+/*
+ * Work-stealing thread pool for a fixed set of work items. Every worker
+ * owns a queue and processes its items front to back. Workers running
+ * out of items steal from the back of the queues of other workers.
+ */
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int Size);
+
+    inline unsigned int size() const;
+
+    void run(llvm::ArrayRef<size_t> Items,
+             llvm::function_ref<void(size_t Item, unsigned int Worker)> Func);
+
+private:
+    struct Queue {
+    public:
+        std::mutex Mutex;
+        std::deque<size_t> Items;
+    };
+
+    void work(unsigned int Worker,
+              llvm::function_ref<void(size_t, unsigned int)> Func);
+
+    bool pop(unsigned int Worker, size_t &Item);
+    bool steal(unsigned int Worker, size_t &Item);
+
+    std::vector<std::unique_ptr<Queue>> Queues_;
+};
+
+inline unsigned int ThreadPool::size() const
+{
+    return Queues_.size();
+}
+
+} /* namespace util */
+
+#endif /* THREADPOOL_HPP_ */
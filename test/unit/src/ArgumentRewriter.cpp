@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ArgumentRewriter.hpp"
+
+using Args = std::vector<std::string>;
+
+TEST(ArgumentRewriter, ExactAndPattern)
+{
+    auto Rewriter = ArgumentRewriter();
+    ASSERT_FALSE(Rewriter.add("-pipe"));
+    ASSERT_FALSE(Rewriter.add("-g*"));
+
+    auto Result = Rewriter.rewrite({"cc", "-g3", "-pipe", "-c", "a.c"});
+
+    ASSERT_EQ(Result, Args({"cc", "-c", "a.c"}));
+}
+
+TEST(ArgumentRewriter, Values)
+{
+    auto Rewriter = ArgumentRewriter();
+    ASSERT_FALSE(Rewriter.add("-Xlinker", 1));
+
+    auto Removals = std::vector<ArgumentRewriter::Removal>();
+    auto Result = Rewriter.rewrite(
+        {"cc", "-Xlinker", "-z", "-O2", "a.c", "-Xlinker"}, &Removals);
+
+    ASSERT_EQ(Result, Args({"cc", "-O2", "a.c"}));
+    ASSERT_EQ(Removals.size(), 2u);
+    ASSERT_EQ(Removals[0].Arguments, Args({"-Xlinker", "-z"}));
+    ASSERT_EQ(Removals[0].Rule, "-Xlinker");
+    ASSERT_EQ(Removals[1].Arguments, Args({"-Xlinker"}));
+}
+
+TEST(ArgumentRewriter, KeepsProgramAndInputs)
+{
+    auto Rewriter = ArgumentRewriter();
+    ASSERT_FALSE(Rewriter.add("-*"));
+
+    auto Result = Rewriter.rewrite({"-cc", "-c", "--", "-a.c"});
+
+    ASSERT_EQ(Result, Args({"-cc", "--", "-a.c"}));
+}
+
+TEST(ArgumentRewriter, SyntaxOnlyProfile)
+{
+    const auto &Profile = ArgumentRewriter::getSyntaxOnlyProfile();
+
+    auto Result = Profile.rewrite({"clang",
+                                   "-g3",
+                                   "-flto=thin",
+                                   "--coverage",
+                                   "-fcoverage-mapping",
+                                   "-O3",
+                                   "-Werror",
+                                   "-Werror=format",
+                                   "-Wall",
+                                   "-Wp,-DNDEBUG",
+                                   "-fpass-plugin=plugin.so",
+                                   "-L",
+                                   "lib",
+                                   "-lm",
+                                   "-Iinclude",
+                                   "-c",
+                                   "a.c"});
+
+    ASSERT_EQ(Result,
+              Args({"clang",
+                    "-O3",
+                    "-Wall",
+                    "-Wp,-DNDEBUG",
+                    "-Iinclude",
+                    "-c",
+                    "a.c"}));
+}
+
+TEST(ArgumentRewriter, SyntaxOnlyProfileKeepsFrontendFlags)
+{
+    const auto &Profile = ArgumentRewriter::getSyntaxOnlyProfile();
+
+    /* All of these change predefined macros, features or the parser */
+    auto Input = Args({"clang",
+                       "-fsanitize=address",
+                       "-fno-sanitize=undefined",
+                       "-fprofile-instr-generate",
+                       "-fprofile-use=a.profdata",
+                       "-fplugin=plugin.so",
+                       "-fplugin-arg-plugin-a",
+                       "-gcc-toolchain=/opt/gcc",
+                       "--gcc-toolchain=/opt/gcc",
+                       "-c",
+                       "a.c"});
+
+    ASSERT_EQ(Profile.rewrite(Input), Input);
+}
+
+TEST(ArgumentRewriter, InvalidPattern)
+{
+    auto Rewriter = ArgumentRewriter();
+
+    auto Error = Rewriter.add("-[");
+    ASSERT_TRUE(!!Error);
+
+    llvm::consumeError(std::move(Error));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
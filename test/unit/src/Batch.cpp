@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <llvm/ADT/StringSet.h>
+
+#include "Batch.hpp"
+
+namespace {
+
+Batch makeBatch(size_t Size)
+{
+    auto Batch = ::Batch();
+
+    for (size_t i = 0; i < Size; ++i) {
+        auto Item = Batch::Job();
+        Item.Input = "/src/file" + std::to_string(i) + ".c";
+
+        Batch.add(std::move(Item));
+    }
+
+    return Batch;
+}
+
+} // namespace
+
+TEST(Batch, ShardCoversAllJobs)
+{
+    constexpr size_t Size = 37;
+    constexpr unsigned int Count = 4;
+
+    auto Costs = std::vector<double>(Size);
+    for (size_t i = 0; i < Size; ++i)
+        Costs[i] = static_cast<double>((i * 7) % 11);
+
+    llvm::StringSet<> Inputs;
+    size_t Total = 0;
+
+    for (unsigned int Index = 0; Index < Count; ++Index) {
+        auto Batch = makeBatch(Size);
+        Batch.shard(Index, Count, Costs);
+
+        for (const auto &Item : Batch.getJobs())
+            ASSERT_TRUE(Inputs.insert(Item.Input.native()).second);
+
+        Total += Batch.size();
+    }
+
+    ASSERT_EQ(Total, Size);
+}
+
+TEST(Batch, ShardBalancesCosts)
+{
+    /* One expensive job and many cheap jobs */
+    auto Costs = std::vector<double>{ 10.0, 1.0, 1.0, 1.0, 1.0, 1.0,
+                                      1.0,  1.0, 1.0, 1.0, 1.0 };
+
+    auto First = makeBatch(Costs.size());
+    First.shard(0, 2, Costs);
+
+    auto Second = makeBatch(Costs.size());
+    Second.shard(1, 2, Costs);
+
+    ASSERT_EQ(First.size(), 1u);
+    ASSERT_EQ(First.getJobs().front().Input, "/src/file0.c");
+    ASSERT_EQ(Second.size(), 10u);
+}
+
+TEST(Batch, ShardKeepsOrder)
+{
+    auto Costs = std::vector<double>(8, 1.0);
+
+    auto Batch = makeBatch(Costs.size());
+    Batch.shard(0, 1, Costs);
+
+    auto Jobs = Batch.getJobs();
+    ASSERT_EQ(Jobs.size(), Costs.size());
+
+    for (size_t i = 0; i < Jobs.size(); ++i)
+        ASSERT_EQ(Jobs[i].Input, "/src/file" + std::to_string(i) + ".c");
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <clang/Tooling/JSONCompilationDatabase.h>
+
+#include "CompilationDatabase.hpp"
+
+namespace {
+
+std::unique_ptr<clang::tooling::CompilationDatabase>
+makeDatabase(llvm::StringRef Command)
+{
+    using namespace clang::tooling;
+
+    auto Buffer = std::string();
+    llvm::raw_string_ostream OS(Buffer);
+    std::string Error;
+
+    OS << "[{ \"directory\": \"/src\", \"file\": \"a.c\", \"command\": \""
+       << Command << "\" }]";
+
+    auto Database = JSONCompilationDatabase::loadFromBuffer(
+        OS.str(), Error, JSONCommandLineSyntax::Gnu);
+    EXPECT_TRUE(Database) << Error;
+
+    return Database;
+}
+
+std::string getParseKey(llvm::StringRef Command, llvm::StringRef File)
+{
+    auto Database = makeDatabase(Command);
+
+    return CompilationDatabase::getParseKey(*Database, File.str(), nullptr);
+}
+
+} // namespace
+
+TEST(CompilationDatabase, ParseKeyIgnoresCodeGeneration)
+{
+    auto Key = getParseKey("cc -c a.c", "/src/a.c");
+
+    ASSERT_EQ(getParseKey("cc -g3 -c a.c", "/src/a.c"), Key);
+    ASSERT_EQ(getParseKey("cc -flto -Wl,-z,now -c a.c", "/src/a.c"), Key);
+    ASSERT_EQ(getParseKey("cc -c a.c -L lib -lm", "/src/a.c"), Key);
+}
+
+TEST(CompilationDatabase, ParseKeyKeepsFrontendArguments)
+{
+    auto Key = getParseKey("cc -c a.c", "/src/a.c");
+
+    ASSERT_NE(getParseKey("cc -O2 -c a.c", "/src/a.c"), Key);
+    ASSERT_NE(getParseKey("cc -DNDEBUG -c a.c", "/src/a.c"), Key);
+    ASSERT_NE(getParseKey("cc -fsanitize=address -c a.c", "/src/a.c"), Key);
+
+    /* Different toolchains provide different headers */
+    ASSERT_NE(getParseKey("cc -gcc-toolchain=/opt/gcc -c a.c", "/src/a.c"),
+              Key);
+    ASSERT_NE(getParseKey("cc --gcc-install-dir=/opt/gcc -c a.c", "/src/a.c"),
+              Key);
+}
+
+TEST(CompilationDatabase, ParseKeyWithoutCommand)
+{
+    auto Database = makeDatabase("cc -c a.c");
+
+    auto A = CompilationDatabase::getParseKey(*Database, "/src/a.c", nullptr);
+    auto B = CompilationDatabase::getParseKey(*Database, "/src/b.c", nullptr);
+    auto C = CompilationDatabase::getParseKey(*Database, "/src/c.c", nullptr);
+
+    /* Files without a compile command are never parsed together */
+    ASSERT_NE(A, B);
+    ASSERT_NE(B, C);
+    ASSERT_FALSE(B.empty());
+}
+
+TEST(CompilationDatabase, ParseKeyAppliesAdjuster)
+{
+    auto Database = makeDatabase("cc -o a.o -c a.c");
+    auto Strip = clang::tooling::getClangStripOutputAdjuster();
+
+    auto A = CompilationDatabase::getParseKey(*Database, "/src/a.c", Strip);
+    auto B = getParseKey("cc -c a.c", "/src/a.c");
+
+    ASSERT_EQ(A, B);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "History.hpp"
+#include "TempDirectoryTest.hpp"
+
+namespace {
+
+using HistoryTest = TempDirectoryTest;
+
+} // namespace
+
+TEST(History, Lookup)
+{
+    auto History = ::History();
+
+    ASSERT_TRUE(History.empty());
+
+    History.insert("/src/a.c", {0x1234, 1.5, 0.25, 0});
+
+    ASSERT_EQ(History.size(), 1u);
+    ASSERT_TRUE(History.lookup("/src/a.c", 0x1234));
+    ASSERT_FALSE(History.lookup("/src/a.c", 0x4321));
+    ASSERT_FALSE(History.lookup("/src/b.c", 0x1234));
+}
+
+TEST_F(HistoryTest, SaveAndLoad)
+{
+    auto Path = getDirectory() / "history.json";
+    std::string Error;
+
+    auto History = ::History();
+    History.insert("/src/a.c",
+                   {0xfedcba9876543210, 1.5, 0.25, 1 << 20, 4 << 20});
+    History.insert("/src/b.c", {0x1, 0.5, 0.125, 0, 0});
+
+    History.save(Path, Error);
+    ASSERT_TRUE(Error.empty()) << Error;
+
+    auto Loaded = ::History();
+    Loaded.load(Path, Error);
+    ASSERT_TRUE(Error.empty()) << Error;
+
+    ASSERT_EQ(Loaded.size(), 2u);
+
+    const auto *Entry = Loaded.lookup("/src/a.c", 0xfedcba9876543210);
+    ASSERT_TRUE(Entry);
+    ASSERT_DOUBLE_EQ(Entry->ParseTime, 1.5);
+    ASSERT_DOUBLE_EQ(Entry->GenerateTime, 0.25);
+    ASSERT_EQ(Entry->Memory, 1u << 20);
+    ASSERT_EQ(Entry->Resident, 4u << 20);
+
+    Entry = Loaded.lookup("/src/b.c", 0x1);
+    ASSERT_TRUE(Entry);
+    ASSERT_EQ(Entry->Resident, 0u);
+}
+
+TEST(History, ResidentRatio)
+{
+    auto History = ::History();
+
+    ASSERT_DOUBLE_EQ(History.getResidentRatio(), 0.0);
+
+    History.insert("/src/a.c", {0x1, 1.0, 1.0, 1 << 20, 0});
+    ASSERT_DOUBLE_EQ(History.getResidentRatio(), 0.0);
+
+    History.insert("/src/b.c", {0x2, 1.0, 1.0, 1 << 20, 2 << 20});
+    History.insert("/src/c.c", {0x3, 1.0, 1.0, 3 << 20, 10 << 20});
+    ASSERT_DOUBLE_EQ(History.getResidentRatio(), 3.0);
+}
+
+TEST_F(HistoryTest, LoadMissingFile)
+{
+    auto Path = getDirectory() / "history.json";
+    std::string Error;
+
+    auto History = ::History();
+    History.load(Path, Error);
+
+    ASSERT_TRUE(Error.empty()) << Error;
+    ASSERT_TRUE(History.empty());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
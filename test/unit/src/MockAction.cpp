@@ -20,33 +20,74 @@
 
 #include <MockAction.hpp>
 
+#include "ModelCollector.hpp"
+#include "PreambleCache.hpp"
 #include "output/CMocka.hpp"
 #include "output/FFF.hpp"
 #include "output/GMock.hpp"
 #include "output/OutputGenerator.hpp"
 #include "output/Raw.hpp"
 
-OutputGenerator::OutputGenerator(std::shared_ptr<const Config> Config,
-                                 clang::PrintingPolicy Policy,
-                                 llvm::StringRef GeneratorName)
+ModelCollector::ModelCollector(std::shared_ptr<const Config> Config,
+                               std::optional<MockModel> *Model)
     : clang::ASTConsumer(),
-      ASTContext_(nullptr),
       Config_(std::move(Config)),
-      Writer_(Policy),
+      Model_(Model),
+      ASTContext_(nullptr),
+      Exprs_(),
       FunctionDecls_(),
       VarDecls_(),
+      Contexts_(),
+      Threads_(1),
+      Streamed_(false)
+{
+}
+
+void ModelCollector::Initialize(clang::ASTContext &Context)
+{
+    (void) Context;
+}
+
+bool ModelCollector::HandleTopLevelDecl(clang::DeclGroupRef Group)
+{
+    (void) Group;
+
+    return true;
+}
+
+void ModelCollector::HandleTranslationUnit(clang::ASTContext &Context)
+{
+    (void) Context;
+}
+
+bool ModelCollector::shouldSkipFunctionBody(clang::Decl *Decl)
+{
+    (void) Decl;
+
+    return false;
+}
+
+OutputGenerator::OutputGenerator(std::shared_ptr<const Config> Config,
+                                 llvm::StringRef GeneratorName)
+    : Model_(nullptr),
+      Config_(std::move(Config)),
+      Writer_(),
+      OutputStream_(&llvm::outs()),
+      Statistics_(nullptr),
+      Functions_(),
+      Variables_(),
       Name_(GeneratorName),
       AnyVariadic_(false)
 {
 }
 
-void OutputGenerator::HandleTranslationUnit(clang::ASTContext &Context)
+void OutputGenerator::generate(const MockModel &Model)
 {
-    (void) Context;
+    (void) Model;
 }
 
-GMock::GMock(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "GMock"), ContextMap_()
+GMock::GMock(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "GMock"), ContextMap_()
 {
 }
 
@@ -54,9 +95,8 @@ void GMock::run()
 {
 }
 
-CMocka::CMocka(std::shared_ptr<const Config> Config,
-               clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "CMocka")
+CMocka::CMocka(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "CMocka")
 {
 }
 
@@ -64,8 +104,8 @@ void CMocka::run()
 {
 }
 
-FFF::FFF(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "FFF")
+FFF::FFF(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "FFF")
 {
 }
 
@@ -73,9 +113,9 @@ void FFF::run()
 {
 }
 
-Raw::Raw(std::shared_ptr<const Config> Config, clang::PrintingPolicy Policy)
-    : OutputGenerator(std::move(Config), Policy, "Raw"),
-      CurrentAccess_(clang::AccessSpecifier::AS_none)
+Raw::Raw(std::shared_ptr<const Config> Config)
+    : OutputGenerator(std::move(Config), "Raw"),
+      CurrentAccess_(MockModel::Function::ACCESS_NONE)
 {
 }
 
@@ -83,6 +123,20 @@ void Raw::run()
 {
 }
 
+std::shared_ptr<const clang::PrecompiledPreamble> PreambleCache::configure(
+    clang::CompilerInvocation &Invocation,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> &FileSystem,
+    std::shared_ptr<clang::PCHContainerOperations> Operations,
+    std::unique_ptr<llvm::MemoryBuffer> &MainFile)
+{
+    (void) Invocation;
+    (void) FileSystem;
+    (void) Operations;
+    (void) MainFile;
+
+    return nullptr;
+}
+
 TEST(ActionFactory, Create)
 {
     auto Factory = MockActionFactory();
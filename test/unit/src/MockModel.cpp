@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "MockModel.hpp"
+
+namespace {
+
+MockModel makeModel()
+{
+    auto Model = MockModel();
+    Model.setCPlusPlus(true);
+
+    auto Namespace = MockModel::Context();
+    Namespace.Kind = MockModel::Context::KIND_NAMESPACE;
+    Namespace.Name = "ns";
+    Namespace.Parent = 0;
+
+    auto Class = MockModel::Context();
+    Class.Kind = MockModel::Context::KIND_CLASS;
+    Class.Name = "c";
+    Class.Parent = Model.addContext(std::move(Namespace));
+
+    auto Parameter = MockModel::Parameter();
+    Parameter.Name = "fn";
+    Parameter.Declarator.Head = "void (*";
+    Parameter.Declarator.Tail = ")(int)";
+    Parameter.Type.Spelling = "void (*)(int)";
+    Parameter.Type.CXXSpelling = "void (*)(int)";
+    Parameter.IsPointer = true;
+    Parameter.IsFunctionPointer = true;
+
+    auto Function = MockModel::Function();
+    Function.Kind = MockModel::Function::KIND_METHOD;
+    Function.Access = MockModel::Function::ACCESS_PROTECTED;
+    Function.RefQualifier = MockModel::Function::REFQUALIFIER_RVALUE;
+    Function.Name = "f";
+    Function.QualifiedName = "ns::c::f";
+    Function.MockName = "f";
+    Function.Declaration = "int f(void (*fn)(int)) const &&";
+    Function.ReturnType.Spelling = "int";
+    Function.ReturnType.CXXSpelling = "int";
+    Function.Parameters.push_back(std::move(Parameter));
+    Function.Context = Model.addContext(std::move(Class));
+    Function.IsConst = true;
+    Function.IsVariadic = true;
+
+    auto Variable = MockModel::Variable();
+    Variable.QualifiedName = "ns::v";
+    Variable.Declarator.Head = "struct s ";
+    Variable.CXXDeclarator.Head = "s ";
+
+    Model.addFunction(std::move(Function));
+    Model.addVariable(std::move(Variable));
+
+    return Model;
+}
+
+std::string writeModel(const MockModel &Model)
+{
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    Model.write(OS);
+
+    return OS.str();
+}
+
+} // namespace
+
+TEST(MockModel, RoundTrip)
+{
+    auto Data = writeModel(makeModel());
+    auto Model = MockModel();
+    std::string Error;
+
+    Model.read(Data, Error);
+    ASSERT_TRUE(Error.empty()) << Error;
+
+    ASSERT_TRUE(Model.isCPlusPlus());
+    ASSERT_EQ(Model.getContexts().size(), 3u);
+    ASSERT_EQ(Model.getFunctions().size(), 1u);
+    ASSERT_EQ(Model.getVariables().size(), 1u);
+
+    const auto &Function = Model.getFunctions().front();
+    ASSERT_EQ(Function.Kind, MockModel::Function::KIND_METHOD);
+    ASSERT_EQ(Function.Access, MockModel::Function::ACCESS_PROTECTED);
+    ASSERT_EQ(Function.RefQualifier, MockModel::Function::REFQUALIFIER_RVALUE);
+    ASSERT_EQ(Function.QualifiedName, "ns::c::f");
+    ASSERT_EQ(Function.Declaration, "int f(void (*fn)(int)) const &&");
+    ASSERT_TRUE(Function.IsConst);
+    ASSERT_TRUE(Function.IsVariadic);
+    ASSERT_FALSE(Function.ReturnsVoid);
+    ASSERT_EQ(Function.Parameters.size(), 1u);
+
+    const auto &Parameter = Function.Parameters.front();
+    ASSERT_EQ(Parameter.Name, "fn");
+    ASSERT_EQ(Parameter.Declarator.Head, "void (*");
+    ASSERT_EQ(Parameter.Declarator.Tail, ")(int)");
+    ASSERT_TRUE(Parameter.IsFunctionPointer);
+    ASSERT_FALSE(Parameter.IsOutput);
+
+    const auto &Context = Model.getContext(Function.Context);
+    ASSERT_EQ(Context.Kind, MockModel::Context::KIND_CLASS);
+    ASSERT_EQ(Context.Name, "c");
+    ASSERT_FALSE(Model.isGlobalContext(Context));
+
+    const auto *Parent = Model.getParent(Context);
+    ASSERT_NE(Parent, nullptr);
+    ASSERT_EQ(Parent->Name, "ns");
+    ASSERT_TRUE(Model.isGlobalContext(*Parent));
+
+    ASSERT_EQ(Model.getVariables().front().CXXDeclarator.Head, "s ");
+
+    /* Writing the read model again has to result in the same data */
+    ASSERT_EQ(writeModel(Model), Data);
+}
+
+TEST(MockModel, Truncated)
+{
+    auto Data = writeModel(makeModel());
+
+    for (size_t Size = 0; Size < Data.size(); ++Size) {
+        auto Model = MockModel();
+        std::string Error;
+
+        Model.read(llvm::StringRef(Data).take_front(Size), Error);
+        ASSERT_FALSE(Error.empty()) << Size;
+    }
+}
+
+TEST(MockModel, InvalidMagic)
+{
+    auto Data = writeModel(makeModel());
+    auto Model = makeModel();
+    std::string Error;
+
+    Data[0] = 'X';
+
+    Model.read(Data, Error);
+    ASSERT_FALSE(Error.empty());
+
+    /* The model is left untouched on errors */
+    ASSERT_EQ(Model.getFunctions().size(), 1u);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "ModelCollector.hpp"
+
+namespace {
+
+class CollectAction : public clang::ASTFrontendAction {
+public:
+    CollectAction(std::shared_ptr<const Config> Config,
+                  std::optional<MockModel> *Model,
+                  unsigned int Threads);
+
+protected:
+    std::unique_ptr<clang::ASTConsumer>
+    CreateASTConsumer(clang::CompilerInstance &CI,
+                      llvm::StringRef File) override;
+
+private:
+    std::shared_ptr<const Config> Config_;
+    std::optional<MockModel> *Model_;
+    unsigned int Threads_;
+};
+
+CollectAction::CollectAction(std::shared_ptr<const Config> Config,
+                             std::optional<MockModel> *Model,
+                             unsigned int Threads)
+    : clang::ASTFrontendAction(),
+      Config_(std::move(Config)),
+      Model_(Model),
+      Threads_(Threads)
+{
+}
+
+std::unique_ptr<clang::ASTConsumer>
+CollectAction::CreateASTConsumer(clang::CompilerInstance &CI,
+                                 llvm::StringRef File)
+{
+    (void) CI;
+    (void) File;
+
+    auto Collector = std::make_unique<ModelCollector>(Config_, Model_);
+    Collector->setThreads(Threads_);
+
+    return Collector;
+}
+
+std::optional<MockModel>
+collect(llvm::StringRef Code,
+        unsigned int Threads = 1,
+        const clang::tooling::FileContentMappings &Headers = {},
+        std::shared_ptr<const Config> Config = nullptr)
+{
+    if (!Config)
+        Config = std::make_shared<::Config>();
+
+    auto Model = std::optional<MockModel>();
+    auto Action = std::make_unique<CollectAction>(Config, &Model, Threads);
+
+    auto Result = clang::tooling::runToolOnCodeWithArgs(
+        std::move(Action),
+        Code,
+        {"-fsyntax-only"},
+        "input.c",
+        "clang-tool",
+        std::make_shared<clang::PCHContainerOperations>(),
+        Headers);
+    if (!Result)
+        return std::nullopt;
+
+    return Model;
+}
+
+std::string write(const std::optional<MockModel> &Model)
+{
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    if (Model)
+        Model->write(OS);
+
+    return OS.str();
+}
+
+std::vector<std::string> getNames(const std::optional<MockModel> &Model)
+{
+    auto Names = std::vector<std::string>();
+    if (!Model)
+        return Names;
+
+    for (const auto &Function : Model->getFunctions())
+        Names.push_back(Function.Name);
+
+    for (const auto &Variable : Model->getVariables())
+        Names.push_back(Variable.QualifiedName);
+
+    return Names;
+}
+
+std::string makeLargeFile()
+{
+    /*
+     * Each call records two expressions (the call and the reference to
+     * the callee), which exceeds the threshold for resolving the calls
+     * in parallel. New functions are used throughout all chunks while a
+     * few others get used again and again.
+     */
+    constexpr int Functions = 2048;
+    constexpr int Calls = 40000;
+
+    std::string Code;
+    llvm::raw_string_ostream OS(Code);
+
+    for (int i = 0; i < Functions; ++i)
+        OS << "int f" << i << "(int);\n";
+
+    for (int i = 0; i < 64; ++i)
+        OS << "extern int v" << i << ";\n";
+
+    OS << "int defined(int x) { return x; }\n"
+       << "int g(void)\n"
+       << "{\n"
+       << "    int x = 0;\n";
+
+    for (int i = 0; i < Calls; ++i) {
+        auto Index = (i % 2) ? (i * 7919) % 64 : (i / 20) % Functions;
+
+        OS << "    x += f" << Index << "(defined(x));\n";
+
+        if (i % 500 == 0)
+            OS << "    x += v" << (i / 500) % 64 << ";\n";
+    }
+
+    OS << "    return x;\n"
+       << "}\n";
+
+    return OS.str();
+}
+
+} // namespace
+
+TEST(ModelCollector, ParallelModelEqualsSerialModel)
+{
+    auto Code = makeLargeFile();
+
+    auto Serial = write(collect(Code, 1));
+    ASSERT_FALSE(Serial.empty());
+
+    ASSERT_EQ(write(collect(Code, 4)), Serial);
+}
+
+TEST(ModelCollector, InvalidBlacklist)
+{
+    auto Config = std::make_shared<::Config>();
+    Config->Mocking.Blacklist.push_back("f[");
+
+    /* The translation unit fails instead of terminating the process */
+    auto Model = collect("int f(void);\n"
+                         "int g(void) { return f(); }\n",
+                         1,
+                         {},
+                         Config);
+
+    ASSERT_FALSE(Model);
+}
+
+TEST(ModelCollector, SkipsHeaderDeclarations)
+{
+    auto Model = collect("#include \"header.h\"\n"
+                         "int g(void) { return f() + inlined(); }\n",
+                         1,
+                         {{"header.h",
+                           "int f(void);\n"
+                           "int hidden(void);\n"
+                           "extern int var;\n"
+                           "static inline int inlined(void)\n"
+                           "{\n"
+                           "    return hidden() + var;\n"
+                           "}\n"}});
+
+    /* Uses within declarations of a header don't need any mocks */
+    ASSERT_EQ(getNames(Model), std::vector<std::string>({"f"}));
+}
+
+TEST(ModelCollector, DeclarationEndingInMainFile)
+{
+    auto Model = collect("#include \"begin.h\"\n"
+                         "    return f() + var;\n"
+                         "}\n",
+                         1,
+                         {{"begin.h",
+                           "int f(void);\n"
+                           "extern int var;\n"
+                           "int g(void)\n"
+                           "{\n"}});
+
+    ASSERT_EQ(getNames(Model), std::vector<std::string>({"f", "var"}));
+}
+
+TEST(ModelCollector, DeclarationFromMacro)
+{
+    auto Model = collect("#include \"macro.h\"\n"
+                         "DEFINE_GETTER(get)\n",
+                         1,
+                         {{"macro.h",
+                           "int f(void);\n"
+                           "#define DEFINE_GETTER(name) \\\n"
+                           "    int name(void) { return f(); }\n"}});
+
+    /* Macro expansions belong to the file they are expanded in */
+    ASSERT_EQ(getNames(Model), std::vector<std::string>({"f"}));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
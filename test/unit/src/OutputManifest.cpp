@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "OutputManifest.hpp"
+#include "TempDirectoryTest.hpp"
+
+namespace {
+
+using OutputManifestTest = TempDirectoryTest;
+
+} // namespace
+
+TEST_F(OutputManifestTest, GetPath)
+{
+    auto Path = OutputManifest::getPath("mocks/a.inc");
+
+    ASSERT_EQ(Path, "mocks/.a.inc.ccmock-manifest.json");
+}
+
+TEST_F(OutputManifestTest, SaveAndLoad)
+{
+    auto Manifest = OutputManifest();
+    std::string Error;
+
+    auto A = writeFile("a.c", "#include \"a.h\"\n");
+    auto B = writeFile("a.h", "int a;\n");
+
+    Manifest.setKey("1234");
+    Manifest.setCommand({"cc", "-c", "a.c"});
+    Manifest.add(A, Error);
+    Manifest.add(B, Error);
+    ASSERT_TRUE(Error.empty());
+
+    auto Path = writeFile("manifest.json", "");
+    Manifest.save(Path, Error);
+    ASSERT_TRUE(Error.empty());
+
+    auto Loaded = OutputManifest();
+    Loaded.load(Path, Error);
+    ASSERT_TRUE(Error.empty());
+
+    ASSERT_EQ(Loaded.getKey(), "1234");
+    ASSERT_EQ(Loaded.getCommand().size(), 3u);
+    ASSERT_EQ(Loaded.getFiles().size(), 2u);
+    ASSERT_EQ(Loaded.getFiles()[1].Path, B);
+    ASSERT_EQ(Loaded.getFiles()[1].Size, 7u);
+    ASSERT_EQ(Loaded.getFiles()[1].Time, Manifest.getFiles()[1].Time);
+
+    ASSERT_TRUE(Loaded.isUpToDate("1234"));
+    ASSERT_FALSE(Loaded.isUpToDate("5678"));
+}
+
+TEST_F(OutputManifestTest, Modified)
+{
+    auto Manifest = OutputManifest();
+    std::string Error;
+
+    auto A = writeFile("a.h", "int a;\n");
+
+    Manifest.setKey("1234");
+    Manifest.add(A, Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_TRUE(Manifest.isUpToDate("1234"));
+
+    writeFile("a.h", "int a, b;\n");
+    ASSERT_FALSE(Manifest.isUpToDate("1234"));
+}
+
+TEST_F(OutputManifestTest, Removed)
+{
+    auto Manifest = OutputManifest();
+    std::string Error;
+
+    auto A = writeFile("a.h", "int a;\n");
+
+    Manifest.setKey("1234");
+    Manifest.add(A, Error);
+    ASSERT_TRUE(Error.empty());
+
+    (void) llvm::sys::fs::remove(A);
+    ASSERT_FALSE(Manifest.isUpToDate("1234"));
+}
+
+TEST_F(OutputManifestTest, Missing)
+{
+    auto Manifest = OutputManifest();
+    std::string Error;
+
+    Manifest.add(getPath("missing.h"), Error);
+    ASSERT_FALSE(Error.empty());
+
+    Error.clear();
+    Manifest.load(getPath("missing.json"), Error);
+    ASSERT_FALSE(Error.empty());
+    ASSERT_FALSE(Manifest.isUpToDate(""));
+}
+
+TEST_F(OutputManifestTest, OldVersion)
+{
+    auto Manifest = OutputManifest();
+    std::string Error;
+
+    /* Version 1 manifests did not record any system headers */
+    auto Path = writeFile("a.json", "{ \"key\": \"1234\", \"files\": [] }");
+
+    Manifest.load(Path, Error);
+    ASSERT_FALSE(Error.empty());
+    ASSERT_FALSE(Manifest.isUpToDate("1234"));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Tooling/JSONCompilationDatabase.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "MockAction.hpp"
+#include "PCHManager.hpp"
+#include "TempDirectoryTest.hpp"
+
+namespace {
+
+/*
+ * Writes the generated header instead of a real PCH, so the tests can
+ * check which include directives made it into the PCH.
+ */
+class HeaderCopyAction : public clang::PreprocessOnlyAction {
+public:
+    explicit HeaderCopyAction(std::string Output);
+
+protected:
+    void ExecuteAction() override;
+
+private:
+    std::string Output_;
+};
+
+HeaderCopyAction::HeaderCopyAction(std::string Output)
+    : clang::PreprocessOnlyAction(), Output_(std::move(Output))
+{
+}
+
+void HeaderCopyAction::ExecuteAction()
+{
+    auto &SourceManager = getCompilerInstance().getSourceManager();
+    std::error_code Code;
+
+    auto OS = llvm::raw_fd_ostream(Output_, Code);
+    OS << SourceManager.getBufferData(SourceManager.getMainFileID());
+}
+
+class PCHManagerTest : public TempDirectoryTest {
+protected:
+    void addCommand(llvm::StringRef File, llvm::StringRef Command);
+    clang::tooling::CommandLineArguments prepare(llvm::StringRef File);
+    std::string readPCH(const clang::tooling::CommandLineArguments &Args);
+
+    std::vector<std::string> Files_;
+    std::string Commands_;
+    clang::tooling::ArgumentsAdjuster Adjuster_;
+};
+
+void PCHManagerTest::addCommand(llvm::StringRef File, llvm::StringRef Command)
+{
+    Commands_ += Commands_.empty() ? "[" : ",";
+    Commands_ += "{ \"directory\": \"" + getDirectory().native()
+                 + "\", \"file\": \"" + File.str() + "\", \"command\": \""
+                 + Command.str() + "\" }";
+
+    Files_.push_back(getPath(File));
+}
+
+clang::tooling::CommandLineArguments
+PCHManagerTest::prepare(llvm::StringRef File)
+{
+    using namespace clang::tooling;
+
+    if (!Adjuster_) {
+        std::string Error;
+
+        auto Database = JSONCompilationDatabase::loadFromBuffer(
+            Commands_ + "]", Error, JSONCommandLineSyntax::Gnu);
+        EXPECT_TRUE(Database) << Error;
+
+        auto Batch = ::Batch();
+        for (const auto &Item : Files_)
+            Batch.add({Item, Item + ".hpp"});
+
+        auto Cache = std::make_shared<ResultCache>(getDirectory() / "cache",
+                                                   1024 * 1024);
+        auto Pool = util::ThreadPool(1);
+
+        auto Manager =
+            PCHManager(std::make_shared<Config>(), *Database, Cache);
+        Manager.prepare(Batch, Pool);
+
+        Adjuster_ = Manager.getArgumentsAdjuster();
+    }
+
+    return Adjuster_({"cc", "-c", File.str()}, getPath(File));
+}
+
+std::string
+PCHManagerTest::readPCH(const clang::tooling::CommandLineArguments &Args)
+{
+    EXPECT_GE(Args.size(), 3u);
+    EXPECT_EQ(Args[1], "-include-pch");
+
+    auto MemBuffer = llvm::MemoryBuffer::getFile(Args[2]);
+    EXPECT_TRUE(MemBuffer);
+
+    return MemBuffer ? MemBuffer.get()->getBuffer().str() : std::string();
+}
+
+} // namespace
+
+std::string MockActionFactory::getResourceDirectory(const Config &Config)
+{
+    (void) Config;
+
+    return std::string();
+}
+
+std::unique_ptr<clang::FrontendAction> PCHActionFactory::create()
+{
+    return std::make_unique<HeaderCopyAction>(OutputFile_);
+}
+
+TEST_F(PCHManagerTest, CommonIncludes)
+{
+    writeFile("common.h", "int common;\n");
+    writeFile("a.h", "int a;\n");
+    writeFile("b.h", "int b;\n");
+
+    writeFile("a.c",
+              "/*\n"
+              " * #include \"a.h\"\n"
+              " */\n"
+              "\n"
+              "#include \"common.h\" // Comment\n"
+              "#  include <stddef.h>\n"
+              "#include \"a.h\"\n"
+              "\n"
+              "int x;\n");
+    writeFile("b.c",
+              "#include \"common.h\"\n"
+              "#include <stddef.h>\n"
+              "#include \"b.h\"\n");
+    writeFile("c.c", "#include \"common.h\"\n");
+
+    addCommand("a.c", "cc -c a.c");
+    addCommand("b.c", "cc -c b.c");
+    addCommand("c.c", "cc -DC -c c.c");
+
+    auto Args = prepare("a.c");
+    auto Header = readPCH(Args);
+
+    /* Only the include directives both files start with are kept */
+    ASSERT_EQ(Header,
+              "#include \"" + getPath("common.h") + "\"\n"
+              "#include <stddef.h>\n");
+    ASSERT_EQ(prepare("b.c"), Args);
+
+    /* A PCH is not worth it for a single translation unit */
+    ASSERT_EQ(prepare("c.c"),
+              clang::tooling::CommandLineArguments({"cc", "-c", "c.c"}));
+}
+
+TEST_F(PCHManagerTest, IncludeSequenceEnd)
+{
+    writeFile("common.h", "int common;\n");
+    writeFile("a.h", "int a;\n");
+
+    auto Content = "#include \"common.h\"\n"
+                   "#define NDEBUG\n"
+                   "#include \"a.h\"\n";
+
+    writeFile("a.c", Content);
+    writeFile("b.c", Content);
+
+    addCommand("a.c", "cc -c a.c");
+    addCommand("b.c", "cc -c b.c");
+
+    auto Header = readPCH(prepare("a.c"));
+    ASSERT_EQ(Header, "#include \"" + getPath("common.h") + "\"\n");
+}
+
+TEST_F(PCHManagerTest, NoCommonIncludes)
+{
+    writeFile("a.h", "int a;\n");
+    writeFile("b.h", "int b;\n");
+    writeFile("a.c", "#include \"a.h\"\n");
+    writeFile("b.c", "#include \"b.h\"\n");
+
+    addCommand("a.c", "cc -c a.c");
+    addCommand("b.c", "cc -c b.c");
+
+    ASSERT_EQ(prepare("a.c"),
+              clang::tooling::CommandLineArguments({"cc", "-c", "a.c"}));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
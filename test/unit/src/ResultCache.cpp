@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+
+#include "ResultCache.hpp"
+#include "TempDirectoryTest.hpp"
+
+namespace {
+
+using ResultCacheTest = TempDirectoryTest;
+
+std::string makeKey(char Value)
+{
+    return std::string(40, Value);
+}
+
+} // namespace
+
+TEST_F(ResultCacheTest, StoreAndLookup)
+{
+    auto Cache = ResultCache(getDirectory(), 1024 * 1024);
+    auto Output = std::string();
+    auto Error = std::string();
+
+    ASSERT_FALSE(Cache.lookup(makeKey('a'), Output));
+
+    auto Content = std::string();
+    for (int i = 0; i < 100; ++i)
+        Content += "MOCK_METHOD(int, func, (int));\n";
+
+    Cache.store(makeKey('a'), Content, Error);
+    ASSERT_TRUE(Error.empty());
+
+    ASSERT_TRUE(Cache.lookup(makeKey('a'), Output));
+    ASSERT_EQ(Output, Content);
+    ASSERT_FALSE(Cache.lookup(makeKey('b'), Output));
+
+    const auto &Counters = Cache.getCounters();
+    ASSERT_EQ(Counters.Hits, 1u);
+    ASSERT_EQ(Counters.Misses, 2u);
+    ASSERT_EQ(Counters.Stores, 1u);
+}
+
+TEST_F(ResultCacheTest, EmptyOutput)
+{
+    auto Cache = ResultCache(getDirectory(), 1024 * 1024);
+    auto Output = std::string("stale");
+    auto Error = std::string();
+
+    Cache.store(makeKey('a'), "", Error);
+    ASSERT_TRUE(Error.empty());
+
+    ASSERT_TRUE(Cache.lookup(makeKey('a'), Output));
+    ASSERT_TRUE(Output.empty());
+}
+
+TEST_F(ResultCacheTest, Corrupted)
+{
+    auto Cache = ResultCache(getDirectory(), 1024 * 1024);
+    auto Output = std::string();
+    auto Error = std::string();
+
+    Cache.store(makeKey('a'), "int a;\n", Error);
+    ASSERT_TRUE(Error.empty());
+
+    auto Path = getDirectory() / "aa" / makeKey('a').substr(2);
+    std::filesystem::resize_file(Path, 3);
+
+    ASSERT_FALSE(Cache.lookup(makeKey('a'), Output));
+    ASSERT_FALSE(std::filesystem::exists(Path));
+}
+
+TEST_F(ResultCacheTest, StoreAndLookupFile)
+{
+    auto Cache = ResultCache(getDirectory(), 1024 * 1024);
+    auto Path = std::filesystem::path();
+    auto Error = std::string();
+
+    ASSERT_FALSE(Cache.lookupFile(makeKey('a'), Path));
+
+    Cache.storeFile(makeKey('a'), "CPCH", Error);
+    ASSERT_TRUE(Error.empty());
+
+    /* File entries are stored without any encoding */
+    ASSERT_TRUE(Cache.lookupFile(makeKey('a'), Path));
+    ASSERT_EQ(std::filesystem::file_size(Path), 4u);
+
+    const auto &Counters = Cache.getCounters();
+    ASSERT_EQ(Counters.Hits, 0u);
+    ASSERT_EQ(Counters.Misses, 0u);
+    ASSERT_EQ(Counters.Stores, 1u);
+}
+
+TEST_F(ResultCacheTest, FindFileKeepsModificationTime)
+{
+    auto Cache = ResultCache(getDirectory(), 1024 * 1024);
+    auto Path = std::filesystem::path();
+    auto Error = std::string();
+
+    ASSERT_FALSE(Cache.findFile(makeKey('a'), Path));
+
+    Cache.storeFile(makeKey('a'), "#include <stdio.h>\n", Error);
+    ASSERT_TRUE(Error.empty());
+
+    ASSERT_TRUE(Cache.findFile(makeKey('a'), Path));
+
+    auto Time = std::filesystem::last_write_time(Path) - std::chrono::hours(1);
+    std::filesystem::last_write_time(Path, Time);
+
+    ASSERT_TRUE(Cache.findFile(makeKey('a'), Path));
+    ASSERT_EQ(std::filesystem::last_write_time(Path), Time);
+
+    /* Looking up the entry marks it as recently used */
+    ASSERT_TRUE(Cache.lookupFile(makeKey('a'), Path));
+    ASSERT_GT(std::filesystem::last_write_time(Path), Time);
+}
+
+TEST_F(ResultCacheTest, Evict)
+{
+    /* Random data does not compress, so each entry takes > 1000 bytes */
+    auto Engine = std::mt19937();
+    auto Content = std::string(1000, '\0');
+    for (auto &Byte : Content)
+        Byte = static_cast<char>(Engine());
+
+    auto Cache = ResultCache(getDirectory(), 2500);
+    auto Output = std::string();
+    auto Error = std::string();
+
+    Cache.store(makeKey('a'), Content, Error);
+    Cache.store(makeKey('b'), Content, Error);
+    ASSERT_TRUE(Error.empty());
+
+    /* Make "a" the least recently used entry */
+    auto Path = getDirectory() / "aa" / makeKey('a').substr(2);
+    auto Time = std::filesystem::last_write_time(Path);
+    std::filesystem::last_write_time(Path, Time - std::chrono::hours(1));
+
+    auto Usage = Cache.evict(Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(Usage.Count, 2u);
+    ASSERT_EQ(Usage.Evictions, 0u);
+
+    Cache.store(makeKey('c'), Content, Error);
+    ASSERT_TRUE(Error.empty());
+
+    Usage = Cache.evict(Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(Usage.Count, 2u);
+    ASSERT_EQ(Usage.Evictions, 1u);
+    ASSERT_LE(Usage.Size, 2500u);
+
+    ASSERT_FALSE(Cache.lookup(makeKey('a'), Output));
+    ASSERT_TRUE(Cache.lookup(makeKey('b'), Output));
+    ASSERT_TRUE(Cache.lookup(makeKey('c'), Output));
+}
+
+TEST_F(ResultCacheTest, EvictMissingDirectory)
+{
+    auto Cache = ResultCache(getDirectory() / "missing", 1024);
+    auto Error = std::string();
+
+    auto Usage = Cache.evict(Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(Usage.Count, 0u);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
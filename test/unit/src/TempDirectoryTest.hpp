@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEMPDIRECTORYTEST_HPP_
+#define TEMPDIRECTORYTEST_HPP_
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+/*
+ * Test fixture providing a unique temporary directory for each test. The
+ * directory and everything created within it is removed after the test.
+ */
+
+class TempDirectoryTest : public testing::Test {
+protected:
+    void SetUp() override;
+    void TearDown() override;
+
+    std::filesystem::path getDirectory() const;
+    std::string getPath(llvm::StringRef Name) const;
+    std::string writeFile(llvm::StringRef Name, llvm::StringRef Content);
+
+    llvm::SmallString<128> Directory_;
+};
+
+inline void TempDirectoryTest::SetUp()
+{
+    auto Code = llvm::sys::fs::createUniqueDirectory("ccmock", Directory_);
+    ASSERT_FALSE(Code);
+
+    /* Tests compare paths reported by the operating system */
+    Code = llvm::sys::fs::real_path(Directory_, Directory_);
+    ASSERT_FALSE(Code);
+}
+
+inline void TempDirectoryTest::TearDown()
+{
+    (void) llvm::sys::fs::remove_directories(Directory_);
+}
+
+inline std::filesystem::path TempDirectoryTest::getDirectory() const
+{
+    return Directory_.str().str();
+}
+
+inline std::string TempDirectoryTest::getPath(llvm::StringRef Name) const
+{
+    return (Directory_ + "/" + Name).str();
+}
+
+inline std::string TempDirectoryTest::writeFile(llvm::StringRef Name,
+                                                llvm::StringRef Content)
+{
+    auto Path = getPath(Name);
+    std::error_code Code;
+
+    llvm::raw_fd_ostream OS(Path, Code);
+    EXPECT_FALSE(Code);
+
+    OS << Content;
+
+    return Path;
+}
+
+#endif /* TEMPDIRECTORYTEST_HPP_ */
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "output/OutputGenerator.hpp"
+#include "output/Raw.hpp"
+
+namespace {
+
+/* Functions given as "<namespace>::<name>(<parameter>)" */
+MockModel makeModel(llvm::ArrayRef<const char *> Functions)
+{
+    auto Model = MockModel();
+    Model.setCPlusPlus(true);
+
+    llvm::StringMap<uint32_t> Contexts;
+
+    for (llvm::StringRef Item : Functions) {
+        auto [Scope, Declaration] = Item.split("::");
+        auto [Name, Parameter] = Declaration.split('(');
+
+        auto Result = Contexts.try_emplace(Scope, 0);
+        if (Result.second) {
+            auto Context = MockModel::Context();
+            Context.Kind = MockModel::Context::KIND_NAMESPACE;
+            Context.Name = Scope.str();
+
+            Result.first->second = Model.addContext(std::move(Context));
+        }
+
+        auto Type = MockModel::Type();
+        Type.Spelling = Parameter.drop_back().str();
+        Type.CXXSpelling = Type.Spelling;
+
+        auto Param = MockModel::Parameter();
+        Param.Name = "arg1";
+        Param.Declarator.Head = Type.Spelling + " ";
+        Param.Type = std::move(Type);
+
+        auto Function = MockModel::Function();
+        Function.Name = Name.str();
+        Function.QualifiedName = (Scope + "::" + Name).str();
+        Function.MockName = Function.Name;
+        Function.Declaration = (Name + "(" + Parameter).str();
+        Function.ReturnType.Spelling = "void";
+        Function.ReturnType.CXXSpelling = "void";
+        Function.ReturnsVoid = true;
+        Function.Context = Result.first->second;
+        Function.Parameters.push_back(std::move(Param));
+
+        Model.addFunction(std::move(Function));
+    }
+
+    return Model;
+}
+
+std::string generate(const MockModel &Model, bool Reproducible)
+{
+    auto Config = std::make_shared<::Config>();
+    Config->General.BaseDirectory = "/src";
+    Config->General.Input = "/src/a.cpp";
+    Config->General.Reproducible = Reproducible;
+
+    std::string Buffer;
+    llvm::raw_string_ostream OS(Buffer);
+
+    auto Generator = Raw(Config);
+    Generator.setOutputStream(&OS);
+    Generator.generate(Model);
+
+    return OS.str();
+}
+
+} // namespace
+
+TEST(OutputGenerator, ReproducibleIgnoresOrderOfUses)
+{
+    auto First = makeModel({"b::g(int)", "a::f(int)", "a::e(int)"});
+    auto Second = makeModel({"a::e(int)", "a::f(int)", "b::g(int)"});
+
+    ASSERT_NE(generate(First, false), generate(Second, false));
+
+    auto Output = generate(First, true);
+    ASSERT_EQ(generate(Second, true), Output);
+
+    auto E = Output.find("e(int");
+    auto F = Output.find("f(int");
+    auto G = Output.find("g(int");
+
+    ASSERT_NE(G, std::string::npos);
+    ASSERT_LT(E, F);
+    ASSERT_LT(F, G);
+}
+
+TEST(OutputGenerator, ReproducibleKeepsOrderOfOverloads)
+{
+    auto Output = generate(makeModel({"a::f(int)", "a::f(long)"}), true);
+    ASSERT_LT(Output.find("f(int"), Output.find("f(long"));
+
+    Output = generate(makeModel({"a::f(long)", "a::f(int)"}), true);
+    ASSERT_LT(Output.find("f(long"), Output.find("f(int"));
+}
+
+TEST(OutputGenerator, ReproducibleFileHeader)
+{
+    auto Model = makeModel({"a::f(int)"});
+
+    auto Output = generate(Model, false);
+    ASSERT_NE(Output.find("Date"), std::string::npos);
+    ASSERT_NE(Output.find("Directory   : /src"), std::string::npos);
+
+    Output = generate(Model, true);
+    ASSERT_EQ(Output.find("Date"), std::string::npos);
+    ASSERT_EQ(Output.find("/src"), std::string::npos);
+    ASSERT_NE(Output.find("Input       : a.cpp"), std::string::npos);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
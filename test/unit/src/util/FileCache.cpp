@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "TempDirectoryTest.hpp"
+#include "util/FileCache.hpp"
+
+namespace {
+
+class FileCacheTest : public TempDirectoryTest {
+protected:
+    llvm::IntrusiveRefCntPtr<util::CachingFileSystem>
+    makeFileSystem(std::shared_ptr<util::FileCache> Cache, bool Revalidate)
+    {
+        auto FS = llvm::vfs::createPhysicalFileSystem();
+
+        return new util::CachingFileSystem(
+            llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(FS.release()),
+            std::move(Cache),
+            Revalidate);
+    }
+};
+
+std::string read(llvm::vfs::FileSystem &FS, llvm::StringRef Path)
+{
+    auto File = FS.openFileForRead(Path);
+    if (!File)
+        return std::string();
+
+    auto Buffer = (*File)->getBuffer(Path);
+    if (!Buffer)
+        return std::string();
+
+    return (*Buffer)->getBuffer().str();
+}
+
+} // namespace
+
+TEST_F(FileCacheTest, Status)
+{
+    auto Cache = std::make_shared<util::FileCache>();
+    auto FS = makeFileSystem(Cache, false);
+
+    auto Path = writeFile("a.h", "int a;\n");
+
+    ASSERT_TRUE(FS->status(Path));
+    ASSERT_TRUE(FS->status(Path));
+    ASSERT_FALSE(FS->status(Path + ".missing"));
+    ASSERT_FALSE(FS->status(Path + ".missing"));
+
+    const auto &Counters = Cache->getCounters();
+    ASSERT_EQ(Counters.StatusMisses, 2u);
+    ASSERT_EQ(Counters.StatusHits, 2u);
+}
+
+TEST_F(FileCacheTest, SharedContents)
+{
+    auto Cache = std::make_shared<util::FileCache>();
+    auto First = makeFileSystem(Cache, false);
+    auto Second = makeFileSystem(Cache, false);
+
+    auto Path = writeFile("a.h", "int a;\n");
+
+    ASSERT_EQ(read(*First, Path), "int a;\n");
+    ASSERT_EQ(read(*Second, Path), "int a;\n");
+
+    const auto &Counters = Cache->getCounters();
+    ASSERT_EQ(Counters.ReadMisses, 1u);
+    ASSERT_EQ(Counters.ReadHits, 1u);
+}
+
+TEST_F(FileCacheTest, Revalidate)
+{
+    auto Cache = std::make_shared<util::FileCache>();
+    auto FS = makeFileSystem(Cache, true);
+
+    auto Path = writeFile("a.h", "int a;\n");
+    ASSERT_EQ(read(*FS, Path), "int a;\n");
+
+    writeFile("a.h", "int a, b;\n");
+    ASSERT_EQ(read(*FS, Path), "int a, b;\n");
+
+    const auto &Counters = Cache->getCounters();
+    ASSERT_EQ(Counters.ReadMisses, 2u);
+    ASSERT_EQ(Counters.ReadHits, 0u);
+}
+
+TEST_F(FileCacheTest, Erase)
+{
+    auto Cache = std::make_shared<util::FileCache>();
+    auto FS = makeFileSystem(Cache, false);
+
+    auto Path = writeFile("a.h", "int a;\n");
+    ASSERT_EQ(read(*FS, Path), "int a;\n");
+
+    writeFile("a.h", "int a, b;\n");
+    ASSERT_EQ(read(*FS, Path), "int a;\n");
+
+    Cache->erase(Path);
+    ASSERT_EQ(read(*FS, Path), "int a, b;\n");
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
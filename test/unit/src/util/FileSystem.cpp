@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "TempDirectoryTest.hpp"
+#include "util/FileSystem.hpp"
+
+namespace {
+
+class FileSystemTest : public TempDirectoryTest {
+protected:
+    static std::string readFile(llvm::StringRef Path)
+    {
+        auto MemBuffer = llvm::MemoryBuffer::getFile(Path);
+        if (!MemBuffer)
+            return std::string();
+
+        return MemBuffer.get()->getBuffer().str();
+    }
+
+    static llvm::sys::fs::UniqueID getID(llvm::StringRef Path)
+    {
+        llvm::sys::fs::UniqueID ID;
+
+        EXPECT_FALSE(llvm::sys::fs::getUniqueID(Path, ID));
+
+        return ID;
+    }
+};
+
+} // namespace
+
+TEST_F(FileSystemTest, WriteNewFile)
+{
+    auto Path = getPath("mocks/a.inc");
+    std::string Error;
+
+    ASSERT_TRUE(util::fs::writeIfChanged(Path, "int a;\n", Error));
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(readFile(Path), "int a;\n");
+}
+
+TEST_F(FileSystemTest, KeepUnchangedFile)
+{
+    auto Path = getPath("a.inc");
+    std::string Error;
+
+    ASSERT_TRUE(util::fs::writeIfChanged(Path, "int a;\n", Error));
+
+    auto ID = getID(Path);
+
+    /* A replaced file would get a new inode */
+    ASSERT_FALSE(util::fs::writeIfChanged(Path, "int a;\n", Error));
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(getID(Path), ID);
+}
+
+TEST_F(FileSystemTest, ReplaceChangedFile)
+{
+    auto Path = getPath("a.inc");
+    std::string Error;
+
+    ASSERT_TRUE(util::fs::writeIfChanged(Path, "int a;\n", Error));
+    ASSERT_TRUE(util::fs::writeIfChanged(Path, "int b;\n", Error));
+    ASSERT_TRUE(util::fs::writeIfChanged(Path, "", Error));
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(readFile(Path), "");
+
+    /* No temporary files are left behind */
+    std::error_code Code;
+    size_t Count = 0;
+
+    for (auto It = llvm::sys::fs::directory_iterator(Directory_, Code);
+         !Code && It != llvm::sys::fs::directory_iterator();
+         It.increment(Code))
+        ++Count;
+
+    ASSERT_EQ(Count, 1u);
+}
+
+TEST_F(FileSystemTest, Error)
+{
+    auto Path = getPath("a.inc");
+    std::string Error;
+
+    ASSERT_TRUE(util::fs::writeIfChanged(Path, "int a;\n", Error));
+
+    /* A regular file cannot be used as a directory */
+    ASSERT_FALSE(util::fs::writeIfChanged(Path + "/b.inc", "", Error));
+    ASSERT_FALSE(Error.empty());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "TempDirectoryTest.hpp"
+#include "util/FileWatcher.hpp"
+
+namespace {
+
+constexpr auto Delay = std::chrono::milliseconds(10);
+
+using FileWatcherTest = TempDirectoryTest;
+
+} // namespace
+
+TEST_F(FileWatcherTest, Modify)
+{
+    auto Watcher = util::FileWatcher();
+    std::string Error;
+
+    auto A = writeFile("a.h", "int a;\n");
+    auto B = writeFile("b.h", "int b;\n");
+
+    Watcher.add(A, Error);
+    Watcher.add(B, Error);
+    ASSERT_TRUE(Error.empty());
+
+    writeFile("a.h", "int a, b;\n");
+    writeFile("c.h", "int c;\n");
+
+    auto Files = Watcher.wait(Delay, Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(Files, std::vector<std::string>{A});
+}
+
+TEST_F(FileWatcherTest, Burst)
+{
+    auto Watcher = util::FileWatcher();
+    std::string Error;
+
+    auto A = writeFile("a.h", "int a;\n");
+    auto B = writeFile("b.h", "int b;\n");
+
+    Watcher.add(A, Error);
+    Watcher.add(B, Error);
+    ASSERT_TRUE(Error.empty());
+
+    writeFile("b.h", "int b, c;\n");
+    writeFile("a.h", "int a, b;\n");
+    writeFile("b.h", "int b, d;\n");
+
+    auto Files = Watcher.wait(Delay, Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(Files, (std::vector<std::string>{A, B}));
+}
+
+TEST_F(FileWatcherTest, Replace)
+{
+    auto Watcher = util::FileWatcher();
+    std::string Error;
+
+    auto A = writeFile("a.h", "int a;\n");
+
+    Watcher.add(A, Error);
+    ASSERT_TRUE(Error.empty());
+
+    auto Tmp = writeFile("a.h.tmp", "int a, b;\n");
+    ASSERT_FALSE(llvm::sys::fs::rename(Tmp, A));
+
+    auto Files = Watcher.wait(Delay, Error);
+    ASSERT_TRUE(Error.empty());
+    ASSERT_EQ(Files, std::vector<std::string>{A});
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}
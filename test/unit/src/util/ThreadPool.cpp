@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2023  Steffen Nuessle
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+
+#include "util/ThreadPool.hpp"
+
+TEST(ThreadPool, Size)
+{
+    auto Pool = util::ThreadPool(4);
+
+    ASSERT_EQ(Pool.size(), 4u);
+    ASSERT_GE(util::ThreadPool(0).size(), 1u);
+}
+
+TEST(ThreadPool, Serial)
+{
+    auto Pool = util::ThreadPool(1);
+    auto Items = std::vector<size_t>{ 3, 1, 2 };
+    auto Order = std::vector<size_t>();
+
+    Pool.run(Items, [&](size_t Item, unsigned int Worker) {
+        ASSERT_EQ(Worker, 0u);
+        Order.push_back(Item);
+    });
+
+    ASSERT_EQ(Order, Items);
+}
+
+TEST(ThreadPool, Parallel)
+{
+    auto Pool = util::ThreadPool(8);
+    auto Items = std::vector<size_t>(1000);
+    auto Counts = std::vector<std::atomic<unsigned int>>(Items.size());
+    auto Workers = std::atomic<bool>(true);
+
+    std::iota(Items.begin(), Items.end(), 0);
+
+    Pool.run(Items, [&](size_t Item, unsigned int Worker) {
+        if (Worker >= Pool.size())
+            Workers = false;
+
+        ++Counts[Item];
+    });
+
+    ASSERT_TRUE(Workers);
+
+    for (const auto &Count : Counts)
+        ASSERT_EQ(Count, 1u);
+}
+
+TEST(ThreadPool, Empty)
+{
+    auto Pool = util::ThreadPool(8);
+    auto Calls = 0u;
+
+    Pool.run({}, [&](size_t, unsigned int) { ++Calls; });
+
+    ASSERT_EQ(Calls, 0u);
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    return RUN_ALL_TESTS();
+}